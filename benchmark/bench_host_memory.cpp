@@ -0,0 +1,109 @@
+//!
+//! bench_host_memory.cpp
+//! Measures the host to device and device to host bandwidth of BufferManager host buffers
+//! of each dtrCommon::HostMemoryType, for 3x224x224 and 3x375x500 float batches.
+//! Command: ./bench_host_memory [--batch=N] [--iterations=N]
+//!
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "common/buffers.h"
+
+namespace {
+struct BenchParams {
+	int batchSize{8};
+	int iterations{50};
+};
+
+const char* typeName(dtrCommon::HostMemoryType type) {
+	switch (type) {
+	case dtrCommon::HostMemoryType::kPAGEABLE: return "pageable";
+	case dtrCommon::HostMemoryType::kPINNED: return "pinned";
+	case dtrCommon::HostMemoryType::kWRITE_COMBINED: return "write-combined";
+	case dtrCommon::HostMemoryType::kMAPPED: return "mapped";
+	}
+	return "";
+}
+
+// GB/s of iterations asynchronous copies of size bytes on stream
+double bandwidth(void* dst, const void* src, size_t size, cudaMemcpyKind kind, cudaStream_t stream, int iterations) {
+	CHECK(cudaMemcpyAsync(dst, src, size, kind, stream));
+	CHECK(cudaStreamSynchronize(stream));
+	auto begin = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; ++i) {
+		CHECK(cudaMemcpyAsync(dst, src, size, kind, stream));
+	}
+	CHECK(cudaStreamSynchronize(stream));
+	double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin).count();
+	return size * static_cast<double>(iterations) / seconds / 1e9;
+}
+
+// how long the host is blocked issuing one copy: a pageable copy is staged before it returns
+double issueUs(void* dst, const void* src, size_t size, cudaMemcpyKind kind, cudaStream_t stream) {
+	auto begin = std::chrono::high_resolution_clock::now();
+	CHECK(cudaMemcpyAsync(dst, src, size, kind, stream));
+	double us = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - begin).count();
+	CHECK(cudaStreamSynchronize(stream));
+	return us;
+}
+
+void run(const BenchParams& params, int c, int h, int w, cudaStream_t stream) {
+	size_t size = static_cast<size_t>(params.batchSize) * c * h * w * sizeof(float);
+	dtrCommon::DeviceBuffer device(size);
+	for (auto type : {dtrCommon::HostMemoryType::kPAGEABLE, dtrCommon::HostMemoryType::kPINNED,
+		dtrCommon::HostMemoryType::kWRITE_COMBINED}) {
+		dtrCommon::HostBuffer host(size, dtrCommon::HostAllocator(type));
+		memset(host.data(), 0, size);
+		const char* got = dtrCommon::hostMemoryTypeOf(host.data()) == type ? "" : "  (fell back to pageable)";
+		double h2d = bandwidth(device.data(), host.data(), size, cudaMemcpyHostToDevice, stream, params.iterations);
+		double d2h = bandwidth(host.data(), device.data(), size, cudaMemcpyDeviceToHost, stream, params.iterations);
+		printf("%dx%dx%dx%d %-15s H2D %6.2lf GB/s  D2H %6.2lf GB/s  H2D issue %8.1lf us%s\n", params.batchSize, c, h, w,
+			typeName(type), h2d, d2h, issueUs(device.data(), host.data(), size, cudaMemcpyHostToDevice, stream), got);
+	}
+}
+
+bool parseArg(const char* arg, const char* name, std::string& value) {
+	size_t n = strlen(name);
+	bool match = arg[0] == '-' && arg[1] == '-' && !strncmp(arg + 2, name, n) && arg[n + 2] == '=';
+	if (match) {
+		value = arg + n + 3;
+	}
+	return match;
+}
+
+void printHelpInfo() {
+	printf("Usage: ./bench_host_memory [--batch=N] [--iterations=N]\n");
+	printf("  --batch       Samples per copy (default = 8)\n");
+	printf("  --iterations  Copies per measurement (default = 50)\n");
+}
+}
+
+int main(int argc, char** argv) {
+	BenchParams params;
+	for (int i = 1; i < argc; ++i) {
+		std::string value;
+		if (parseArg(argv[i], "batch", value)) {
+			params.batchSize = atoi(value.c_str());
+			continue;
+		}
+		if (parseArg(argv[i], "iterations", value)) {
+			params.iterations = atoi(value.c_str());
+			continue;
+		}
+		printHelpInfo();
+		return EXIT_FAILURE;
+	}
+	if (params.batchSize <= 0 || params.iterations <= 0) {
+		printHelpInfo();
+		return EXIT_FAILURE;
+	}
+	cudaStream_t stream;
+	CHECK(cudaStreamCreate(&stream));
+	run(params, 3, 224, 224, stream);
+	run(params, 3, 375, 500, stream);
+	CHECK(cudaStreamDestroy(stream));
+	return EXIT_SUCCESS;
+}
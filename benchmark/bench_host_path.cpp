@@ -0,0 +1,199 @@
+//!
+//! bench_host_path.cpp
+//! Measures the host-side cost of the CaffeModel inference paths: the allocating infer(),
+//! infer() into preallocated outputs, zero-copy slots and the inferAsync() pipeline.
+//! Built with BUILD_WITH_NVINFER_STUB it needs no GPU: the stub engine sleeps for --kernelUs
+//! per batch, and the overhead column is the wall time left once that latency is taken out.
+//! Command: ./bench_host_path [--plan=<engine file>] [--batch=N] [--contexts=N] [--iterations=N] [--kernelUs=N]
+//!
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "CaffeModel.h"
+#include "common/mappedFile.h"
+#ifdef DTR_NVINFER_STUB
+#include "StubRuntime.h"
+#endif
+
+namespace {
+struct BenchParams {
+	std::string plan;
+	std::string input{"data"};
+	std::string output{"prob"};
+	int batchSize{4};
+	int contexts{2};
+	int iterations{1000};
+	int kernelUs{0};
+};
+
+void report(const char* name, std::vector<double> us, double wallUs, int kernelUs) {
+	std::sort(us.begin(), us.end());
+	double mean = 0;
+	for (double v : us) {
+		mean += v;
+	}
+	mean /= us.size();
+	printf("%-16s mean %9.1lf us  p50 %9.1lf us  p99 %9.1lf us  overhead %8.1lf us  %9.1lf inferences/s\n", name,
+		mean, us[us.size() / 2], us[us.size() * 99 / 100], mean - kernelUs, us.size() * 1e6 / wallUs);
+}
+
+// times body once per iteration, after a few untimed rounds
+void measure(const char* name, const BenchParams& params, const std::function<bool()>& body) {
+	for (int i = 0; i < 10; ++i) {
+		body();
+	}
+	std::vector<double> us(params.iterations);
+	auto begin = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < params.iterations; ++i) {
+		auto start = std::chrono::high_resolution_clock::now();
+		if (!body()) {
+			printf("%-16s FAILED\n", name);
+			return;
+		}
+		us[i] = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+	report(name, us, std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - begin).count(), params.kernelUs);
+}
+
+// keeps params.contexts inferences in flight, the time of each is from issue to delivery
+void measureAsync(CaffeModel& model, const BenchParams& params, const std::vector<DataBlob32f>& inputs) {
+	std::vector<double> us;
+	std::deque<std::pair<std::chrono::high_resolution_clock::time_point, std::future<std::vector<DataBlob32f>>>> inflight;
+	auto begin = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < params.iterations || !inflight.empty(); ) {
+		if (i < params.iterations && static_cast<int>(inflight.size()) < params.contexts) {
+			inflight.emplace_back(std::chrono::high_resolution_clock::now(), model.inferAsync(inputs));
+			++i;
+			continue;
+		}
+		if (inflight.front().second.get().empty()) {
+			printf("%-16s FAILED\n", "inferAsync");
+			return;
+		}
+		us.push_back(std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - inflight.front().first).count());
+		inflight.pop_front();
+	}
+	report("inferAsync", us, std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - begin).count(), params.kernelUs);
+}
+
+bool parseArg(const char* arg, const char* name, std::string& value) {
+	size_t n = strlen(name);
+	bool match = arg[0] == '-' && arg[1] == '-' && !strncmp(arg + 2, name, n) && arg[n + 2] == '=';
+	if (match) {
+		value = arg + n + 3;
+	}
+	return match;
+}
+
+void printHelpInfo() {
+	printf("Usage: ./bench_host_path [--plan=<engine file>] [--batch=N] [--contexts=N] [--iterations=N] [--kernelUs=N]\n");
+	printf("  --plan        Serialized engine, the stub build uses a GoogLeNet shaped stub engine without it\n");
+	printf("  --input       Input tensor name (default = data)\n");
+	printf("  --output      Output tensor name (default = prob)\n");
+	printf("  --batch       Batch size of the model and of every inference (default = 4)\n");
+	printf("  --contexts    Execution contexts, also the inferAsync() depth (default = 2)\n");
+	printf("  --iterations  Timed inferences per path (default = 1000)\n");
+	printf("  --kernelUs    Simulated kernel latency of the stub engine (default = 0)\n");
+}
+}
+
+int main(int argc, char** argv) {
+	BenchParams params;
+	for (int i = 1; i < argc; ++i) {
+		std::string value;
+		if (parseArg(argv[i], "plan", params.plan) || parseArg(argv[i], "input", params.input)
+			|| parseArg(argv[i], "output", params.output)) {
+			continue;
+		}
+		if (parseArg(argv[i], "batch", value)) {
+			params.batchSize = atoi(value.c_str());
+			continue;
+		}
+		if (parseArg(argv[i], "contexts", value)) {
+			params.contexts = atoi(value.c_str());
+			continue;
+		}
+		if (parseArg(argv[i], "iterations", value)) {
+			params.iterations = atoi(value.c_str());
+			continue;
+		}
+		if (parseArg(argv[i], "kernelUs", value)) {
+			params.kernelUs = atoi(value.c_str());
+			continue;
+		}
+		printHelpInfo();
+		return EXIT_FAILURE;
+	}
+	if (params.batchSize <= 0 || params.contexts <= 0 || params.iterations <= 0) {
+		printHelpInfo();
+		return EXIT_FAILURE;
+	}
+
+	std::string plan;
+	if (!params.plan.empty()) {
+		dtrCommon::MappedFile file(params.plan);
+		if (!file) {
+			printf("could not read %s\n", params.plan.c_str());
+			return EXIT_FAILURE;
+		}
+		plan.assign(static_cast<const char*>(file.data()), file.size());
+	} else {
+#ifdef DTR_NVINFER_STUB
+		plan = dtrStub::makePlan({dtrStub::Binding(params.input, true, {3, 224, 224}),
+			dtrStub::Binding(params.output, false, {1000, 1, 1})}, params.batchSize);
+#else
+		printHelpInfo();
+		return EXIT_FAILURE;
+#endif
+	}
+#ifdef DTR_NVINFER_STUB
+	dtrStub::setKernelLatency(std::chrono::microseconds(params.kernelUs));
+#else
+	// the kernels take what they take on a real device
+	params.kernelUs = 0;
+#endif
+
+	dtrCommon::CaffeNNParams nnParams;
+	nnParams.batchSize = params.batchSize;
+	nnParams.nbExecutionContexts = params.contexts;
+	nnParams.inputTensorNames.push_back(params.input);
+	nnParams.outputTensorNames.push_back(params.output);
+	CaffeModel model(nnParams);
+	if (!model.build(plan.data(), plan.size())) {
+		printf("could not build the model\n");
+		return EXIT_FAILURE;
+	}
+	printf("batch %d, %d contexts, %d us kernel, startup: ", params.batchSize, params.contexts, params.kernelUs);
+	std::cout << model.startupProfile() << std::endl;
+
+	DataBlobShape shape = model.inputBlob(model.acquire(), 0).shape();
+	DataBlob32f input(params.batchSize, shape.channels(), shape.heights(), shape.widths());
+	memset(input.ptr(), 0, input.total_n_elem() * sizeof(float));
+	std::vector<DataBlob32f> inputs{input};
+	std::vector<DataBlob32f> outputs = model.infer(inputs);
+	if (outputs.empty()) {
+		printf("inference failed\n");
+		return EXIT_FAILURE;
+	}
+
+	measure("infer", params, [&]() { return !model.infer(inputs).empty(); });
+	measure("infer(outputs)", params, [&]() { return model.infer(inputs, outputs); });
+	measure("slot", params, [&]() {
+		CaffeModel::Slot slot = model.acquire();
+		DataBlob32f view = model.inputBlob(slot, 0);
+		memcpy(view.ptr(), input.ptr(), view.total_n_elem() * sizeof(float));
+		return model.infer(slot);
+	});
+	measureAsync(model, params, inputs);
+	model.teardown();
+	return EXIT_SUCCESS;
+}
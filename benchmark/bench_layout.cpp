@@ -0,0 +1,120 @@
+//!
+//! bench_layout.cpp
+//! Measures NCHW <-> NHWC conversion of float batches: a scalar reference loop against
+//! convertLayout() at each SIMD level the CPU has, and convertLayoutParallel().
+//! Command: ./bench_layout [--iterations=N] [--threads=N]
+//!
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "LayoutConvert.h"
+
+namespace {
+struct BenchParams {
+	int iterations{20};
+	size_t threads{0};
+};
+
+// the plain loop over the destination the kernels are compared with
+void reference(const float* src, BlobLayout from, float* dst, size_t n, size_t c, size_t h, size_t w) {
+	size_t pixels = h * w;
+	for (size_t i = 0; i < n; ++i) {
+		const float* s = src + i * c * pixels;
+		float* d = dst + i * c * pixels;
+		if (from == BlobLayout::kNCHW) {
+			for (size_t p = 0; p < pixels; ++p)
+				for (size_t k = 0; k < c; ++k)
+					d[p * c + k] = s[k * pixels + p];
+		} else {
+			for (size_t k = 0; k < c; ++k)
+				for (size_t p = 0; p < pixels; ++p)
+					d[k * pixels + p] = s[p * c + k];
+		}
+	}
+}
+
+// best ms of iterations runs
+double bestMs(const std::function<void()>& run, int iterations) {
+	run();
+	double best = 1e30;
+	for (int i = 0; i < iterations; ++i) {
+		auto begin = std::chrono::high_resolution_clock::now();
+		run();
+		best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count());
+	}
+	return best;
+}
+
+void run(const BenchParams& params, size_t n, size_t c, size_t h, size_t w) {
+	size_t count = n * c * h * w;
+	std::vector<float> src(count), dst(count), expected(count);
+	for (size_t i = 0; i < count; ++i) {
+		src[i] = static_cast<float>(i % 251);
+	}
+	for (BlobLayout from : {BlobLayout::kNHWC, BlobLayout::kNCHW}) {
+		BlobLayout to = from == BlobLayout::kNCHW ? BlobLayout::kNHWC : BlobLayout::kNCHW;
+		const char* name = from == BlobLayout::kNCHW ? "NCHW->NHWC" : "NHWC->NCHW";
+		double base = bestMs([&] { reference(src.data(), from, expected.data(), n, c, h, w); }, params.iterations);
+		// read and written once
+		double gb = 2.0 * count * sizeof(float) / 1e9;
+		printf("%zux%zux%zux%zu %s %-10s %8.3lf ms %6.2lf GB/s\n", n, c, h, w, name, "reference", base, gb / base * 1e3);
+		auto report = [&](const char* kernel, double ms) {
+			const char* ok = memcmp(dst.data(), expected.data(), count * sizeof(float)) ? "  MISMATCH" : "";
+			printf("%zux%zux%zux%zu %s %-10s %8.3lf ms %6.2lf GB/s %5.2lfx%s\n", n, c, h, w, name, kernel, ms, gb / ms * 1e3, base / ms, ok);
+		};
+		for (int level = 0; level <= static_cast<int>(dtrCommon::cpuSimdLevel()); ++level) {
+			auto simd = static_cast<dtrCommon::SimdLevel>(level);
+			double ms = bestMs([&] { convertLayout(src.data(), from, dst.data(), to, n, c, h, w, simd); }, params.iterations);
+			report(dtrCommon::simdLevelName(simd), ms);
+		}
+		double ms = bestMs([&] { convertLayoutParallel(src.data(), from, dst.data(), to, n, c, h, w, params.threads); }, params.iterations);
+		report("parallel", ms);
+	}
+}
+
+bool parseArg(const char* arg, const char* name, std::string& value) {
+	size_t n = strlen(name);
+	bool match = arg[0] == '-' && arg[1] == '-' && !strncmp(arg + 2, name, n) && arg[n + 2] == '=';
+	if (match) {
+		value = arg + n + 3;
+	}
+	return match;
+}
+
+void printHelpInfo() {
+	printf("Usage: ./bench_layout [--iterations=N] [--threads=N]\n");
+	printf("  --iterations  Runs per measurement, the best is reported (default = 20)\n");
+	printf("  --threads     Threads of the parallel conversion, 0 for all (default = 0)\n");
+}
+}
+
+int main(int argc, char** argv) {
+	BenchParams params;
+	for (int i = 1; i < argc; ++i) {
+		std::string value;
+		if (parseArg(argv[i], "iterations", value)) {
+			params.iterations = atoi(value.c_str());
+			continue;
+		}
+		if (parseArg(argv[i], "threads", value)) {
+			params.threads = static_cast<size_t>(atoi(value.c_str()));
+			continue;
+		}
+		printHelpInfo();
+		return EXIT_FAILURE;
+	}
+	if (params.iterations <= 0) {
+		printHelpInfo();
+		return EXIT_FAILURE;
+	}
+	// a batch of network inputs, a 1080p camera frame and a batch of feature maps
+	run(params, 8, 3, 224, 224);
+	run(params, 1, 3, 1080, 1920);
+	run(params, 8, 64, 56, 56);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+//!
+//! bench_plan_load.cpp
+//! Compares the startup cost of loading a serialized engine plan through ifstream into a
+//! std::vector with dtrCommon::MappedFile. Every run happens in a fresh child process, so
+//! the reported peak RSS belongs to one loader only.
+//! Command: ./bench_plan_load --plan=<engine file> [--iterations=N] [--noDeserialize]
+//!          ./bench_plan_load --synthetic=<MB> [--iterations=N]
+//! Drop the page cache before each run (echo 3 > /proc/sys/vm/drop_caches) to measure cold starts.
+//!
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "NvInfer.h"
+#include "common/logger.h"
+#include "common/mappedFile.h"
+
+namespace {
+struct BenchParams {
+	std::string plan;
+	int syntheticMB{0};
+	int iterations{3};
+	bool deserialize{true};
+};
+
+enum class Loader { kREAD, kMMAP, kMMAP_READAHEAD, kMMAP_POPULATE };
+
+const char* loaderName(Loader loader) {
+	switch (loader) {
+	case Loader::kREAD: return "ifstream";
+	case Loader::kMMAP: return "mmap";
+	case Loader::kMMAP_READAHEAD: return "mmap+readahead";
+	case Loader::kMMAP_POPULATE: return "mmap+populate";
+	}
+	return "";
+}
+
+volatile size_t gChecksum{0};
+
+// touch every page, the way deserialization would walk through the plan
+size_t touch(const void* data, size_t size) {
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	size_t sum = 0;
+	for (size_t i = 0; i < size; i += 4096) {
+		sum += bytes[i];
+	}
+	return sum;
+}
+
+bool consume(const BenchParams& params, const void* data, size_t size) {
+	if (!params.deserialize) {
+		gChecksum = touch(data, size);
+		return true;
+	}
+	nvinfer1::IRuntime* runtime = nvinfer1::createInferRuntime(gLogger.getTRTLogger());
+	nvinfer1::ICudaEngine* engine = runtime->deserializeCudaEngine(data, size, nullptr);
+	bool status = engine != nullptr;
+	if (engine) {
+		engine->destroy();
+	}
+	runtime->destroy();
+	return status;
+}
+
+bool load(const BenchParams& params, const std::string& path, Loader loader) {
+	if (loader == Loader::kREAD) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file.good()) {
+			return false;
+		}
+		file.seekg(0, file.end);
+		size_t size = file.tellg();
+		file.seekg(0, file.beg);
+		std::vector<char> plan(size);
+		file.read(plan.data(), size);
+		return consume(params, plan.data(), size);
+	}
+	dtrCommon::MappedFile::Prefetch prefetch = loader == Loader::kMMAP ? dtrCommon::MappedFile::Prefetch::kNONE
+		: loader == Loader::kMMAP_READAHEAD ? dtrCommon::MappedFile::Prefetch::kREADAHEAD
+		: dtrCommon::MappedFile::Prefetch::kPOPULATE;
+	dtrCommon::MappedFile plan(path, prefetch);
+	return plan && consume(params, plan.data(), plan.size());
+}
+
+// runs one load in a child process, the parent never initializes cuda
+bool run(const BenchParams& params, const std::string& path, Loader loader) {
+	pid_t pid = fork();
+	if (pid < 0) {
+		return false;
+	}
+	if (pid == 0) {
+		auto begin = std::chrono::high_resolution_clock::now();
+		bool status = load(params, path, loader);
+		auto end = std::chrono::high_resolution_clock::now();
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		printf("%-16s %10.2lf ms %10.1lf MB peak RSS%s\n", loaderName(loader),
+			std::chrono::duration<double, std::milli>(end - begin).count(), usage.ru_maxrss / 1024.0,
+			status ? "" : "  FAILED");
+		fflush(stdout);
+		_exit(status ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+	int status = 0;
+	waitpid(pid, &status, 0);
+	return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+std::string writeSynthetic(int megabytes) {
+	char path[] = "/tmp/bench_plan_load_XXXXXX";
+	int fd = mkstemp(path);
+	if (fd < 0) {
+		return {};
+	}
+	std::vector<unsigned int> chunk(1 << 18);
+	std::mt19937 rng(0);
+	for (int i = 0; i < megabytes; ++i) {
+		for (auto& v : chunk) {
+			v = rng();
+		}
+		if (write(fd, chunk.data(), 1 << 20) != (1 << 20)) {
+			close(fd);
+			unlink(path);
+			return {};
+		}
+	}
+	close(fd);
+	return path;
+}
+
+bool parseArg(const char* arg, const char* name, std::string& value) {
+	size_t n = strlen(name);
+	bool match = arg[0] == '-' && arg[1] == '-' && !strncmp(arg + 2, name, n) && arg[n + 2] == '=';
+	if (match) {
+		value = arg + n + 3;
+	}
+	return match;
+}
+
+void printHelpInfo() {
+	printf("Usage: ./bench_plan_load --plan=<engine file> [--iterations=N] [--noDeserialize]\n");
+	printf("       ./bench_plan_load --synthetic=<MB> [--iterations=N]\n");
+	printf("  --plan           Serialized engine, e.g. written by trtexec --saveEngine\n");
+	printf("  --synthetic      Load a temporary file of random bytes instead, implies --noDeserialize\n");
+	printf("  --iterations     Runs per loader (default = 3)\n");
+	printf("  --noDeserialize  Only fault the plan pages in, without deserializing the engine\n");
+}
+}
+
+int main(int argc, char** argv) {
+	BenchParams params;
+	for (int i = 1; i < argc; ++i) {
+		std::string value;
+		if (parseArg(argv[i], "plan", params.plan)) {
+			continue;
+		}
+		if (parseArg(argv[i], "synthetic", value)) {
+			params.syntheticMB = atoi(value.c_str());
+			params.deserialize = false;
+			continue;
+		}
+		if (parseArg(argv[i], "iterations", value)) {
+			params.iterations = atoi(value.c_str());
+			continue;
+		}
+		if (!strcmp(argv[i], "--noDeserialize")) {
+			params.deserialize = false;
+			continue;
+		}
+		printHelpInfo();
+		return EXIT_FAILURE;
+	}
+	std::string path = params.plan;
+	if (params.syntheticMB > 0) {
+		path = writeSynthetic(params.syntheticMB);
+	}
+	if (path.empty()) {
+		printHelpInfo();
+		return EXIT_FAILURE;
+	}
+
+	bool status = true;
+	for (Loader loader : {Loader::kREAD, Loader::kMMAP, Loader::kMMAP_READAHEAD, Loader::kMMAP_POPULATE}) {
+		for (int i = 0; i < params.iterations; ++i) {
+			status = run(params, path, loader) && status;
+		}
+	}
+	if (params.syntheticMB > 0) {
+		unlink(path.c_str());
+	}
+	return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
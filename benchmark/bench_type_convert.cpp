@@ -0,0 +1,122 @@
+//!
+//! bench_type_convert.cpp
+//! Measures the bulk conversions of common/typeConvert.h at each SIMD level the CPU has against
+//! the scalar loops they replaced: half_float for fp16 and plain casts for int8.
+//! Command: ./bench_type_convert [--iterations=N] [--count=N]
+//!
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "common/half.h"
+#include "common/typeConvert.h"
+
+namespace {
+struct BenchParams {
+	int iterations{20};
+	size_t count{8 * 3 * 224 * 224};
+};
+
+// best ms of iterations runs
+double bestMs(const std::function<void()>& run, int iterations) {
+	run();
+	double best = 1e30;
+	for (int i = 0; i < iterations; ++i) {
+		auto begin = std::chrono::high_resolution_clock::now();
+		run();
+		best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count());
+	}
+	return best;
+}
+
+// times reference and the kernel at every level, bytes moved per element for the bandwidth
+void run(const BenchParams& params, const char* name, size_t bytes, const std::function<void()>& reference,
+	const std::function<void(dtrCommon::SimdLevel)>& kernel) {
+	double gb = static_cast<double>(bytes) * params.count / 1e9;
+	double base = bestMs(reference, params.iterations);
+	printf("%-14s %-10s %8.3lf ms %6.2lf GB/s\n", name, "reference", base, gb / base * 1e3);
+	for (int level = 0; level <= static_cast<int>(dtrCommon::cpuSimdLevel()); ++level) {
+		auto simd = static_cast<dtrCommon::SimdLevel>(level);
+		double ms = bestMs([&] { kernel(simd); }, params.iterations);
+		printf("%-14s %-10s %8.3lf ms %6.2lf GB/s %5.2lfx\n", name, dtrCommon::simdLevelName(simd), ms, gb / ms * 1e3, base / ms);
+	}
+}
+
+bool parseArg(const char* arg, const char* name, std::string& value) {
+	size_t n = strlen(name);
+	bool match = arg[0] == '-' && arg[1] == '-' && !strncmp(arg + 2, name, n) && arg[n + 2] == '=';
+	if (match) {
+		value = arg + n + 3;
+	}
+	return match;
+}
+
+void printHelpInfo() {
+	printf("Usage: ./bench_type_convert [--iterations=N] [--count=N]\n");
+	printf("  --iterations  Runs per measurement, the best is reported (default = 20)\n");
+	printf("  --count       Elements converted per run (default = 1204224, a batch of 8x3x224x224)\n");
+}
+}
+
+int main(int argc, char** argv) {
+	BenchParams params;
+	for (int i = 1; i < argc; ++i) {
+		std::string value;
+		if (parseArg(argv[i], "iterations", value)) {
+			params.iterations = atoi(value.c_str());
+			continue;
+		}
+		if (parseArg(argv[i], "count", value)) {
+			params.count = static_cast<size_t>(atol(value.c_str()));
+			continue;
+		}
+		printHelpInfo();
+		return EXIT_FAILURE;
+	}
+	if (params.iterations <= 0 || params.count == 0) {
+		printHelpInfo();
+		return EXIT_FAILURE;
+	}
+	size_t count = params.count;
+	std::vector<float> floats(count), restored(count);
+	std::vector<uint16_t> halves(count);
+	std::vector<int8_t> bytes(count);
+	for (size_t i = 0; i < count; ++i) {
+		floats[i] = std::sin(static_cast<float>(i)) * 100.0f;
+	}
+	dtrCommon::floatToHalf(floats.data(), halves.data(), count);
+	dtrCommon::quantize(floats.data(), bytes.data(), count, 1.0f);
+
+	run(params, "fp16->fp32", sizeof(uint16_t) + sizeof(float),
+		[&] {
+			const half_float::half* src = reinterpret_cast<const half_float::half*>(halves.data());
+			for (size_t i = 0; i < count; ++i)
+				restored[i] = static_cast<float>(src[i]);
+		},
+		[&](dtrCommon::SimdLevel level) { dtrCommon::halfToFloat(halves.data(), restored.data(), count, level); });
+	run(params, "fp32->fp16", sizeof(float) + sizeof(uint16_t),
+		[&] {
+			half_float::half* dst = reinterpret_cast<half_float::half*>(halves.data());
+			for (size_t i = 0; i < count; ++i)
+				dst[i] = half_float::half(floats[i]);
+		},
+		[&](dtrCommon::SimdLevel level) { dtrCommon::floatToHalf(floats.data(), halves.data(), count, level); });
+	run(params, "int8->fp32", sizeof(int8_t) + sizeof(float),
+		[&] {
+			for (size_t i = 0; i < count; ++i)
+				restored[i] = static_cast<float>(bytes[i]);
+		},
+		[&](dtrCommon::SimdLevel level) { dtrCommon::dequantize(bytes.data(), restored.data(), count, 1.0f, 0, level); });
+	run(params, "fp32->int8", sizeof(float) + sizeof(int8_t),
+		[&] {
+			for (size_t i = 0; i < count; ++i)
+				bytes[i] = static_cast<int8_t>(std::min(std::max(std::nearbyint(floats[i] * 0.5f), -128.0f), 127.0f));
+		},
+		[&](dtrCommon::SimdLevel level) { dtrCommon::quantize(floats.data(), bytes.data(), count, 2.0f, 0, level); });
+	return EXIT_SUCCESS;
+}
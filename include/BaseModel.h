@@ -23,6 +23,11 @@ public:
     //!
     virtual std::vector<DataBlob32f > infer(const std::vector<DataBlob32f >& input_blobs) = 0;
 
+    //!
+    //! \brief Returns the shape of one sample of every input, empty if the model does not know them
+    //!
+    virtual std::vector<DataBlobShape> inputShapes() { return {}; }
+
     //!
     //! \brief This function can be used to clean up any state created in the sample class
     //!
@@ -1,8 +1,16 @@
 #ifndef DEPLOY_CAFFEMODEL_H_
 #define DEPLOY_CAFFEMODEL_H_
 #include <vector>
+#include <deque>
+#include <functional>
+#include <future>
 #include <map>
+#include <mutex>
+#include <thread>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ostream>
 #include <NvCaffeParser.h>
 #include <NvInfer.h>
 #include <NvInferPlugin.h>
@@ -13,33 +21,196 @@
 #include <common/argsParser.h>
 #include <BaseModel.h>
 #include <DataBlob.h>
+#include <EngineCache.h>
+#include <ExecutionContextPool.h>
 
 typedef enum nn_model_t {
 	DTR_CAFFE = (0x1 << 0),
 	DTR_GIE = (0x1 << 1),
 } nn_model_t;
 
+//!
+//! \brief Milliseconds spent in each phase of CaffeModel::build().
+//!        The phases a build does not go through stay 0.
+//!
+struct StartupProfile {
+	double fileReadMs{0};        //!< Mapping the plan, or hashing the network files for the engine cache
+	double parseMs{0};           //!< Parsing the prototxt and weights into a network
+	double buildMs{0};           //!< Building the engine from the network
+	double serializeMs{0};       //!< Serializing the built engine into the engine cache
+	double deserializeMs{0};     //!< Deserializing the plan or the cached engine
+	double contextCreationMs{0}; //!< Execution contexts, cuda streams and binding buffers
+	double firstInferenceMs{0};  //!< First warmup batch, it pays for the lazy kernel and cudnn initialization
+	double warmupMs{0};          //!< All warmup batches, the first one included
+	int warmupIterations{0};     //!< Warmup rounds, each runs one batch of zeros on every execution slot
+	bool engineCacheHit{false};
+	double totalMs{0};
+};
+std::ostream& operator<<(std::ostream& out, const StartupProfile& value);
+
+//!
+//! \brief Runs a caffe network (or a serialized GIE plan) with TensorRT.
+//!
+//! \details infer() may be called from several threads at once: each call checks out
+//!          one of mParams.nbExecutionContexts execution slots sharing the engine.
+//!          build() and reset() must not run concurrently with infer(), reload() may.
+//!          build() runs mParams.warmupIterations rounds of zero batches on every slot before isReady(),
+//!          startupProfile() tells where the time of the last build() went.
+//!
+//!          The input blobs may hold any number of samples N. Batches smaller than
+//!          mParams.batchSize run and copy only N samples, larger ones are split into
+//!          mParams.batchSize chunks pipelined over the execution slots. The outputs hold N samples.
+//!
 class CaffeModel : public IBaseModel {
 	template <typename T>
 	using UniquePtr = std::unique_ptr<T, dtrCommon::DtrInferDeleter>;
 
 public:
 	typedef std::array<int, 4> shape_t;
+	typedef ExecutionContextPool::Lease Slot;
+	typedef std::function<void(std::vector<DataBlob32f>)> InferCallback;
 	CaffeModel(const dtrCommon::CaffeNNParams& params)
 		: mParams(params), gInputDimensions({})
 	{ }
+	~CaffeModel() { reset(); }
 	bool build(bool is_caffe); 
 	bool build();
+	//!
+	//! \brief Builds the model from a serialized plan held in memory, see serializeEngine().
+	//!
+	bool build(const void* plan, size_t size);
+	//!
+	//! \brief Serializes the engine into plan. Returns false if the model is not built.
+	//!
+	bool serializeEngine(std::vector<char>& plan);
+	//!
+	//! \brief Swaps in a new engine while infer() keeps running.
+	//!
+	//! \details params names the new plan, or the new prototxt and weights with is_caffe, and
+	//!          must give an engine with the same bindings. The engine and its execution slots
+	//!          are built and warmed up on the calling thread, then published at once: inferences
+	//!          that start afterwards run on them, the ones in flight finish on the old engine.
+	//!          reload() returns once every slot of the old engine is back, which is then
+	//!          released, on the calling thread unless a request still holds it. Returns false and
+	//!          keeps serving the old engine if the new one can not be built or does not match.
+	//!
+	bool reload(const dtrCommon::CaffeNNParams& params, bool is_caffe);
+	std::future<bool> reloadAsync(const dtrCommon::CaffeNNParams& params, bool is_caffe);
+	//!
+	//! \brief Releases the engine along with the execution state, build() brings it back.
+	//!
+	void release();
+	//!
+	//! \brief Returns true while the model holds an engine, safe to call during reload().
+	//!
+	bool isBuilt() const;
+	//!
+	//! \brief Returns true once build() has succeeded and the warmup batches have run.
+	//!
+	bool isReady() const { return mReady; }
+	//!
+	//! \brief Returns the phases of the last build(), or of the build of the engine the last reload() swapped in.
+	//!
+	StartupProfile startupProfile() const;
+	//!
+	//! \brief Returns the device memory of the execution contexts and binding buffers in bytes.
+	//!        The engine weights are not included, TensorRT does not report them.
+	//!
+	size_t deviceMemorySize();
 	shape_t getInputDimension(int index = 0);
 	std::vector<DataBlob32f> infer(const std::vector<DataBlob32f>& input_blobs, bool use_cudastream);
 	std::vector<DataBlob32f> infer(const std::vector<DataBlob32f>& input_blobs);
+	//!
+	//! \brief Returns the shape of one sample of every input binding in the order infer() takes
+	//!        them, empty until the model is built. Safe to call during reload().
+	//!
+	std::vector<DataBlobShape> inputShapes();
+	//!
+	//! \brief Runs the network and writes the outputs into output_blobs instead of allocating them.
+	//!        output_blobs must be shaped like the outputs, with as many samples as the inputs.
+	//!
+	bool infer(const std::vector<DataBlob32f>& input_blobs, std::vector<DataBlob32f>& output_blobs);
+	//!
+	//! \brief Runs the network and returns only the outputs named in output_names, in that order.
+	//!        Any output binding of the engine may be named. The other outputs are not copied back.
+	//!
+	std::vector<DataBlob32f> infer(const std::vector<DataBlob32f>& input_blobs, const std::vector<std::string>& output_names);
+
+	//!
+	//! \brief Zero-copy inference: check out a slot, fill the views returned by inputBlob(),
+	//!        run infer(slot) and read the views returned by outputBlob().
+	//!        The views alias the slot buffers and are only valid while the slot is held.
+	//!
+	Slot acquire();
+	DataBlob32f inputBlob(const Slot& slot, size_t index);
+	DataBlob32f outputBlob(const Slot& slot, size_t index);
+	bool infer(const Slot& slot, bool use_cudastream = true);
+
+	//!
+	//! \brief Issues the inference without waiting for it. The outputs are delivered through
+	//!        the future, or passed to done on the completion thread (empty on failure).
+	//!
+	//! \details Each call takes its own execution slot, so with mParams.nbExecutionContexts of
+	//!          2 or 3 the input copy of request N+1, the compute of request N and the output
+	//!          copy and conversion of request N-1 overlap. Blocks only while all slots are busy.
+	//!
+	std::future<std::vector<DataBlob32f>> inferAsync(const std::vector<DataBlob32f>& input_blobs);
+	bool inferAsync(const std::vector<DataBlob32f>& input_blobs, InferCallback done);
+	//!
+	//! \brief Releases the execution contexts, cuda streams and binding buffers.
+	//!        They are created again by the next infer().
+	//!
+	void reset();
 	bool teardown();
 	dtrCommon::CaffeNNParams mParams;
 private:
 	shape_t convertToShape(nvinfer1::Dims3& dims) { return {1, dims.d[0], dims.d[1], dims.d[2]};}
-	DataBlob32f getDataBlobFromBuffer(dtrCommon::BufferManager & buffer, std::string& tensorname);
+	bool buildEngine(bool is_caffe);
+	bool finishBuild(bool status, std::chrono::high_resolution_clock::time_point begin);
+	bool warmup();
+	bool deserializeEngine(const void* data, size_t size);
+	bool engineCacheKey(EngineKey& key);
+	void recordInputs();
+	bool setupExecution();
+	std::shared_ptr<ExecutionContextPool> executionPool();
+	std::shared_ptr<nvinfer1::ICudaEngine> currentEngine() const;
+	//! one chunk of at most mParams.batchSize samples issued by inferAsync()
+	struct PendingInference {
+		Slot slot;
+		size_t offset{0};                 //!< first sample of the chunk in inputs and outputs
+		size_t count{0};                  //!< number of samples in the chunk
+		std::vector<DataBlob32f> outputs; //!< the chunk is converted into samples [offset, offset + count)
+		std::function<void(bool)> done;
+	};
+	size_t batchOf(const ExecutionContextPool& pool, const std::vector<DataBlob32f>& input_blobs);
+	bool outputBindingsOf(const nvinfer1::ICudaEngine& engine, const std::vector<std::string>& output_names, std::vector<int>& bindings);
+	std::vector<DataBlob32f> allocateOutputs(const nvinfer1::ICudaEngine& engine, const std::vector<int>& bindings, size_t batchSize);
+	bool run(ExecutionContextPool& pool, const std::vector<DataBlob32f>& input_blobs, size_t total,
+		const std::vector<int>& outputs, std::vector<DataBlob32f>& output_blobs, bool use_cudastream);
+	bool submit(ExecutionContextPool& pool, const std::vector<DataBlob32f>& input_blobs, const std::vector<DataBlob32f>& output_blobs,
+		size_t offset, size_t count, std::function<void(bool)> done);
+	bool copyInputs(const Slot& slot, const std::vector<DataBlob32f>& input_blobs, size_t offset, size_t count);
+	bool enqueue(ExecutionSlot& slot, int batchSize, bool use_cudastream, const std::vector<int>& outputs);
+	bool execute(ExecutionSlot& slot, int batchSize, bool use_cudastream, const std::vector<int>& outputs);
+	void completionLoop(int device);
+	void stopCompletionThread();
+	DataBlob32f bindingView(const Slot& slot, int index);
+	void copyFromBuffer(const nvinfer1::ICudaEngine& engine, dtrCommon::BufferManager& buffers, int index, DataBlob32f& dst, size_t offset, size_t count);
 	std::map<std::string, shape_t> gInputDimensions;
 	std::shared_ptr<nvinfer1::ICudaEngine> mEngine = nullptr; //!< The TensorRT engine used to run the network
+	// execution state reused by every infer(), created by setupExecution(). The binding
+	// indices of the inputs and outputs live in the pool, so reload() swaps them along.
+	std::shared_ptr<ExecutionContextPool> mPool{nullptr};
+	mutable std::mutex mPoolMutex; //!< guards mPool, mEngine, gInputDimensions and mProfile against reload()
+	std::mutex mReloadMutex; //!< one reload() at a time
+	std::atomic<bool> mReady{false};
+	StartupProfile mProfile;
+	// inferences issued by inferAsync() waiting for their completion
+	std::deque<PendingInference> mCompletions;
+	std::mutex mCompletionMutex;
+	std::condition_variable mCompletionReady;
+	std::thread mCompletionThread;
+	bool mStopCompletion{false};
 	void constructNetwork(UniquePtr<nvinfer1::IBuilder>& builder, UniquePtr<nvinfer1::INetworkDefinition>& network, UniquePtr<nvcaffeparser1::ICaffeParser>& parser);
 	// for Int8Mode
 	void setLayerPrecision(UniquePtr<nvinfer1::INetworkDefinition>& network);
@@ -1,6 +1,7 @@
 #ifndef DEPLOY_INCLUDE_DataBlob_H_
 #define DEPLOY_INCLUDE_DataBlob_H_
 #include <utility>
+#include <functional>
 #include <memory>
 #include <iostream>
 class Size {
@@ -38,6 +39,60 @@ private:
 	size_t m_channel;
 };
 
+//!
+//! \brief Where the storage of a DataBlob comes from.
+//!
+//! \details Page-locked blobs are copied to and from the device by DMA, without the driver
+//!          staging them, so preprocessing can fill a blob the engine reads directly.
+//!          Huge-page blobs are 2 MB aligned and backed by transparent huge pages where the
+//!          kernel has them, which saves TLB misses on large batches. Both these and the
+//!          aligned blobs come from dtrCommon::HostArena::instance().
+//!
+enum class BlobMemory {
+	kHEAP,       //!< new T[]
+	kALIGNED,    //!< 64 byte aligned, a cache line and an AVX-512 vector
+	kPINNED,     //!< page-locked, 64 byte aligned heap memory if that fails
+	kHUGE_PAGES, //!< 2 MB aligned, advised to use huge pages
+	kEXTERNAL    //!< from a BlobAllocator or the caller
+};
+
+//!
+//! \brief How the storage of a new DataBlob is initialized.
+//!
+//! \details Most blobs are overwritten at once, with preprocessed pixels or converted
+//!          outputs, so zeroing them is a wasted pass over memory. kLAZY_ZEROED takes heap
+//!          and aligned storage of fresh pages, which the kernel zeroes on first touch,
+//!          and falls back to memset for the other sources and for recycled storage.
+//!
+enum class BlobInit {
+	kZEROED,        //!< memset after allocation
+	kLAZY_ZEROED,   //!< zero without a pass over memory where the source allows it
+	kUNINITIALIZED  //!< left as allocated, for blobs the caller overwrites entirely
+};
+
+//!
+//! \brief The order of the elements of a DataBlob sample.
+//!
+//! \details Engines take planar kNCHW inputs, cameras and decoders produce interleaved kNHWC
+//!          frames. Copies between blobs of different layouts convert them, see LayoutConvert.h.
+//!
+enum class BlobLayout {
+	kNCHW, //!< a plane per channel, the rows of a plane are contiguous
+	kNHWC  //!< the channels of a pixel are contiguous
+};
+
+//!
+//! \brief Returns bytes bytes of storage, released by the deleter of the pointer, or nullptr.
+//!
+//! \details Arenas and pools plug in through it. The storage must be aligned for any T.
+//!
+using BlobAllocator = std::function<std::shared_ptr<void>(size_t bytes)>;
+
+//!
+//! \brief Returns the allocator of memory, nullptr for kEXTERNAL.
+//!
+BlobAllocator blobAllocator(BlobMemory memory);
+
 template <typename T>
 class DataBlob {
 private:
@@ -45,18 +100,34 @@ private:
 	size_t m_channel;
 	size_t m_height;
 	size_t m_width;
-	size_t m_step;
+	size_t m_step;        // elements between rows
+	size_t m_pixel_step;  // elements between the pixels of a row
+	size_t m_plane_step;  // elements between channels
+	size_t m_sample_step; // elements between samples
 	std::shared_ptr<T> m_data;
 	size_t m_offset;
+	BlobMemory m_memory;
+	BlobLayout m_layout;
+	void allocate(const BlobAllocator &allocator, BlobInit init);
+	void reset_steps();
+	DataBlob<T> view(size_t n, size_t c, size_t h, size_t w, size_t offset) const;
 	T *raw_ptr() { return m_data.get() + m_offset; }
 	const T *raw_ptr() const { return m_data.get() + m_offset; }
 public:
 	DataBlob();
 	DataBlob(size_t num, size_t channel, size_t height, size_t width);
 	DataBlob(DataBlobShape shape);
+	// storage of memory, shared by the copies like that of the other constructors
+	DataBlob(size_t num, size_t channel, size_t height, size_t width, BlobMemory memory,
+		BlobInit init = BlobInit::kZEROED, BlobLayout layout = BlobLayout::kNCHW);
+	DataBlob(DataBlobShape shape, BlobMemory memory, BlobInit init = BlobInit::kZEROED, BlobLayout layout = BlobLayout::kNCHW);
+	// storage from allocator, memory() is kEXTERNAL; kLAZY_ZEROED storage is memset
+	DataBlob(size_t num, size_t channel, size_t height, size_t width, const BlobAllocator &allocator,
+		BlobInit init = BlobInit::kZEROED, BlobLayout layout = BlobLayout::kNCHW);
+	DataBlob(DataBlobShape shape, const BlobAllocator &allocator, BlobInit init = BlobInit::kZEROED, BlobLayout layout = BlobLayout::kNCHW);
 	// do not try to manage data by shared_ptr
-	DataBlob(size_t num, size_t channel, size_t height, size_t width, T *data);
-	DataBlob(DataBlobShape shape, T *data);
+	DataBlob(size_t num, size_t channel, size_t height, size_t width, T *data, BlobLayout layout = BlobLayout::kNCHW);
+	DataBlob(DataBlobShape shape, T *data, BlobLayout layout = BlobLayout::kNCHW);
 	// shallow-copy constructor
 	DataBlob(const DataBlob<T> &rhs);
 	DataBlob<T> &operator=(const DataBlob<T> &rhs);
@@ -64,27 +135,57 @@ public:
 	T &at(size_t n, size_t c, size_t h, size_t w);
 	const T &at(size_t n, size_t c, size_t h, size_t w) const;
 
+	// unchecked: row h of channel c of sample n, whose elements are pixel_step() apart
+	T *row(size_t n, size_t c, size_t h) { return raw_ptr() + n * m_sample_step + c * m_plane_step + h * m_step; }
+	const T *row(size_t n, size_t c, size_t h) const { return raw_ptr() + n * m_sample_step + c * m_plane_step + h * m_step; }
+	// unchecked: channel c of sample n, whose rows are step() apart
+	T *plane(size_t n, size_t c) { return raw_ptr() + n * m_sample_step + c * m_plane_step; }
+	const T *plane(size_t n, size_t c) const { return raw_ptr() + n * m_sample_step + c * m_plane_step; }
+
+	// views sharing the storage of the blob, they throw std::out_of_range
+	// samples [begin, end)
+	DataBlob<T> slice_batch(size_t begin, size_t end) const;
+	// channels [begin, end) of every sample
+	DataBlob<T> slice_channels(size_t begin, size_t end) const;
+	// the height x width rectangle at (top, left) of every channel
+	DataBlob<T> roi(size_t top, size_t left, size_t height, size_t width) const;
+
+	// contiguous deep copy
 	DataBlob<T> clone() const;
+	// deep copy into storage of memory, which is not kEXTERNAL
+	DataBlob<T> clone(BlobMemory memory) const;
+	// contiguous deep copy in layout
+	DataBlob<T> to_layout(BlobLayout layout, BlobMemory memory = BlobMemory::kHEAP) const;
+	// copies the elements into dst of the same shape, converting the layout; either may be a view
+	void copy_to(DataBlob<T> &dst) const;
 
-	// read data from src
+	// read data from contiguous src of the layout of the blob
 	void read(const T *src);
-	// write data to dst
+	// write data to contiguous dst in the layout of the blob
 	void write(T *dst) const;
 
+	// sample i, whose elements are contiguous if is_continuous()
 	const T *ptr(size_t i = 0) const {
-		return raw_ptr() + i* inst_n_elem();
+		return raw_ptr() + i * m_sample_step;
 	}
 	T *ptr(size_t r = 0) {
-		return raw_ptr() + r * inst_n_elem();
+		return raw_ptr() + r * m_sample_step;
 	}
 	size_t nums() const { return m_num; }
 	size_t channels() const { return m_channel; }
 	size_t heights() const { return m_height; }
 	size_t widths() const { return m_width;}
 	size_t step() const { return m_step; }
+	size_t pixel_step() const { return m_pixel_step; }
+	size_t plane_step() const { return m_plane_step; }
+	size_t sample_step() const { return m_sample_step; }
+	BlobMemory memory() const { return m_memory; }
+	BlobLayout layout() const { return m_layout; }
 	size_t inst_n_elem() const {return heights() * widths() * channels();}
 	size_t total_n_elem() const {return nums() * inst_n_elem();}
+	// same shape and elements, the strides may differ
 	bool equals(const DataBlob<T> &rhs) const;
+	// whether the elements are laid out without gaps in layout()
 	bool is_continuous() const;
 	Size size() const { return {heights(), widths()}; }
 	DataBlobShape shape() const { return {nums(), channels(), heights(), widths()}; }
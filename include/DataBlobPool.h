@@ -0,0 +1,74 @@
+#ifndef DEPLOY_INCLUDE_DATABLOBPOOL_H_
+#define DEPLOY_INCLUDE_DATABLOBPOOL_H_
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <tuple>
+#include <typeindex>
+#include <vector>
+
+#include <DataBlob.h>
+
+struct DataBlobPoolStats {
+	size_t hits{0};         //!< Blobs given recycled storage
+	size_t misses{0};       //!< Blobs whose storage came from the allocator
+	size_t recycled{0};     //!< Storage returned to the pool by its last blob
+	size_t releases{0};     //!< Storage given back to the allocator, past the cap or by trim()
+	size_t bytesCached{0};
+	size_t blocksCached{0};
+	double hitRate() const { return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+};
+std::ostream& operator<<(std::ostream& out, const DataBlobPoolStats& value);
+
+//!
+//! \brief Recycles the storage of DataBlobs by shape and element type.
+//!
+//! \details acquire() hands out the storage of a released blob of the same shape and type
+//!          if there is one, and new storage of the BlobMemory of the pool otherwise. The
+//!          storage goes back to the pool when the last copy of the blob is destroyed, so
+//!          the blobs of a request path are reused without the callers knowing. Blobs may
+//!          outlive the pool, their storage is then given back to the allocator.
+//!          Storage past maxCachedBytes is given back at once. The blobs report kEXTERNAL.
+//!
+class DataBlobPool {
+public:
+	explicit DataBlobPool(BlobMemory memory = BlobMemory::kALIGNED, size_t maxCachedBytes = 256 << 20);
+	DataBlobPool(const DataBlobPool&) = delete;
+	DataBlobPool& operator=(const DataBlobPool&) = delete;
+	~DataBlobPool() { trim(); }
+	//!
+	//! \brief The pool of the blobs allocated by CaffeModel and DynamicBatcher.
+	//!
+	static DataBlobPool& instance();
+	//!
+	//! \brief Returns a blob of shape. Throws std::bad_alloc if it can not be allocated.
+	//!
+	//! \details A kUNINITIALIZED blob holds whatever its last user left in it.
+	//!
+	template <typename T>
+	DataBlob<T> acquire(const DataBlobShape& shape, BlobInit init = BlobInit::kZEROED) {
+		Key key(std::type_index(typeid(T)), shape.nums(), shape.channels(), shape.heights(), shape.widths());
+		return DataBlob<T>(shape, [this, &key](size_t bytes) { return take(key, bytes); }, init);
+	}
+	//!
+	//! \brief Gives back all the cached storage. Returns the number of bytes released.
+	//!
+	size_t trim();
+	void setMaxCachedBytes(size_t bytes);
+	DataBlobPoolStats stats() const;
+private:
+	using Key = std::tuple<std::type_index, size_t, size_t, size_t, size_t>;
+	//! shared with the deleters of the storage handed out, which may outlive the pool
+	struct State {
+		std::mutex mutex;
+		std::map<Key, std::vector<std::shared_ptr<void>>> lists;
+		DataBlobPoolStats stats;
+		size_t maxCachedBytes;
+	};
+	std::shared_ptr<void> take(const Key& key, size_t bytes);
+	static void recycle(const std::weak_ptr<State>& state, const Key& key, size_t bytes, const std::shared_ptr<void>& storage);
+	BlobAllocator mAllocator;
+	std::shared_ptr<State> mState;
+};
+#endif
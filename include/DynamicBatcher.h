@@ -0,0 +1,93 @@
+#ifndef DEPLOY_INCLUDE_DYNAMICBATCHER_H_
+#define DEPLOY_INCLUDE_DYNAMICBATCHER_H_
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <BaseModel.h>
+#include <DataBlob.h>
+
+//!
+//! \brief A histogram over fixed bucket upper bounds, the last bucket takes everything above.
+//!
+class Histogram {
+public:
+	Histogram() = default;
+	explicit Histogram(std::vector<double> upperBounds);
+	//! \brief Buckets 1, 2, ..., n
+	static Histogram linear(size_t n);
+	//! \brief Buckets 1, 2, 4, ..., 2^(n-1)
+	static Histogram exponential(size_t n);
+
+	void add(double value);
+	const std::vector<double>& upperBounds() const { return mUpperBounds; }
+	//! \brief counts()[i] is the number of values in (upperBounds()[i-1], upperBounds()[i]], plus one overflow bucket.
+	const std::vector<size_t>& counts() const { return mCounts; }
+	size_t total() const { return mTotal; }
+	double mean() const { return mTotal ? mSum / mTotal : 0.0; }
+	friend std::ostream& operator<<(std::ostream& out, const Histogram& value);
+private:
+	std::vector<double> mUpperBounds;
+	std::vector<size_t> mCounts = std::vector<size_t>(1, 0);
+	size_t mTotal{0};
+	double mSum{0.0};
+};
+
+struct DynamicBatcherParams {
+	int maxBatchSize{1};                            //!< Largest batch handed to the model, usually NNParams::batchSize
+	std::chrono::microseconds maxDelay{1000};       //!< Longest time a request waits for the batch to fill
+	int nbWorkers{1};                               //!< Batches in flight at once, match NNParams::nbExecutionContexts
+	bool padBatch{false};                           //!< Pad partial batches to maxBatchSize, CaffeModel runs any batch size
+};
+
+struct DynamicBatcherStats {
+	Histogram batchSize;     //!< Samples per model infer()
+	Histogram queueDelayUs;  //!< Time from submit() until the batch was formed, in microseconds
+	size_t failedBatches{0};
+};
+std::ostream& operator<<(std::ostream& out, const DynamicBatcherStats& value);
+
+//!
+//! \brief Groups single-sample requests into batches for an IBaseModel.
+//!
+//! \details submit() queues one sample (each input blob has nums() == 1). A worker forms a batch
+//!          once maxBatchSize samples are queued or the oldest has waited maxDelay, runs one
+//!          infer() and scatters sample i of every output back to request i. Batches whose
+//!          outputs are missing resolve their requests with empty outputs; an exception while
+//!          the batch is assembled or run is rethrown by the get() of each of its requests.
+//!          A request whose inputs do not match IBaseModel::inputShapes() resolves with empty
+//!          outputs on its own, the rest of its batch still runs.
+//!
+class DynamicBatcher {
+public:
+	DynamicBatcher(IBaseModel& model, const DynamicBatcherParams& params);
+	//! \brief Runs the queued requests, then stops the workers.
+	~DynamicBatcher();
+
+	std::future<std::vector<DataBlob32f>> submit(const std::vector<DataBlob32f>& sample);
+	DynamicBatcherStats stats() const;
+private:
+	typedef std::chrono::steady_clock clock_type;
+	struct Request {
+		std::vector<DataBlob32f> inputs;
+		std::promise<std::vector<DataBlob32f>> result;
+		clock_type::time_point arrival;
+	};
+	void workerLoop();
+	void runBatch(std::vector<Request>& batch);
+
+	IBaseModel& mModel;
+	DynamicBatcherParams mParams;
+	std::deque<Request> mQueue;
+	mutable std::mutex mMutex;
+	std::condition_variable mQueueChanged;
+	bool mStopping{false};
+	DynamicBatcherStats mStats;
+	std::vector<std::thread> mWorkers;
+};
+#endif
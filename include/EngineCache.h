@@ -0,0 +1,60 @@
+#ifndef DEPLOY_INCLUDE_ENGINECACHE_H_
+#define DEPLOY_INCLUDE_ENGINECACHE_H_
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include <common/mappedFile.h>
+
+//!
+//! \brief Incremental 64-bit FNV-1a hash of everything a built engine depends on.
+//!
+//! \details Every field is prefixed with its length, so that ("ab", "c") and ("a", "bc")
+//!          give different keys.
+//!
+class EngineKey {
+public:
+	EngineKey& add(const void* data, size_t size);
+	EngineKey& add(const std::string& value) { return add(value.data(), value.size()); }
+	template <typename T>
+	EngineKey& add(T value) {
+		static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "EngineKey::add takes plain values");
+		return add(&value, sizeof(value));
+	}
+	//!
+	//! \brief Hashes the contents of the file at path. Returns false if it can not be read.
+	//!
+	bool addFile(const std::string& path);
+	//!
+	//! \brief Returns the key as 16 hex digits, usable as a file name.
+	//!
+	std::string str() const;
+private:
+	void update(const void* data, size_t size);
+	uint64_t mHash{14695981039346656037ULL};
+};
+
+//!
+//! \brief A directory of serialized engines named by their EngineKey.
+//!
+//! \details Entries are written to a temporary file and renamed into place, so concurrent
+//!          processes building the same engine never see a partial plan.
+//!
+class EngineCache {
+public:
+	explicit EngineCache(const std::string& directory)
+		: mDirectory(directory)
+	{ }
+	std::string pathOf(const EngineKey& key) const;
+	//!
+	//! \brief Maps the cached plan of key, or returns an empty MappedFile on a miss.
+	//!
+	dtrCommon::MappedFile load(const EngineKey& key) const;
+	//!
+	//! \brief Atomically stores the serialized plan of key, creating the directory if needed.
+	//!
+	bool store(const EngineKey& key, const void* data, size_t size) const;
+private:
+	std::string mDirectory;
+};
+#endif
@@ -0,0 +1,98 @@
+#ifndef DEPLOY_INCLUDE_EXECUTIONCONTEXTPOOL_H_
+#define DEPLOY_INCLUDE_EXECUTIONCONTEXTPOOL_H_
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <NvInfer.h>
+#include <cuda_runtime_api.h>
+
+#include <common/buffers.h>
+#include <common/common.h>
+
+//!
+//! \brief Everything one inference needs besides the engine: an execution context,
+//!        the binding buffers and the stream the work is issued on.
+//!
+struct ExecutionSlot {
+	std::unique_ptr<nvinfer1::IExecutionContext, dtrCommon::DtrInferDeleter> context;
+	std::unique_ptr<dtrCommon::BufferManager> buffers;
+	cudaStream_t stream{nullptr};
+};
+
+//!
+//! \brief A bounded pool of ExecutionSlot sharing one ICudaEngine.
+//!
+//! \details Every thread checks out its own slot, so concurrent inferences only
+//!          contend on the short critical section of acquire()/release() and block
+//!          only when all slots are in use. A Lease keeps the pool (and therefore the
+//!          engine) alive until it is released. The pool also carries the binding indices
+//!          of the inputs and outputs its users run, so the engine and the bindings are
+//!          always taken together.
+//!
+class ExecutionContextPool : public std::enable_shared_from_this<ExecutionContextPool> {
+public:
+	class Lease {
+	public:
+		Lease() = default;
+		Lease(Lease&& rhs);
+		Lease& operator=(Lease&& rhs);
+		Lease(const Lease&) = delete;
+		Lease& operator=(const Lease&) = delete;
+		~Lease() { release(); }
+
+		ExecutionSlot& operator*() const { return *mSlot; }
+		ExecutionSlot* operator->() const { return mSlot; }
+		explicit operator bool() const { return mSlot != nullptr; }
+		const std::shared_ptr<ExecutionContextPool>& pool() const { return mPool; }
+		//! \brief Returns the slot to the pool, the lease is empty afterwards.
+		void release();
+	private:
+		friend class ExecutionContextPool;
+		Lease(std::shared_ptr<ExecutionContextPool> pool, int index);
+		std::shared_ptr<ExecutionContextPool> mPool;
+		ExecutionSlot* mSlot{nullptr};
+		int mIndex{-1};
+	};
+
+	//!
+	//! \brief Creates nbSlots slots for engine, each with buffers for batchSize whose host
+	//!        side is of hostMemoryType, laid out as layout, see dtrCommon::BufferManager.
+	//!        inputBindings and outputBindings are the binding indices of the tensors the
+	//!        users of the pool feed and read, in their order.
+	//!
+	//! \return nullptr if a context could not be created.
+	//!
+	static std::shared_ptr<ExecutionContextPool> create(std::shared_ptr<nvinfer1::ICudaEngine> engine, int batchSize, int nbSlots,
+		std::vector<int> inputBindings, std::vector<int> outputBindings,
+		dtrCommon::HostMemoryType hostMemoryType = dtrCommon::HostMemoryType::kPAGEABLE,
+		dtrCommon::BufferLayout layout = dtrCommon::BufferLayout::kPER_BINDING);
+	~ExecutionContextPool();
+
+	//! \brief Checks out a free slot, waiting until one is released if all are in use.
+	Lease acquire();
+	//! \brief Checks out a free slot, returns an empty lease if all are in use.
+	Lease tryAcquire();
+	//! \brief Waits until every slot is back in the pool.
+	void waitIdle();
+
+	const std::shared_ptr<nvinfer1::ICudaEngine>& engine() const { return mEngine; }
+	int batchSize() const { return mBatchSize; }
+	int size() const { return static_cast<int>(mSlots.size()); }
+	const std::vector<int>& inputBindings() const { return mInputBindings; }
+	const std::vector<int>& outputBindings() const { return mOutputBindings; }
+private:
+	ExecutionContextPool(std::shared_ptr<nvinfer1::ICudaEngine> engine, int batchSize,
+		std::vector<int> inputBindings, std::vector<int> outputBindings);
+	void release(int index);
+	std::shared_ptr<nvinfer1::ICudaEngine> mEngine;
+	int mBatchSize;
+	std::vector<int> mInputBindings;
+	std::vector<int> mOutputBindings;
+	std::vector<std::unique_ptr<ExecutionSlot>> mSlots;
+	std::vector<int> mFreeSlots;
+	std::mutex mMutex;
+	std::condition_variable mSlotReleased;
+	std::condition_variable mIdle;
+};
+#endif
@@ -0,0 +1,44 @@
+#ifndef DEPLOY_INCLUDE_LAYOUTCONVERT_H_
+#define DEPLOY_INCLUDE_LAYOUTCONVERT_H_
+#include <algorithm>
+#include <cstddef>
+
+#include <DataBlob.h>
+#include <common/simd.h>
+
+//!
+//! \brief The SimdLevel convertLayout() uses by default: that of the CPU, at most kAVX2.
+//!
+//! \details The conversions are bound by memory bandwidth. 16x16 AVX-512 tiles keep twice the
+//!          cache lines in flight and lower the clock on many parts, and measured slower than the
+//!          8x8 AVX2 tiles in bench_layout, so they are only used when asked for.
+//!
+inline dtrCommon::SimdLevel layoutSimdLevel()
+{
+	return std::min(dtrCommon::cpuSimdLevel(), dtrCommon::SimdLevel::kAVX2);
+}
+
+//!
+//! \brief Converts n contiguous samples of channel x height x width elements from layout
+//!        from in src to layout to in dst, which must not overlap.
+//!
+//! \details A sample is transposed between its channels and its pixels in cache-sized tiles.
+//!          On x86 float samples use 4x4, 8x8 or 16x16 register transposes up to level, and for three
+//!          channels a blend and permute (de)interleave of 4, 8 or 16 pixels at a time. Other
+//!          element types take the tiled scalar path.
+//!
+template <typename T>
+void convertLayout(const T *src, BlobLayout from, T *dst, BlobLayout to,
+	size_t n, size_t channel, size_t height, size_t width,
+	dtrCommon::SimdLevel level = layoutSimdLevel());
+
+//!
+//! \brief convertLayout() on threads threads, all the hardware threads for 0. The pixels of
+//!        the batch are split evenly, so a single large frame is spread as well as a batch.
+//!        Small conversions stay on the calling thread.
+//!
+template <typename T>
+void convertLayoutParallel(const T *src, BlobLayout from, T *dst, BlobLayout to,
+	size_t n, size_t channel, size_t height, size_t width, size_t threads = 0);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef DEPLOY_INCLUDE_MODELLOADER_H_
+#define DEPLOY_INCLUDE_MODELLOADER_H_
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <CaffeModel.h>
+
+struct ModelLoaderParams {
+	int concurrency{2};      //!< Models built or deserialized at the same time
+	int warmupIterations{1}; //!< Warmup rounds run on every slot of every model once it is built, overrides the model params
+};
+
+//!
+//! \brief What happened to one model during ModelLoader::load().
+//!
+struct ModelLoadReport {
+	std::string name;     //!< gieFileName, or prototxtFileName for models built from caffe
+	bool loaded{false};
+	bool skipped{false};  //!< Not attempted because another model failed first
+	double buildMs{0};    //!< CaffeModel::build(), deserialization or parse and build
+	double warmupMs{0};
+	StartupProfile profile; //!< Phases of the build, see CaffeModel::startupProfile()
+};
+std::ostream& operator<<(std::ostream& out, const ModelLoadReport& value);
+
+//!
+//! \brief Builds a set of models concurrently at startup.
+//!
+//! \details Models with a gieFileName are deserialized with build(false), the others are
+//!          parsed and built with build(true), which uses the engine cache if one is
+//!          configured. concurrency worker threads take the models in order. When a model
+//!          fails, the models not started yet are skipped and every model is released.
+//!
+class ModelLoader {
+public:
+	explicit ModelLoader(const ModelLoaderParams& params)
+		: mParams(params)
+	{ }
+	//!
+	//! \brief Returns the built models in the order of models, or an empty vector if any failed.
+	//!
+	std::vector<std::unique_ptr<CaffeModel>> load(const std::vector<dtrCommon::CaffeNNParams>& models);
+	//!
+	//! \brief Returns one report per model of the last load(), in the order of models.
+	//!
+	const std::vector<ModelLoadReport>& reports() const { return mReports; }
+private:
+	bool loadOne(CaffeModel& model, ModelLoadReport& report);
+	ModelLoaderParams mParams;
+	std::vector<ModelLoadReport> mReports;
+};
+#endif
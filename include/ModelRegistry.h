@@ -0,0 +1,81 @@
+#ifndef DEPLOY_INCLUDE_MODELREGISTRY_H_
+#define DEPLOY_INCLUDE_MODELREGISTRY_H_
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <CaffeModel.h>
+
+struct ModelRegistryParams {
+	size_t deviceMemoryBudget{0}; //!< Bytes of device memory the resident models may use, 0 for no limit
+};
+
+struct ModelRegistryStats {
+	std::string name;
+	bool resident{false};
+	size_t deviceMemory{0};  //!< Accounted bytes while resident: serialized plan, contexts and buffers
+	size_t planSize{0};      //!< Bytes of the host copy of the serialized plan
+	size_t reloads{0};
+	double lastReloadMs{0};
+	double totalReloadMs{0};
+};
+std::ostream& operator<<(std::ostream& out, const ModelRegistryStats& value);
+
+//!
+//! \brief Owns named CaffeModel instances and keeps their device memory under a budget.
+//!
+//! \details Every model is serialized to a host plan when it is added. When the resident
+//!          models exceed the budget, the least recently used ones that nobody holds are
+//!          released and only their host plan is kept. get() deserializes an evicted model
+//!          again, evicting others to make room. The engine weights are accounted as the
+//!          size of the serialized plan, which they dominate.
+//!          A reload runs outside the registry lock, so the models already resident are
+//!          served meanwhile; get() and remove() of the model being reloaded wait for it.
+//!          Its estimated footprint is accounted while it loads.
+//!
+class ModelRegistry {
+public:
+	explicit ModelRegistry(const ModelRegistryParams& params)
+		: mParams(params)
+	{ }
+	//!
+	//! \brief Takes over a built model. Fails if the name is taken or the model can not be serialized.
+	//!
+	bool add(const std::string& name, std::unique_ptr<CaffeModel> model);
+	//!
+	//! \brief Returns the model, reloading it if it was evicted. nullptr if the name is unknown,
+	//!        the reload failed or the model does not fit in the budget.
+	//!        A model is never evicted while a returned pointer is alive.
+	//!
+	std::shared_ptr<CaffeModel> get(const std::string& name);
+	bool remove(const std::string& name);
+	//!
+	//! \brief Returns the device memory accounted to the resident models in bytes.
+	//!
+	size_t deviceMemoryUsage() const;
+	std::vector<ModelRegistryStats> stats() const;
+private:
+	struct Entry {
+		std::shared_ptr<CaffeModel> model;
+		std::vector<char> plan;
+		std::list<std::string>::iterator lru; //!< position in mLru, only while resident
+		ModelRegistryStats stats;
+		bool loading{false};                  //!< get() is building it outside the lock
+		std::unique_ptr<std::condition_variable> loaded{new std::condition_variable()}; //!< signalled when loading ends
+	};
+	std::map<std::string, Entry>::iterator waitLoaded(std::unique_lock<std::mutex>& lock, const std::string& name);
+	void touch(Entry& entry);
+	void evict(Entry& entry);
+	bool makeRoom(size_t size, const Entry* keep);
+	ModelRegistryParams mParams;
+	mutable std::mutex mMutex;
+	std::map<std::string, Entry> mEntries;
+	std::list<std::string> mLru; //!< resident models, most recently used first
+	size_t mUsage{0};
+};
+#endif
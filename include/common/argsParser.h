@@ -29,6 +29,12 @@ typedef struct NNParams {
     int maxWorkSpaceSize{1<<25};
     std::string saveEngine;
     bool useSpinWait;
+    int nbExecutionContexts{1}; //!< Number of execution contexts shared by concurrent inferences, 2 or 3 pipeline inferAsync()
+    bool pinnedHostMemory{true}; //!< Page-locked host buffers, the copies to and from the device run by DMA
+    bool writeCombinedInputs{false}; //!< Write-combined host buffers for the inputs, only with pinnedHostMemory
+    bool slabBuffers{false}; //!< One slab for the inputs and one for the outputs, copied in a single transfer each
+    bool mappedHostMemory{false}; //!< Zero-copy host buffers the device uses in place, for integrated GPUs sharing DRAM with the host
+    int warmupIterations{1}; //!< Rounds of one zero batch per execution context run after the engine is built, before the model is ready
 } NNParams;
 
 //!
@@ -40,6 +46,7 @@ typedef struct CaffeNNParams : public NNParams {
     std::string weightsFileName;  //!< Filename of trained weights file of a network
     std::string gieFileName;
     std::string perTensorDynamicRangeFileName;
+    std::string engineCacheDir; //!< Directory caching the engines built from prototxt and weights, empty disables it
 } CaffeNNParams;
 
 // typedef struct GIENNParams : public NNParams {
@@ -2,9 +2,11 @@
 #define TENSORRT_BUFFERS_H
 
 #include "NvInfer.h"
-#include "half.h"
 #include "common.h"
+#include "deviceAllocator.h"
+#include "typeConvert.h"
 #include <cuda_runtime_api.h>
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <iterator>
@@ -57,6 +59,17 @@ public:
             throw std::bad_alloc();
     }
 
+    //!
+    //! \brief Construct a buffer of size bytes allocated by a configured allocFn.
+    //!
+    GenericBuffer(size_t size, const AllocFunc& alloc)
+        : mByteSize(size)
+        , allocFn(alloc)
+    {
+        if (!allocFn(&mBuffer, mByteSize))
+            throw std::bad_alloc();
+    }
+
     GenericBuffer(GenericBuffer&& buf)
         : mByteSize(buf.mByteSize)
         , mBuffer(buf.mBuffer)
@@ -105,34 +118,111 @@ private:
     FreeFunc freeFn;
 };
 
+//!
+//! \brief Allocates from CachingDeviceAllocator::instance(), for use on stream.
+//!
 class DeviceAllocator
 {
 public:
-    bool operator()(void** ptr, size_t size) const { return cudaMalloc(ptr, size) == cudaSuccess; }
+    DeviceAllocator(cudaStream_t stream = 0)
+        : mStream(stream)
+    {
+    }
+
+    bool operator()(void** ptr, size_t size) const
+    {
+        return CachingDeviceAllocator::instance().allocate(ptr, size, mStream) == cudaSuccess;
+    }
+
+private:
+    cudaStream_t mStream;
 };
 
 class DeviceFree
 {
 public:
-    void operator()(void* ptr) const { cudaFree(ptr); }
+    void operator()(void* ptr) const { CachingDeviceAllocator::instance().free(ptr); }
 };
 
 
 
+//!
+//! \brief Kinds of host memory backing a HostBuffer.
+//!
+//! \details Copies from pageable memory are staged by the driver through a pinned bounce
+//!          buffer, so cudaMemcpyAsync() does not overlap with the host. Page-locked memory
+//!          is copied by DMA directly. Write-combined memory is page-locked memory that
+//!          bypasses the host caches: host writes and device reads are faster, host reads
+//!          are very slow, so it only suits buffers the host writes and never reads back.
+//!          Mapped memory is page-locked memory the device accesses in place: on integrated
+//!          GPUs, where host and device share DRAM, BufferManager binds it as the device
+//!          buffer too and its copies are skipped. On discrete GPUs every access crosses PCIe.
+//!
+enum class HostMemoryType
+{
+    kPAGEABLE,
+    kPINNED,
+    kWRITE_COMBINED,
+    kMAPPED
+};
+
 class HostAllocator
 {
 public:
+    HostAllocator(HostMemoryType type = HostMemoryType::kPAGEABLE)
+        : mType(type)
+    {
+    }
+
+    //!
+    //! \brief Allocates page-locked memory if mType asks for it, pageable memory if that fails.
+    //!
     bool operator()(void** ptr, size_t size) const
     {
+        if (mType != HostMemoryType::kPAGEABLE)
+        {
+            unsigned int flags = mType == HostMemoryType::kWRITE_COMBINED ? cudaHostAllocWriteCombined
+                : mType == HostMemoryType::kMAPPED ? cudaHostAllocMapped : cudaHostAllocDefault;
+            if (cudaHostAlloc(ptr, size, flags) == cudaSuccess)
+                return true;
+            // clear the error, the pageable fallback still works
+            cudaGetLastError();
+            LOG_WARN(gLogger) << "cudaHostAlloc of " << size << " bytes failed, using pageable memory" << std::endl;
+        }
         *ptr = fastAlloc(size);
         return *ptr != nullptr;
     }
+
+private:
+    HostMemoryType mType;
 };
 
+//!
+//! \brief Returns the kind of host memory ptr points to. Mapped memory is reported as kPINNED:
+//!        with unified addressing all page-locked memory is mapped.
+//!
+inline HostMemoryType hostMemoryTypeOf(const void* ptr)
+{
+    unsigned int flags = 0;
+    if (!ptr || cudaHostGetFlags(&flags, const_cast<void*>(ptr)) != cudaSuccess)
+    {
+        cudaGetLastError();
+        return HostMemoryType::kPAGEABLE;
+    }
+    return (flags & cudaHostAllocWriteCombined) ? HostMemoryType::kWRITE_COMBINED : HostMemoryType::kPINNED;
+}
+
 class HostFree
 {
 public:
-    void operator()(void* ptr) const { fastFree(ptr); }
+    //! The allocator may have fallen back to pageable memory, ask cuda which kind ptr is.
+    void operator()(void* ptr) const
+    {
+        if (hostMemoryTypeOf(ptr) == HostMemoryType::kPAGEABLE)
+            fastFree(ptr);
+        else
+            cudaFreeHost(ptr);
+    }
 };
 
 using DeviceBuffer = GenericBuffer<DeviceAllocator, DeviceFree>;
@@ -148,6 +238,22 @@ public:
     HostBuffer hostBuffer;
 };
 
+//!
+//! \brief How BufferManager lays out the buffers of the bindings.
+//!
+//! \details kPER_BINDING allocates a host and a device buffer for every binding and copies
+//!          each of them separately. kSLAB lays all the inputs out back to back in one host and
+//!          one device allocation, and all the outputs in another, each binding aligned to
+//!          kSLAB_ALIGNMENT bytes, so copying the inputs or the outputs takes a single transfer.
+//!          That pays off for models with several small bindings, where the fixed cost of
+//!          each copy dominates.
+//!
+enum class BufferLayout
+{
+    kPER_BINDING,
+    kSLAB
+};
+
 //!
 //! \brief  The BufferManager class handles host and device buffer allocation and deallocation.
 //!
@@ -160,24 +266,63 @@ class BufferManager
 {
 public:
     static const size_t kINVALID_SIZE_VALUE = ~size_t(0);
+    //! Offsets of the bindings in a slab are multiples of this, as cudaMalloc aligns its allocations.
+    static const size_t kSLAB_ALIGNMENT = 256;
 
     //!
     //! \brief Create a BufferManager for handling buffer interactions with engine.
     //!
-    BufferManager(std::shared_ptr<nvinfer1::ICudaEngine> engine, const int& batchSize)
+    //! \details hostMemoryType applies to every host buffer, except that kWRITE_COMBINED only
+    //!          applies to the inputs, which the host never reads: the outputs are kPINNED then.
+    //!          With kMAPPED no device buffers are allocated, the engine is bound to the device
+    //!          aliases of the host buffers and the copies between them do nothing.
+    //!          The device buffers come from the free lists of stream, the one they are used on.
+    //!
+    BufferManager(std::shared_ptr<nvinfer1::ICudaEngine> engine, const int& batchSize,
+        HostMemoryType hostMemoryType = HostMemoryType::kPAGEABLE, BufferLayout layout = BufferLayout::kPER_BINDING,
+        cudaStream_t stream = 0)
+        : BufferManager(engine, batchSize, hostMemoryTypes(*engine, hostMemoryType), layout, stream)
+    {
+    }
+
+    //!
+    //! \brief Create a BufferManager whose host buffer of binding i is of hostMemoryTypes[i],
+    //!        kPAGEABLE for the bindings past the end of hostMemoryTypes. With kSLAB the host
+    //!        slab of the inputs, and that of the outputs, is of the type of its first binding.
+    //!
+    BufferManager(std::shared_ptr<nvinfer1::ICudaEngine> engine, const int& batchSize,
+        const std::vector<HostMemoryType>& hostMemoryTypes, BufferLayout layout = BufferLayout::kPER_BINDING,
+        cudaStream_t stream = 0)
         : mEngine(engine)
         , mBatchSize(batchSize)
+        , mLayout(layout)
+        , mStream(stream)
     {
-        for (int i = 0; i < mEngine->getNbBindings(); i++)
+        int nbBindings = mEngine->getNbBindings();
+        mHostBindings.resize(nbBindings);
+        mDeviceBindings.resize(nbBindings);
+        mHostMemoryTypes.resize(nbBindings);
+        for (int i = 0; i < nbBindings; i++)
         {
-            // Create host and device buffers
             size_t vol = dtrCommon::volume(mEngine->getBindingDimensions(i));
             size_t elementSize = dtrCommon::getElementSize(mEngine->getBindingDataType(i));
-            size_t allocationSize = static_cast<size_t>(mBatchSize) * vol * elementSize;
+            mByteSizes.push_back(static_cast<size_t>(mBatchSize) * vol * elementSize);
+            (mEngine->bindingIsInput(i) ? mInputIndices : mOutputIndices).push_back(i);
+        }
+        auto typeOf = [&](int i) {
+            return i < static_cast<int>(hostMemoryTypes.size()) ? hostMemoryTypes[i] : HostMemoryType::kPAGEABLE;
+        };
+        if (mLayout == BufferLayout::kSLAB)
+        {
+            allocateSlab(mInputIndices, typeOf);
+            allocateSlab(mOutputIndices, typeOf);
+            return;
+        }
+        for (int i = 0; i < nbBindings; i++)
+        {
+            // Create host and device buffers
             std::unique_ptr<ManagedBuffer> manBuf{new ManagedBuffer()};
-            manBuf->deviceBuffer = DeviceBuffer(allocationSize);
-            manBuf->hostBuffer = HostBuffer(allocationSize);
-            mDeviceBindings.emplace_back(manBuf->deviceBuffer.data());
+            mHostMemoryTypes[i] = allocate(*manBuf, mByteSizes[i], typeOf(i), mHostBindings[i], mDeviceBindings[i], mStream);
             mManagedBuffers.emplace_back(std::move(manBuf));
         }
     }
@@ -205,16 +350,52 @@ public:
     //!
     void* getHostBuffer(const std::string& tensorName) const { return getBuffer(true, tensorName); }
 
+    //!
+    //! \brief Returns the device buffer of the binding at bindingIndex.
+    //!        Returns nullptr if bindingIndex is out of range.
+    //!
+    void* getDeviceBuffer(int bindingIndex) const { return getBuffer(false, bindingIndex); }
+
+    //!
+    //! \brief Returns the host buffer of the binding at bindingIndex.
+    //!        Returns nullptr if bindingIndex is out of range.
+    //!
+    void* getHostBuffer(int bindingIndex) const { return getBuffer(true, bindingIndex); }
+
+    //!
+    //! \brief Returns the size of the host and device buffers of the binding at bindingIndex.
+    //!        Returns kINVALID_SIZE_VALUE if bindingIndex is out of range.
+    //!
+    size_t size(int bindingIndex) const
+    {
+        if (bindingIndex < 0 || bindingIndex >= static_cast<int>(mByteSizes.size()))
+            return kINVALID_SIZE_VALUE;
+        return mByteSizes[bindingIndex];
+    }
+
+    //!
+    //! \brief Returns the kind of memory the host buffer of the binding at bindingIndex got,
+    //!        kPAGEABLE if pinning it failed or bindingIndex is out of range.
+    //!
+    HostMemoryType hostMemoryType(int bindingIndex) const
+    {
+        if (bindingIndex < 0 || bindingIndex >= static_cast<int>(mHostMemoryTypes.size()))
+            return HostMemoryType::kPAGEABLE;
+        return mHostMemoryTypes[bindingIndex];
+    }
+
+    //!
+    //! \brief Returns how the buffers of the bindings are laid out.
+    //!
+    BufferLayout layout() const { return mLayout; }
+
     //!
     //! \brief Returns the size of the host and device buffers that correspond to tensorName.
     //!        Returns kINVALID_SIZE_VALUE if no such tensor can be found.
     //!
     size_t size(const std::string& tensorName) const
     {
-        int index = mEngine->getBindingIndex(tensorName.c_str());
-        if (index == -1)
-            return kINVALID_SIZE_VALUE;
-        return mManagedBuffers[index]->hostBuffer.size();
+        return size(mEngine->getBindingIndex(tensorName.c_str()));
     }
 
     //!
@@ -229,8 +410,8 @@ public:
             os << "Invalid tensor name" << std::endl;
             return;
         }
-        void* buf = mManagedBuffers[index]->hostBuffer.data();
-        size_t bufSize = mManagedBuffers[index]->hostBuffer.size();
+        void* buf = mHostBindings[index];
+        size_t bufSize = mByteSizes[index];
         nvinfer1::Dims bufDims = mEngine->getBindingDimensions(index);
         size_t rowCount = static_cast<size_t>(bufDims.nbDims >= 1 ? bufDims.d[bufDims.nbDims - 1] : mBatchSize);
 
@@ -242,7 +423,13 @@ public:
         {
         case nvinfer1::DataType::kINT32: print<int32_t>(os, buf, bufSize, rowCount); break;
         case nvinfer1::DataType::kFLOAT: print<float>(os, buf, bufSize, rowCount); break;
-        case nvinfer1::DataType::kHALF: print<half_float::half>(os, buf, bufSize, rowCount); break;
+        case nvinfer1::DataType::kHALF:
+        {
+            std::vector<float> values(bufSize / sizeof(uint16_t));
+            halfToFloat(static_cast<const uint16_t*>(buf), values.data(), values.size());
+            print<float>(os, values.data(), values.size() * sizeof(float), rowCount);
+            break;
+        }
         case nvinfer1::DataType::kINT8: assert(0 && "Int8 network-level input and output is not supported"); break;
         }
     }
@@ -279,55 +466,219 @@ public:
     //!
     //! \brief Copy the contents of input host buffers to input device buffers synchronously.
     //!
-    void copyInputToDevice() { memcpyBuffers(true, false, false); }
+    void copyInputToDevice() { memcpyBuffers(true, false, false, 0, mBatchSize); }
 
     //!
     //! \brief Copy the contents of output device buffers to output host buffers synchronously.
     //!
-    void copyOutputToHost() { memcpyBuffers(false, true, false); }
+    void copyOutputToHost() { memcpyBuffers(false, true, false, 0, mBatchSize); }
 
     //!
     //! \brief Copy the contents of input host buffers to input device buffers asynchronously.
     //!
-    void copyInputToDeviceAsync(const cudaStream_t& stream = 0) { memcpyBuffers(true, false, true, stream); }
+    void copyInputToDeviceAsync(const cudaStream_t& stream = 0) { memcpyBuffers(true, false, true, stream, mBatchSize); }
 
     //!
     //! \brief Copy the contents of output device buffers to output host buffers asynchronously.
     //!
-    void copyOutputToHostAsync(const cudaStream_t& stream = 0) { memcpyBuffers(false, true, true, stream); }
+    void copyOutputToHostAsync(const cudaStream_t& stream = 0) { memcpyBuffers(false, true, true, stream, mBatchSize); }
+
+    //!
+    //! \brief Copy the first batchSize samples of the input host buffers to the input device buffers asynchronously.
+    //!
+    void copyInputToDeviceAsync(const cudaStream_t& stream, int batchSize) { memcpyBuffers(true, false, true, stream, batchSize); }
+
+    //!
+    //! \brief Copy the first batchSize samples of the output device buffers to the output host buffers asynchronously.
+    //!
+    void copyOutputToHostAsync(const cudaStream_t& stream, int batchSize) { memcpyBuffers(false, true, true, stream, batchSize); }
+
+    //!
+    //! \brief Copy the first batchSize samples of the device buffers of bindingIndices to their host buffers
+    //!        asynchronously. The other bindings are not transferred.
+    //!
+    void copyOutputToHostAsync(const std::vector<int>& bindingIndices, const cudaStream_t& stream, int batchSize)
+    {
+        if (mLayout == BufferLayout::kSLAB && memcpySlab(bindingIndices, true, true, stream, batchSize))
+            return;
+        for (int index : bindingIndices)
+        {
+            assert(index >= 0 && index < static_cast<int>(mByteSizes.size()));
+            memcpyBuffer(index, true, true, stream, batchSize);
+        }
+    }
 
     ~BufferManager() = default;
 
+private:
+    static std::vector<HostMemoryType> hostMemoryTypes(const nvinfer1::ICudaEngine& engine, HostMemoryType type)
+    {
+        std::vector<HostMemoryType> types;
+        for (int i = 0; i < engine.getNbBindings(); i++)
+        {
+            bool writeCombined = type == HostMemoryType::kWRITE_COMBINED && engine.bindingIsInput(i);
+            types.push_back(type == HostMemoryType::kWRITE_COMBINED && !writeCombined ? HostMemoryType::kPINNED : type);
+        }
+        return types;
+    }
+
+    //!
+    //! \brief Allocates a host buffer of size bytes of type into buffer, and a device buffer
+    //!        unless the host one is mapped. Returns the type the host buffer got, kMAPPED if
+    //!        device is an alias of host. The device buffer is for use on stream.
+    //!
+    static HostMemoryType allocate(ManagedBuffer& buffer, size_t size, HostMemoryType type, void*& host, void*& device,
+        cudaStream_t stream)
+    {
+        buffer.hostBuffer = HostBuffer(size, HostAllocator(type));
+        host = buffer.hostBuffer.data();
+        HostMemoryType got = hostMemoryTypeOf(host);
+        if (type == HostMemoryType::kMAPPED && got != HostMemoryType::kPAGEABLE)
+        {
+            if (cudaHostGetDevicePointer(&device, host, 0) == cudaSuccess)
+                return HostMemoryType::kMAPPED;
+            cudaGetLastError();
+            LOG_WARN(gLogger) << "mapping " << size << " bytes of host memory failed, allocating device memory" << std::endl;
+        }
+        buffer.deviceBuffer = DeviceBuffer(size, DeviceAllocator(stream));
+        device = buffer.deviceBuffer.data();
+        return got;
+    }
+
+    //!
+    //! \brief Allocates one host and one device slab for the inputs, or for the outputs, and
+    //!        points their bindings into them.
+    //!
+    template <typename TypeOf>
+    void allocateSlab(const std::vector<int>& bindingIndices, const TypeOf& typeOf)
+    {
+        if (bindingIndices.empty())
+            return;
+        std::vector<size_t> offsets;
+        size_t slabSize = 0;
+        for (int index : bindingIndices)
+        {
+            offsets.push_back(slabSize);
+            slabSize += (mByteSizes[index] + kSLAB_ALIGNMENT - 1) / kSLAB_ALIGNMENT * kSLAB_ALIGNMENT;
+        }
+        std::unique_ptr<ManagedBuffer> manBuf{new ManagedBuffer()};
+        void* host = nullptr;
+        void* device = nullptr;
+        HostMemoryType type = allocate(*manBuf, slabSize, typeOf(bindingIndices[0]), host, device, mStream);
+        for (size_t i = 0; i < bindingIndices.size(); i++)
+        {
+            mHostBindings[bindingIndices[i]] = static_cast<char*>(host) + offsets[i];
+            mDeviceBindings[bindingIndices[i]] = static_cast<char*>(device) + offsets[i];
+            mHostMemoryTypes[bindingIndices[i]] = type;
+        }
+        mManagedBuffers.emplace_back(std::move(manBuf));
+    }
+
 private:
     void* getBuffer(const bool isHost, const std::string& tensorName) const
     {
-        int index = mEngine->getBindingIndex(tensorName.c_str());
-        if (index == -1)
+        return getBuffer(isHost, mEngine->getBindingIndex(tensorName.c_str()));
+    }
+
+    void* getBuffer(const bool isHost, int index) const
+    {
+        if (index < 0 || index >= static_cast<int>(mByteSizes.size()))
             return nullptr;
-        return (isHost ? mManagedBuffers[index]->hostBuffer.data() : mManagedBuffers[index]->deviceBuffer.data());
+        return isHost ? mHostBindings[index] : mDeviceBindings[index];
     }
 
-    void memcpyBuffers(const bool copyInput, const bool deviceToHost, const bool async, const cudaStream_t& stream = 0)
+    void memcpyBuffers(const bool copyInput, const bool deviceToHost, const bool async, const cudaStream_t& stream, int batchSize)
     {
+        if (mLayout == BufferLayout::kSLAB && memcpySlab(copyInput ? mInputIndices : mOutputIndices, deviceToHost, async, stream, batchSize))
+            return;
         for (int i = 0; i < mEngine->getNbBindings(); i++)
         {
-            void* dstPtr = deviceToHost ? mManagedBuffers[i]->hostBuffer.data() : mManagedBuffers[i]->deviceBuffer.data();
-            const void* srcPtr = deviceToHost ? mManagedBuffers[i]->deviceBuffer.data() : mManagedBuffers[i]->hostBuffer.data();
-            const size_t byteSize = mManagedBuffers[i]->hostBuffer.size();
-            const cudaMemcpyKind memcpyType = deviceToHost ? cudaMemcpyDeviceToHost : cudaMemcpyHostToDevice;
             if ((copyInput && mEngine->bindingIsInput(i)) || (!copyInput && !mEngine->bindingIsInput(i)))
-            {
-                if (async)
-                    CHECK(cudaMemcpyAsync(dstPtr, srcPtr, byteSize, memcpyType, stream));
-                else
-                    CHECK(cudaMemcpy(dstPtr, srcPtr, byteSize, memcpyType));
-            }
+                memcpyBuffer(i, deviceToHost, async, stream, batchSize);
         }
     }
 
+    //!
+    //! \brief Copies the first batchSize samples of bindingIndices, consecutive bindings of one slab, in one transfer.
+    //!
+    //! \details The transfer spans the unused samples of every binding but the last, so it is only
+    //!          made when it moves at most twice the bytes of the copies per binding.
+    //!          Returns false if it was not made.
+    //!
+    bool memcpySlab(const std::vector<int>& bindingIndices, const bool deviceToHost, const bool async, const cudaStream_t& stream, int batchSize)
+    {
+        assert(batchSize >= 0 && batchSize <= mBatchSize);
+        if (bindingIndices.empty())
+            return true;
+        if (bindingIndices[0] < 0 || bindingIndices[0] >= static_cast<int>(mByteSizes.size()))
+            return false;
+        // the bindings must follow each other in one slab, the transfer would overwrite those in between
+        const std::vector<int>& slab = mEngine->bindingIsInput(bindingIndices[0]) ? mInputIndices : mOutputIndices;
+        size_t position = std::find(slab.begin(), slab.end(), bindingIndices[0]) - slab.begin();
+        if (position + bindingIndices.size() > slab.size()
+            || !std::equal(bindingIndices.begin(), bindingIndices.end(), slab.begin() + position))
+            return false;
+        size_t usedSize = 0;
+        for (int index : bindingIndices)
+            usedSize += mByteSizes[index] / mBatchSize * batchSize;
+        int first = bindingIndices.front();
+        int last = bindingIndices.back();
+        if (mHostMemoryTypes[first] == HostMemoryType::kMAPPED)
+            return waitForMapped(deviceToHost, async);
+        size_t spanSize = static_cast<char*>(mHostBindings[last]) - static_cast<char*>(mHostBindings[first])
+            + mByteSizes[last] / mBatchSize * batchSize;
+        if (spanSize > 2 * usedSize)
+            return false;
+        void* dstPtr = deviceToHost ? mHostBindings[first] : mDeviceBindings[first];
+        const void* srcPtr = deviceToHost ? mDeviceBindings[first] : mHostBindings[first];
+        copyBytes(dstPtr, srcPtr, spanSize, deviceToHost, async, stream);
+        return true;
+    }
+
+    void memcpyBuffer(int index, const bool deviceToHost, const bool async, const cudaStream_t& stream, int batchSize)
+    {
+        assert(batchSize >= 0 && batchSize <= mBatchSize);
+        if (mHostMemoryTypes[index] == HostMemoryType::kMAPPED)
+        {
+            waitForMapped(deviceToHost, async);
+            return;
+        }
+        void* dstPtr = deviceToHost ? mHostBindings[index] : mDeviceBindings[index];
+        const void* srcPtr = deviceToHost ? mDeviceBindings[index] : mHostBindings[index];
+        // implicit batch buffers hold mBatchSize samples back to back
+        copyBytes(dstPtr, srcPtr, mByteSizes[index] / mBatchSize * batchSize, deviceToHost, async, stream);
+    }
+
+    //!
+    //! \brief The copies of mapped buffers do nothing, a synchronous one to the host still waits
+    //!        for the device like cudaMemcpy() would, so the host sees what the device wrote.
+    //!
+    static bool waitForMapped(const bool deviceToHost, const bool async)
+    {
+        if (deviceToHost && !async)
+            CHECK(cudaDeviceSynchronize());
+        return true;
+    }
+
+    void copyBytes(void* dstPtr, const void* srcPtr, size_t byteSize, const bool deviceToHost, const bool async, const cudaStream_t& stream)
+    {
+        const cudaMemcpyKind memcpyType = deviceToHost ? cudaMemcpyDeviceToHost : cudaMemcpyHostToDevice;
+        if (async)
+            CHECK(cudaMemcpyAsync(dstPtr, srcPtr, byteSize, memcpyType, stream));
+        else
+            CHECK(cudaMemcpy(dstPtr, srcPtr, byteSize, memcpyType));
+    }
+
     std::shared_ptr<nvinfer1::ICudaEngine> mEngine;              //!< The pointer to the engine
     int mBatchSize;                                              //!< The batch size
-    std::vector<std::unique_ptr<ManagedBuffer>> mManagedBuffers; //!< The vector of pointers to managed buffers
+    BufferLayout mLayout;                                        //!< How the buffers of the bindings are laid out
+    cudaStream_t mStream;                                        //!< The stream the device buffers are allocated for
+    std::vector<std::unique_ptr<ManagedBuffer>> mManagedBuffers; //!< A buffer pair per binding, or the input and output slabs
+    std::vector<size_t> mByteSizes;                              //!< The size of the buffers of each binding
+    std::vector<HostMemoryType> mHostMemoryTypes;                //!< The kind of memory the host buffer of each binding got
+    std::vector<void*> mHostBindings;                            //!< The host buffer of each binding
+    std::vector<int> mInputIndices;                              //!< The input bindings in the order of their slab
+    std::vector<int> mOutputIndices;                             //!< The output bindings in the order of their slab
     std::vector<void*> mDeviceBindings;                          //!< The vector of device buffers needed for engine execution
 };
 
@@ -4,6 +4,7 @@
 #include "NvInfer.h"
 #include "NvInferPlugin.h"
 #include "logger.h"
+#include "hostArena.h"
 #include "NvOnnxConfig.h"
 #include "NvOnnxParser.h"
 #include <algorithm>
@@ -51,30 +52,21 @@ constexpr long long int operator"" _GB(long long unsigned int val) { return val
 constexpr long long int operator"" _MB(long long unsigned int val) { return val * (1 << 20); }
 constexpr long long int operator"" _KB(long long unsigned int val) { return val * (1 << 10); }
 
-#define FAST_MALLOC_ALIGN 16
-
 template<typename _Tp> 
 static _Tp* alignPtr(_Tp* ptr, int n=(int)sizeof(_Tp)) {
     return (_Tp*)(((size_t)ptr + n-1) & -n);
 }
 
+//! 64 byte aligned host memory from dtrCommon::HostArena::instance().
 inline void fastFree(void* ptr) {
-    if(ptr) {
-        uint8_t* udata = ((uint8_t**)ptr)[-1];
-        assert(udata < (uint8_t*)ptr &&
-               ((uint8_t*)ptr - udata) <= (ptrdiff_t)(sizeof(void*)+FAST_MALLOC_ALIGN));
-        free(udata);
-    }
+    dtrCommon::HostArena::instance().free(ptr);
 }
 inline void* fastAlloc(size_t size) {
-    uint8_t* udata = (uint8_t*)malloc(size + sizeof(void*) + FAST_MALLOC_ALIGN);
-    if(!udata) {
+    void* ptr = dtrCommon::HostArena::instance().allocate(size);
+    if(!ptr) {
         std::cerr << "Alloc memory Failed"<< std::endl;
-        return NULL;
     }
-    uint8_t** adata = alignPtr((uint8_t**)udata + 1, FAST_MALLOC_ALIGN);
-    adata[-1] = udata;
-    return adata;
+    return ptr;
 }
 
 
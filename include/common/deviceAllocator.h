@@ -0,0 +1,277 @@
+#ifndef TENSORRT_DEVICE_ALLOCATOR_H
+#define TENSORRT_DEVICE_ALLOCATOR_H
+
+#include <cuda_runtime_api.h>
+#include <chrono>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace dtrCommon
+{
+
+//!
+//! \brief Counters of a CachingDeviceAllocator.
+//!
+struct DeviceAllocatorStats
+{
+    size_t hits{0};           //!< allocations served from a free list
+    size_t misses{0};         //!< allocations that went to cudaMalloc
+    size_t releases{0};       //!< idle blocks given back with cudaFree
+    size_t bytesRequested{0}; //!< bytes asked for by the live allocations
+    size_t bytesInUse{0};     //!< bytes of the blocks backing the live allocations
+    size_t bytesCached{0};    //!< bytes of the idle blocks in the free lists
+    size_t blocksCached{0};
+
+    double hitRate() const { return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+
+    //!
+    //! \brief Share of bytesInUse lost to rounding requests up to their size class.
+    //!
+    double fragmentation() const { return bytesInUse ? 1.0 - static_cast<double>(bytesRequested) / bytesInUse : 0.0; }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const DeviceAllocatorStats& value)
+{
+    out << std::fixed << std::setprecision(1) << value.hitRate() * 100 << "% hits (" << value.hits << "/"
+        << value.hits + value.misses << "), " << (value.bytesInUse >> 10) << " KB in use, "
+        << (value.bytesCached >> 10) << " KB cached in " << value.blocksCached << " blocks, "
+        << value.fragmentation() * 100 << "% fragmentation";
+    return out;
+}
+
+//!
+//! \brief A size-class caching allocator of device memory.
+//!
+//! \details cudaMalloc and cudaFree synchronize the device, so freed blocks are kept in free
+//!          lists and handed out again instead. Requests are rounded up to one of four size
+//!          classes per power of two, which wastes less than 20% of a block. A block is only
+//!          reused on the stream it was allocated for: work queued on that stream before the
+//!          free is ordered before any work of the next owner, without an event or a sync.
+//!          Memory freed on a stream must not be in use by other streams.
+//!          Idle blocks are given back by trim(), by trimStream() once their stream goes away,
+//!          by free() past maxCachedBytes (kDEFAULT_MAX_CACHED_BYTES unless set), and all of
+//!          them when cudaMalloc runs out of memory.
+//!
+class CachingDeviceAllocator
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static const size_t kMIN_BLOCK_SIZE = 512;
+    static const size_t kDEFAULT_MAX_CACHED_BYTES = size_t(1) << 30;
+
+    CachingDeviceAllocator() = default;
+    CachingDeviceAllocator(const CachingDeviceAllocator&) = delete;
+    CachingDeviceAllocator& operator=(const CachingDeviceAllocator&) = delete;
+
+    ~CachingDeviceAllocator() { trim(); }
+
+    //!
+    //! \brief The allocator shared by DeviceBuffer, BufferManager and the plugins.
+    //!
+    //! \details It is never destroyed: at exit the cuda runtime may already be torn down,
+    //!          and the driver reclaims the memory anyway.
+    //!
+    static CachingDeviceAllocator& instance()
+    {
+        static CachingDeviceAllocator* allocator = new CachingDeviceAllocator();
+        return *allocator;
+    }
+
+    //!
+    //! \brief Returns the size class size is rounded up to.
+    //!
+    static size_t blockSize(size_t size)
+    {
+        if (size <= kMIN_BLOCK_SIZE)
+            return kMIN_BLOCK_SIZE;
+        size_t power = kMIN_BLOCK_SIZE;
+        while (power <= size / 2)
+            power *= 2;
+        size_t step = power / 4;
+        return (size + step - 1) / step * step;
+    }
+
+    //!
+    //! \brief Allocates size bytes of device memory for use on stream.
+    //!
+    cudaError_t allocate(void** ptr, size_t size, cudaStream_t stream = 0)
+    {
+        *ptr = nullptr;
+        int device = 0;
+        cudaError_t status = cudaGetDevice(&device);
+        if (status != cudaSuccess)
+            return status;
+        size_t block = blockSize(size);
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto list = mFreeLists.find(std::make_tuple(device, stream, block));
+        if (list != mFreeLists.end() && !list->second.empty())
+        {
+            // the most recently freed block is the most likely to still be in the caches
+            *ptr = list->second.back().ptr;
+            list->second.pop_back();
+            --mStats.blocksCached;
+            mStats.bytesCached -= block;
+            ++mStats.hits;
+        }
+        else
+        {
+            status = cudaMalloc(ptr, block);
+            if (status == cudaErrorMemoryAllocation)
+            {
+                cudaGetLastError();
+                releaseIdle(Clock::time_point::max());
+                status = cudaMalloc(ptr, block);
+            }
+            if (status != cudaSuccess)
+            {
+                *ptr = nullptr;
+                return status;
+            }
+            ++mStats.misses;
+        }
+        mLive[*ptr] = LiveBlock{device, stream, block, size};
+        mStats.bytesInUse += block;
+        mStats.bytesRequested += size;
+        return cudaSuccess;
+    }
+
+    //!
+    //! \brief Returns ptr to the free list of its stream. Pointers it did not allocate go to cudaFree.
+    //!
+    cudaError_t free(void* ptr)
+    {
+        if (!ptr)
+            return cudaSuccess;
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto live = mLive.find(ptr);
+        if (live == mLive.end())
+            return cudaFree(ptr);
+        LiveBlock block = live->second;
+        mLive.erase(live);
+        mStats.bytesInUse -= block.size;
+        mStats.bytesRequested -= block.requested;
+        if (mMaxCachedBytes && mStats.bytesCached + block.size > mMaxCachedBytes)
+        {
+            ++mStats.releases;
+            return cudaFree(ptr);
+        }
+        mFreeLists[std::make_tuple(block.device, block.stream, block.size)].push_back(CachedBlock{ptr, Clock::now()});
+        ++mStats.blocksCached;
+        mStats.bytesCached += block.size;
+        return cudaSuccess;
+    }
+
+    //!
+    //! \brief Gives back the blocks idle for at least idleFor, all of them by default.
+    //!        Returns the number of bytes released.
+    //!
+    size_t trim(std::chrono::milliseconds idleFor = std::chrono::milliseconds(0))
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return releaseIdle(Clock::now() - idleFor);
+    }
+
+    //!
+    //! \brief Gives back the idle blocks of stream, which must not be used afterwards: call it
+    //!        before destroying the stream, once the blocks used on it are freed.
+    //!        Returns the number of bytes released.
+    //!
+    size_t trimStream(cudaStream_t stream)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        size_t released = 0;
+        for (auto list = mFreeLists.begin(); list != mFreeLists.end();)
+        {
+            if (std::get<1>(list->first) != stream)
+            {
+                ++list;
+                continue;
+            }
+            size_t size = std::get<2>(list->first);
+            for (const CachedBlock& block : list->second)
+            {
+                cudaFree(block.ptr);
+                ++mStats.releases;
+                --mStats.blocksCached;
+                mStats.bytesCached -= size;
+                released += size;
+            }
+            list = mFreeLists.erase(list);
+        }
+        return released;
+    }
+
+    //!
+    //! \brief Caps the bytes kept in the free lists, 0 for no cap.
+    //!
+    void setMaxCachedBytes(size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mMaxCachedBytes = bytes;
+    }
+
+    DeviceAllocatorStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStats;
+    }
+
+private:
+    struct LiveBlock
+    {
+        int device;
+        cudaStream_t stream;
+        size_t size;
+        size_t requested;
+    };
+
+    struct CachedBlock
+    {
+        void* ptr;
+        Clock::time_point freedAt;
+    };
+
+    using FreeListKey = std::tuple<int, cudaStream_t, size_t>;
+
+    //! Frees the cached blocks freed no later than freedBefore, mMutex held.
+    size_t releaseIdle(Clock::time_point freedBefore)
+    {
+        size_t released = 0;
+        for (auto list = mFreeLists.begin(); list != mFreeLists.end();)
+        {
+            std::vector<CachedBlock>& blocks = list->second;
+            size_t size = std::get<2>(list->first);
+            // blocks are pushed in the order they were freed, the oldest are at the front
+            auto idle = blocks.begin();
+            while (idle != blocks.end() && idle->freedAt <= freedBefore)
+            {
+                cudaFree(idle->ptr);
+                ++idle;
+                ++mStats.releases;
+                --mStats.blocksCached;
+                mStats.bytesCached -= size;
+                released += size;
+            }
+            blocks.erase(blocks.begin(), idle);
+            list = blocks.empty() ? mFreeLists.erase(list) : std::next(list);
+        }
+        return released;
+    }
+
+    mutable std::mutex mMutex;
+    std::map<FreeListKey, std::vector<CachedBlock>> mFreeLists;
+    std::unordered_map<void*, LiveBlock> mLive;
+    DeviceAllocatorStats mStats;
+    size_t mMaxCachedBytes{kDEFAULT_MAX_CACHED_BYTES};
+};
+
+} // namespace dtrCommon
+
+#endif // TENSORRT_DEVICE_ALLOCATOR_H
@@ -0,0 +1,479 @@
+#ifndef TENSORRT_HOST_ARENA_H
+#define TENSORRT_HOST_ARENA_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace dtrCommon
+{
+
+//!
+//! \brief Counters of a HostArena, summed over its threads.
+//!
+struct HostArenaStats
+{
+    size_t allocations{0};
+    size_t threadCacheHits{0};   //!< allocations served by the cache of the calling thread
+    size_t centralHits{0};       //!< allocations served by the cache shared by the threads
+    size_t systemAllocations{0}; //!< allocations that went to the system
+    size_t systemReleases{0};    //!< blocks given back to the system
+    size_t bytesInUse{0};        //!< bytes of the blocks handed out
+    size_t bytesCached{0};       //!< bytes of the idle blocks in the caches
+    size_t lockFailures{0};      //!< kLOCK allocations mlock() refused
+
+    double hitRate() const
+    {
+        return allocations ? static_cast<double>(threadCacheHits + centralHits) / allocations : 0.0;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const HostArenaStats& value)
+{
+    out << value.allocations << " allocations, " << std::fixed << std::setprecision(1) << value.hitRate() * 100
+        << "% cached (" << value.threadCacheHits << " thread, " << value.centralHits << " central), "
+        << (value.bytesInUse >> 10) << " KB in use, " << (value.bytesCached >> 10) << " KB cached";
+    return out;
+}
+
+//!
+//! \brief A size-class allocator of aligned host memory with thread-local caches.
+//!
+//! \details Requests are rounded up to one of four size classes per power of two. A freed block
+//!          goes to the cache of the freeing thread, past kMAX_THREAD_CACHE_BYTES or for blocks
+//!          over kMAX_THREAD_CACHED_SIZE to a cache shared by the threads, and past
+//!          maxCachedBytes back to the system, so steady-state allocations take no global lock.
+//!          Blocks are aligned to the alignment of the arena, 16 to 4096 bytes, with a header in
+//!          front of them. kHUGE_PAGES blocks are 2 MB aligned, advised to use transparent huge
+//!          pages and never cached. kPREFAULT touches every page of the block before it is
+//!          returned, kLOCK also mlock()s it, for buffers that must not page fault in the hot path.
+//!
+class HostArena
+{
+public:
+    enum Flags : unsigned int
+    {
+        kPREFAULT = 1,
+        kLOCK = 2,
+        kHUGE_PAGES = 4
+    };
+
+    static const size_t kMIN_BLOCK_SIZE = 64;
+    static const size_t kMAX_ALIGNMENT = 4096;
+    static const size_t kHUGE_PAGE_SIZE = 2 << 20;
+    static const size_t kMAX_THREAD_CACHED_SIZE = 1 << 20;
+    static const size_t kMAX_THREAD_CACHE_BYTES = 8 << 20;
+
+    explicit HostArena(size_t alignment = 64)
+        : mAlignment(alignment)
+        , mCentral(std::make_shared<Central>())
+    {
+        assert(alignment >= sizeof(Header) && alignment <= kMAX_ALIGNMENT && !(alignment & (alignment - 1)));
+    }
+
+    HostArena(const HostArena&) = delete;
+    HostArena& operator=(const HostArena&) = delete;
+
+    ~HostArena() { trim(); }
+
+    //!
+    //! \brief The arena behind fastAlloc() and fastFree(), 64 byte aligned.
+    //!
+    //! \details It is never destroyed, blocks may be freed by static destructors.
+    //!
+    static HostArena& instance()
+    {
+        static HostArena* arena = new HostArena();
+        return *arena;
+    }
+
+    //!
+    //! \brief Returns the size class size is rounded up to.
+    //!
+    static size_t blockSize(size_t size)
+    {
+        if (size <= kMIN_BLOCK_SIZE)
+            return kMIN_BLOCK_SIZE;
+        size_t power = kMIN_BLOCK_SIZE;
+        while (power <= size / 2)
+            power *= 2;
+        size_t step = power / 4;
+        return (size + step - 1) / step * step;
+    }
+
+    size_t alignment() const { return mAlignment; }
+
+    //!
+    //! \brief Returns size bytes aligned to alignment(), 2 MB with kHUGE_PAGES, nullptr if the
+    //!        system is out of memory.
+    //!
+    void* allocate(size_t size, unsigned int flags = 0)
+    {
+        if (flags & kHUGE_PAGES)
+            return allocateHuge(size, flags);
+        size_t block = blockSize(size);
+        size_t index = classIndex(block);
+        ThreadCache& cache = threadCache();
+        void* ptr = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            ++cache.counters.allocations;
+            cache.counters.bytesInUse += block;
+            if (index < cache.lists.size() && !cache.lists[index].empty())
+            {
+                ptr = cache.lists[index].back();
+                cache.lists[index].pop_back();
+                cache.bytes -= block;
+                cache.counters.bytesCached -= block;
+                ++cache.counters.threadCacheHits;
+            }
+        }
+        if (!ptr)
+            ptr = allocateShared(block, index);
+        if (!ptr)
+        {
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            cache.counters.bytesInUse -= block;
+            return nullptr;
+        }
+        prepare(ptr, block, flags);
+        return ptr;
+    }
+
+    //!
+    //! \brief Returns ptr, a block of this arena or nullptr, to the caches.
+    //!
+    void free(void* ptr)
+    {
+        if (!ptr)
+            return;
+        if (reinterpret_cast<uintptr_t>(ptr) % kHUGE_PAGE_SIZE == 0 && freeHuge(ptr))
+            return;
+        Header* header = headerOf(ptr);
+        assert(header->magic == kMAGIC && "freeing a block HostArena did not allocate");
+        size_t block = header->size;
+        size_t index = classIndex(block);
+        if (block <= kMAX_THREAD_CACHED_SIZE)
+        {
+            ThreadCache& cache = threadCache();
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            cache.counters.bytesInUse -= block;
+            if (cache.bytes + block <= kMAX_THREAD_CACHE_BYTES)
+            {
+                if (cache.lists.size() <= index)
+                    cache.lists.resize(index + 1);
+                cache.lists[index].push_back(ptr);
+                cache.bytes += block;
+                cache.counters.bytesCached += block;
+                return;
+            }
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(mCentral->mutex);
+            mCentral->counters.bytesInUse -= block;
+        }
+        freeShared(ptr, block, index);
+    }
+
+    //!
+    //! \brief Gives every cached block back to the system, those of the other threads too.
+    //!        Returns the number of bytes released.
+    //!
+    size_t trim()
+    {
+        std::lock_guard<std::mutex> lock(mCentral->mutex);
+        size_t released = 0;
+        for (auto& list : mCentral->lists)
+        {
+            for (void* ptr : list)
+                released += release(ptr);
+            mCentral->counters.systemReleases += list.size();
+            list.clear();
+        }
+        mCentral->counters.bytesCached -= mCentral->bytes;
+        for (ThreadCache* cache : mCentral->caches)
+        {
+            std::lock_guard<std::mutex> cacheLock(cache->mutex);
+            for (auto& list : cache->lists)
+            {
+                for (void* ptr : list)
+                    released += release(ptr);
+                cache->counters.systemReleases += list.size();
+                list.clear();
+            }
+            cache->counters.bytesCached -= cache->bytes;
+            cache->bytes = 0;
+        }
+        mCentral->bytes = 0;
+        return released;
+    }
+
+    //!
+    //! \brief Caps the bytes of the cache shared by the threads, 256 MB by default.
+    //!
+    void setMaxCachedBytes(size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mCentral->mutex);
+        mCentral->maxBytes = bytes;
+    }
+
+    HostArenaStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(mCentral->mutex);
+        HostArenaStats total = mCentral->counters;
+        for (ThreadCache* cache : mCentral->caches)
+        {
+            std::lock_guard<std::mutex> cacheLock(cache->mutex);
+            add(total, cache->counters);
+        }
+        return total;
+    }
+
+private:
+    static const uint16_t kMAGIC = 0x6474;
+
+    //! In front of every block but the huge page ones.
+    struct Header
+    {
+        size_t size;
+        uint16_t flags;
+        uint16_t magic;
+        uint32_t alignment; //!< the allocation starts this far in front of the block
+    };
+
+    struct Central;
+
+    //!
+    //! \brief The cache of one thread. Only its thread uses it, but for trim() and stats(), so
+    //!        its mutex is hardly ever contended. When the thread exits the blocks move to the
+    //!        shared cache, or to the system if the arena is gone.
+    //!
+    struct ThreadCache
+    {
+        std::mutex mutex;
+        std::vector<std::vector<void*>> lists;
+        size_t bytes{0};
+        HostArenaStats counters;
+        std::weak_ptr<Central> central;
+
+        ~ThreadCache()
+        {
+            std::shared_ptr<Central> shared = central.lock();
+            if (!shared)
+            {
+                for (auto& list : lists)
+                    for (void* ptr : list)
+                        release(ptr);
+                return;
+            }
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            for (size_t index = 0; index < lists.size(); ++index)
+            {
+                for (void* ptr : lists[index])
+                {
+                    size_t block = headerOf(ptr)->size;
+                    counters.bytesCached -= block;
+                    shared->push(ptr, block, index);
+                }
+            }
+            add(shared->counters, counters);
+            shared->caches.erase(std::find(shared->caches.begin(), shared->caches.end(), this));
+        }
+    };
+
+    struct Central
+    {
+        std::mutex mutex;
+        std::vector<std::vector<void*>> lists;
+        size_t bytes{0};
+        size_t maxBytes{256 << 20};
+        HostArenaStats counters;
+        std::vector<ThreadCache*> caches;
+        std::unordered_map<void*, std::pair<size_t, unsigned int>> hugeBlocks;
+
+        //! Caches ptr, or gives it back to the system past maxBytes, mutex held.
+        void push(void* ptr, size_t block, size_t index)
+        {
+            if (bytes + block > maxBytes)
+            {
+                release(ptr);
+                ++counters.systemReleases;
+                return;
+            }
+            if (lists.size() <= index)
+                lists.resize(index + 1);
+            lists[index].push_back(ptr);
+            bytes += block;
+            counters.bytesCached += block;
+        }
+    };
+
+    static Header* headerOf(void* ptr) { return static_cast<Header*>(ptr) - 1; }
+
+    static size_t classIndex(size_t block)
+    {
+        size_t power = kMIN_BLOCK_SIZE;
+        size_t index = 0;
+        while (power * 2 <= block)
+        {
+            power *= 2;
+            index += 4;
+        }
+        return index + (block - power) / (power / 4);
+    }
+
+    static void add(HostArenaStats& total, const HostArenaStats& counters)
+    {
+        // a block freed by another thread than the one that allocated it leaves one
+        // counter below zero, unsigned sums still add up
+        total.allocations += counters.allocations;
+        total.threadCacheHits += counters.threadCacheHits;
+        total.centralHits += counters.centralHits;
+        total.systemAllocations += counters.systemAllocations;
+        total.systemReleases += counters.systemReleases;
+        total.bytesInUse += counters.bytesInUse;
+        total.bytesCached += counters.bytesCached;
+        total.lockFailures += counters.lockFailures;
+    }
+
+    //! Gives a block back to the system and returns its size.
+    static size_t release(void* ptr)
+    {
+        Header* header = headerOf(ptr);
+        size_t block = header->size;
+        if (header->flags & kLOCK)
+            munlock(ptr, block);
+        ::free(static_cast<char*>(ptr) - header->alignment);
+        return block;
+    }
+
+    ThreadCache& threadCache()
+    {
+        thread_local std::vector<std::unique_ptr<ThreadCache>> caches;
+        thread_local std::vector<std::weak_ptr<Central>> owners;
+        for (size_t i = 0; i < caches.size(); ++i)
+        {
+            if (!owners[i].owner_before(mCentral) && !mCentral.owner_before(owners[i]))
+                return *caches[i];
+        }
+        std::unique_ptr<ThreadCache> cache{new ThreadCache()};
+        cache->central = mCentral;
+        {
+            std::lock_guard<std::mutex> lock(mCentral->mutex);
+            mCentral->caches.push_back(cache.get());
+        }
+        caches.push_back(std::move(cache));
+        owners.push_back(mCentral);
+        return *caches.back();
+    }
+
+    void* allocateShared(size_t block, size_t index)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mCentral->mutex);
+            if (index < mCentral->lists.size() && !mCentral->lists[index].empty())
+            {
+                void* ptr = mCentral->lists[index].back();
+                mCentral->lists[index].pop_back();
+                mCentral->bytes -= block;
+                mCentral->counters.bytesCached -= block;
+                ++mCentral->counters.centralHits;
+                return ptr;
+            }
+            ++mCentral->counters.systemAllocations;
+        }
+        void* base = nullptr;
+        if (posix_memalign(&base, mAlignment, mAlignment + block) != 0)
+            return nullptr;
+        void* ptr = static_cast<char*>(base) + mAlignment;
+        Header* header = headerOf(ptr);
+        header->size = block;
+        header->flags = 0;
+        header->magic = kMAGIC;
+        header->alignment = static_cast<uint32_t>(mAlignment);
+        return ptr;
+    }
+
+    void freeShared(void* ptr, size_t block, size_t index)
+    {
+        std::lock_guard<std::mutex> lock(mCentral->mutex);
+        mCentral->push(ptr, block, index);
+    }
+
+    //! Applies kPREFAULT and kLOCK to a block about to be handed out.
+    void prepare(void* ptr, size_t size, unsigned int flags)
+    {
+        if (flags & (kPREFAULT | kLOCK))
+        {
+            // a write to every page maps it, reads could map the shared zero page
+            static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            for (size_t offset = 0; offset < size; offset += pageSize)
+                static_cast<volatile char*>(ptr)[offset] = 0;
+        }
+        if (flags & kLOCK)
+        {
+            bool locked = mlock(ptr, size) == 0;
+            std::lock_guard<std::mutex> lock(mCentral->mutex);
+            if (!locked)
+                ++mCentral->counters.lockFailures;
+            else if (!(flags & kHUGE_PAGES))
+                headerOf(ptr)->flags |= kLOCK;
+            else
+                mCentral->hugeBlocks[ptr].second |= kLOCK;
+        }
+    }
+
+    void* allocateHuge(size_t size, unsigned int flags)
+    {
+        size_t block = (std::max<size_t>(size, 1) + kHUGE_PAGE_SIZE - 1) / kHUGE_PAGE_SIZE * kHUGE_PAGE_SIZE;
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, kHUGE_PAGE_SIZE, block) != 0)
+            return nullptr;
+#ifdef MADV_HUGEPAGE
+        // only a hint, without transparent huge pages the block keeps small pages
+        madvise(ptr, block, MADV_HUGEPAGE);
+#endif
+        {
+            std::lock_guard<std::mutex> lock(mCentral->mutex);
+            mCentral->hugeBlocks[ptr] = std::make_pair(block, 0u);
+            ++mCentral->counters.allocations;
+            ++mCentral->counters.systemAllocations;
+            mCentral->counters.bytesInUse += block;
+        }
+        prepare(ptr, block, flags);
+        return ptr;
+    }
+
+    bool freeHuge(void* ptr)
+    {
+        std::lock_guard<std::mutex> lock(mCentral->mutex);
+        auto it = mCentral->hugeBlocks.find(ptr);
+        if (it == mCentral->hugeBlocks.end())
+            return false;
+        if (it->second.second & kLOCK)
+            munlock(ptr, it->second.first);
+        mCentral->counters.bytesInUse -= it->second.first;
+        ++mCentral->counters.systemReleases;
+        mCentral->hugeBlocks.erase(it);
+        ::free(ptr);
+        return true;
+    }
+
+    size_t mAlignment;
+    std::shared_ptr<Central> mCentral;
+};
+
+} // namespace dtrCommon
+
+#endif // TENSORRT_HOST_ARENA_H
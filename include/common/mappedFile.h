@@ -0,0 +1,124 @@
+#ifndef DEPLOY_TENSORRT_MAPPED_FILE_H_
+#define DEPLOY_TENSORRT_MAPPED_FILE_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstddef>
+#include <string>
+
+namespace dtrCommon
+{
+
+//!
+//! \brief  The MappedFile class maps a whole file read-only into memory.
+//!
+//! \details Serialized engine plans are handed to IRuntime::deserializeCudaEngine straight
+//!          from the page cache, instead of being copied into a std::vector first. This
+//!          keeps a single copy of the plan in host memory and lets the kernel read the
+//!          file while deserialization walks through it.
+//!
+class MappedFile
+{
+public:
+    enum class Prefetch
+    {
+        kNONE,      //!< Pages are read on first access
+        kREADAHEAD, //!< Start an asynchronous sequential readahead of the whole file
+        kPOPULATE   //!< Read the whole file before the constructor returns (MAP_POPULATE)
+    };
+
+    MappedFile() = default;
+
+    //!
+    //! \brief Maps path. Check good() for failure, an empty file is never mapped.
+    //!
+    explicit MappedFile(const std::string& path, Prefetch prefetch = Prefetch::kREADAHEAD)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return;
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+            if (prefetch == Prefetch::kPOPULATE)
+                flags |= MAP_POPULATE;
+#endif
+            void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, flags, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                mData = data;
+                mSize = static_cast<size_t>(st.st_size);
+                if (prefetch == Prefetch::kREADAHEAD)
+                {
+                    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+                    ::madvise(mData, mSize, MADV_SEQUENTIAL);
+                    ::madvise(mData, mSize, MADV_WILLNEED);
+                }
+            }
+        }
+        // the mapping stays valid after the descriptor is closed
+        ::close(fd);
+    }
+
+    MappedFile(MappedFile&& rhs)
+        : mData(rhs.mData)
+        , mSize(rhs.mSize)
+    {
+        rhs.mData = nullptr;
+        rhs.mSize = 0;
+    }
+
+    MappedFile& operator=(MappedFile&& rhs)
+    {
+        if (this != &rhs)
+        {
+            unmap();
+            mData = rhs.mData;
+            mSize = rhs.mSize;
+            rhs.mData = nullptr;
+            rhs.mSize = 0;
+        }
+        return *this;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() { unmap(); }
+
+    //!
+    //! \brief Returns true if the file is mapped.
+    //!
+    bool good() const { return mData != nullptr; }
+    explicit operator bool() const { return good(); }
+
+    //!
+    //! \brief Returns the first byte of the mapping, nullptr if nothing is mapped.
+    //!
+    const void* data() const { return mData; }
+
+    //!
+    //! \brief Returns the size of the mapping (and of the file) in bytes.
+    //!
+    size_t size() const { return mSize; }
+
+private:
+    void unmap()
+    {
+        if (mData)
+            ::munmap(mData, mSize);
+        mData = nullptr;
+        mSize = 0;
+    }
+
+    void* mData{nullptr};
+    size_t mSize{0};
+};
+
+} // namespace dtrCommon
+
+#endif // DEPLOY_TENSORRT_MAPPED_FILE_H_
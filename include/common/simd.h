@@ -0,0 +1,74 @@
+#ifndef TENSORRT_SIMD_H
+#define TENSORRT_SIMD_H
+
+#include <cstdlib>
+#include <cstring>
+
+//! Defined when the x86 kernels, their intrinsics and target attributes can be compiled.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DTR_SIMD_X86 1
+#endif
+
+namespace dtrCommon
+{
+
+//!
+//! \brief The widest vector instructions a host kernel may use.
+//!
+//! \details Kernels are compiled for every level with target attributes and chosen at run time,
+//!          so one binary runs the best path the CPU has. Each level implies the ones below.
+//!          Off x86 only the scalar kernels are compiled and every level runs them.
+//!
+enum class SimdLevel : int
+{
+    kSCALAR = 0,
+    kSSE = 1,    //!< SSE4.1
+    kAVX2 = 2,   //!< AVX2, FMA and F16C
+    kAVX512 = 3, //!< AVX-512 F, BW and VL
+};
+
+inline const char* simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::kSCALAR: return "scalar";
+    case SimdLevel::kSSE: return "sse4.1";
+    case SimdLevel::kAVX2: return "avx2";
+    case SimdLevel::kAVX512: return "avx512";
+    }
+    return "";
+}
+
+//!
+//! \brief Returns the SimdLevel of the CPU, capped by the DTR_SIMD environment variable
+//!        (scalar, sse4.1, avx2 or avx512) when it is set.
+//!
+inline SimdLevel cpuSimdLevel()
+{
+    static const SimdLevel level = [] {
+        SimdLevel found = SimdLevel::kSCALAR;
+#ifdef DTR_SIMD_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse4.1"))
+            found = SimdLevel::kSSE;
+        if (found == SimdLevel::kSSE && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")
+            && __builtin_cpu_supports("f16c"))
+            found = SimdLevel::kAVX2;
+        if (found == SimdLevel::kAVX2 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+            && __builtin_cpu_supports("avx512vl"))
+            found = SimdLevel::kAVX512;
+#endif
+        const char* cap = getenv("DTR_SIMD");
+        for (int i = 0; cap && i < static_cast<int>(found); ++i)
+        {
+            if (!strcmp(cap, simdLevelName(static_cast<SimdLevel>(i))))
+                return static_cast<SimdLevel>(i);
+        }
+        return found;
+    }();
+    return level;
+}
+
+} // namespace dtrCommon
+
+#endif // TENSORRT_SIMD_H
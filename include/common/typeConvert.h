@@ -0,0 +1,540 @@
+#ifndef TENSORRT_TYPE_CONVERT_H
+#define TENSORRT_TYPE_CONVERT_H
+
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#ifdef DTR_SIMD_X86
+#include <immintrin.h>
+
+// the avx512 intrinsics of gcc 12 self-initialize their undefined operands, which -Wall flags when inlined
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace dtrCommon
+{
+
+//!
+//! \brief Returns the float of the IEEE half precision value h. Every half is exact in a float;
+//!        NaNs keep their payload and come out quiet, as F16C converts them.
+//!
+inline float halfToFloat(uint16_t h)
+{
+    const uint32_t kExponent = 0x7c00u << 13;
+    uint32_t bits = (h & 0x7fffu) << 13;
+    uint32_t exponent = bits & kExponent;
+    bits += (127 - 15) << 23;
+    if (exponent == kExponent)
+    {
+        // Inf or NaN
+        bits += (128 - 16) << 23;
+        if (bits & 0x007fffffu)
+            bits |= 0x00400000u;
+    }
+    else if (exponent == 0)
+    {
+        // zero or subnormal, normalized by the float unit
+        const uint32_t kMagic = 113u << 23;
+        float value, magic;
+        bits += 1 << 23;
+        memcpy(&value, &bits, sizeof(value));
+        memcpy(&magic, &kMagic, sizeof(magic));
+        value -= magic;
+        memcpy(&bits, &value, sizeof(bits));
+    }
+    bits |= static_cast<uint32_t>(h & 0x8000u) << 16;
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+//!
+//! \brief Returns the IEEE half precision value of f rounded to nearest even, with overflow to
+//!        Inf and NaNs kept quiet with the top of their payload, bit for bit what F16C returns.
+//!
+inline uint16_t floatToHalf(float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+    uint32_t half;
+    if (bits >= (127u + 16) << 23)
+    {
+        // Inf, NaN or too large
+        half = bits > 0x7f800000u ? 0x7e00u | ((bits >> 13) & 0x3ffu) : 0x7c00u;
+    }
+    else if (bits < 113u << 23)
+    {
+        // the float unit rounds the mantissa into place when 0.5f is added
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        value += 0.5f;
+        memcpy(&half, &value, sizeof(half));
+        half -= 126u << 23;
+    }
+    else
+    {
+        bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xfffu + ((bits >> 13) & 1u);
+        half = bits >> 13;
+    }
+    return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+namespace detail
+{
+
+//!
+//! \brief The range of round(x * inverse scale) that lands in [min, max] of T once zeroPoint is
+//!        added, as floats inside it. int32 is only quantized with a zeroPoint of 0.
+//!
+template <typename T>
+inline void quantizeBounds(int32_t zeroPoint, float& lo, float& hi)
+{
+    double low = static_cast<double>(std::numeric_limits<T>::min()) - zeroPoint;
+    double high = static_cast<double>(std::numeric_limits<T>::max()) - zeroPoint;
+    // the largest float an int32 conversion does not overflow
+    high = std::min(high, 2147483520.0);
+    lo = static_cast<float>(low);
+    hi = static_cast<float>(high);
+    if (lo < low)
+        lo = std::nextafter(lo, std::numeric_limits<float>::infinity());
+    if (hi > high)
+        hi = std::nextafter(hi, -std::numeric_limits<float>::infinity());
+}
+
+template <typename T>
+inline void dequantizeScalar(const T* src, float* dst, size_t count, float scale, float zeroPoint)
+{
+    for (size_t i = 0; i < count; ++i)
+        dst[i] = (static_cast<float>(src[i]) - zeroPoint) * scale;
+}
+
+template <typename T>
+inline void quantizeScalar(const float* src, T* dst, size_t count, float inverse, float lo, float hi, int32_t zeroPoint)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        // the comparisons of minps and maxps, so NaN saturates the same way on every level
+        float value = src[i] * inverse;
+        value = value < hi ? value : hi;
+        value = value > lo ? value : lo;
+        dst[i] = static_cast<T>(static_cast<int32_t>(std::nearbyint(value)) + zeroPoint);
+    }
+}
+
+inline void halfToFloatScalar(const uint16_t* src, float* dst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        dst[i] = halfToFloat(src[i]);
+}
+
+inline void floatToHalfScalar(const float* src, uint16_t* dst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        dst[i] = floatToHalf(src[i]);
+}
+
+#ifdef DTR_SIMD_X86
+// SSE4.1 has no half conversion, halfToFloat() and floatToHalf() four lanes at a time
+__attribute__((target("sse4.1"))) inline void halfToFloatSse(const uint16_t* src, float* dst, size_t count)
+{
+    const __m128i kExponent = _mm_set1_epi32(0x7c00 << 13);
+    const __m128 kMagic = _mm_castsi128_ps(_mm_set1_epi32(113 << 23));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i h = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+        __m128i bits = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7fff)), 13);
+        __m128i exponent = _mm_and_si128(bits, kExponent);
+        bits = _mm_add_epi32(bits, _mm_set1_epi32((127 - 15) << 23));
+        __m128i infNan = _mm_cmpeq_epi32(exponent, kExponent);
+        __m128i quiet = _mm_andnot_si128(
+            _mm_cmpeq_epi32(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_setzero_si128()),
+            _mm_set1_epi32(0x00400000));
+        bits = _mm_add_epi32(bits, _mm_and_si128(infNan, _mm_set1_epi32((128 - 16) << 23)));
+        bits = _mm_or_si128(bits, _mm_and_si128(infNan, quiet));
+        __m128 subnormal = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(bits, _mm_set1_epi32(1 << 23))), kMagic);
+        bits = _mm_blendv_epi8(bits, _mm_castps_si128(subnormal), _mm_cmpeq_epi32(exponent, _mm_setzero_si128()));
+        bits = _mm_or_si128(bits, _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16));
+        _mm_storeu_ps(dst + i, _mm_castsi128_ps(bits));
+    }
+    halfToFloatScalar(src + i, dst + i, count - i);
+}
+
+__attribute__((target("sse4.1"))) inline void floatToHalfSse(const float* src, uint16_t* dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i halves[2];
+        for (int k = 0; k < 2; ++k)
+        {
+            __m128i bits = _mm_castps_si128(_mm_loadu_ps(src + i + 4 * k));
+            __m128i sign = _mm_and_si128(bits, _mm_set1_epi32(0x80000000));
+            bits = _mm_xor_si128(bits, sign);
+            __m128i shifted = _mm_srli_epi32(bits, 13);
+            __m128i nan = _mm_and_si128(_mm_cmpgt_epi32(bits, _mm_set1_epi32(0x7f800000)),
+                _mm_or_si128(_mm_set1_epi32(0x200), _mm_and_si128(shifted, _mm_set1_epi32(0x3ff))));
+            __m128i infNan = _mm_or_si128(_mm_set1_epi32(0x7c00), nan);
+            __m128i subnormal = _mm_sub_epi32(
+                _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(bits), _mm_set1_ps(0.5f))), _mm_set1_epi32(126 << 23));
+            __m128i normal = _mm_add_epi32(bits, _mm_set1_epi32(static_cast<int>(0xc8000fffu)));
+            normal = _mm_srli_epi32(_mm_add_epi32(normal, _mm_and_si128(shifted, _mm_set1_epi32(1))), 13);
+            __m128i half = _mm_blendv_epi8(normal, subnormal, _mm_cmplt_epi32(bits, _mm_set1_epi32(113 << 23)));
+            half = _mm_blendv_epi8(half, infNan, _mm_cmpgt_epi32(bits, _mm_set1_epi32(((127 + 16) << 23) - 1)));
+            halves[k] = _mm_or_si128(half, _mm_srli_epi32(sign, 16));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi32(halves[0], halves[1]));
+    }
+    floatToHalfScalar(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx2,f16c"))) inline void halfToFloatAvx2(const uint16_t* src, float* dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+    halfToFloatScalar(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx2,f16c"))) inline void floatToHalfAvx2(const float* src, uint16_t* dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+            _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+    floatToHalfScalar(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl,f16c"))) inline void halfToFloatAvx512(
+    const uint16_t* src, float* dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+        _mm512_storeu_ps(dst + i, _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i))));
+    halfToFloatScalar(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl,f16c"))) inline void floatToHalfAvx512(
+    const float* src, uint16_t* dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+            _mm512_cvtps_ph(_mm512_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+    floatToHalfScalar(src + i, dst + i, count - i);
+}
+
+// widening loads of 4, 8 or 16 integers and narrowing stores of as many clamped int32s
+__attribute__((target("sse4.1"))) inline __m128i load4(const int8_t* src)
+{
+    int32_t bytes;
+    memcpy(&bytes, src, sizeof(bytes));
+    return _mm_cvtepi8_epi32(_mm_cvtsi32_si128(bytes));
+}
+
+__attribute__((target("sse4.1"))) inline __m128i load4(const uint8_t* src)
+{
+    int32_t bytes;
+    memcpy(&bytes, src, sizeof(bytes));
+    return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes));
+}
+
+__attribute__((target("sse4.1"))) inline __m128i load4(const int32_t* src)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+}
+
+__attribute__((target("sse4.1"))) inline void store4(int8_t* dst, __m128i value)
+{
+    value = _mm_packs_epi32(value, value);
+    int32_t bytes = _mm_cvtsi128_si32(_mm_packs_epi16(value, value));
+    memcpy(dst, &bytes, sizeof(bytes));
+}
+
+__attribute__((target("sse4.1"))) inline void store4(uint8_t* dst, __m128i value)
+{
+    value = _mm_packs_epi32(value, value);
+    int32_t bytes = _mm_cvtsi128_si32(_mm_packus_epi16(value, value));
+    memcpy(dst, &bytes, sizeof(bytes));
+}
+
+__attribute__((target("sse4.1"))) inline void store4(int32_t* dst, __m128i value)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), value);
+}
+
+__attribute__((target("avx2"))) inline __m256i load8(const int8_t* src)
+{
+    return _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)));
+}
+
+__attribute__((target("avx2"))) inline __m256i load8(const uint8_t* src)
+{
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)));
+}
+
+__attribute__((target("avx2"))) inline __m256i load8(const int32_t* src)
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+}
+
+__attribute__((target("avx2"))) inline void store8(int8_t* dst, __m256i value)
+{
+    __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packs_epi16(words, words));
+}
+
+__attribute__((target("avx2"))) inline void store8(uint8_t* dst, __m256i value)
+{
+    __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(words, words));
+}
+
+__attribute__((target("avx2"))) inline void store8(int32_t* dst, __m256i value)
+{
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), value);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl"))) inline __m512i load16(const int8_t* src)
+{
+    return _mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl"))) inline __m512i load16(const uint8_t* src)
+{
+    return _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl"))) inline __m512i load16(const int32_t* src)
+{
+    return _mm512_loadu_si512(src);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl"))) inline void store16(int8_t* dst, __m512i value)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm512_cvtepi32_epi8(value));
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl"))) inline void store16(uint8_t* dst, __m512i value)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm512_cvtepi32_epi8(value));
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl"))) inline void store16(int32_t* dst, __m512i value)
+{
+    _mm512_storeu_si512(dst, value);
+}
+
+template <typename T>
+__attribute__((target("sse4.1"))) inline void dequantizeSse(
+    const T* src, float* dst, size_t count, float scale, float zeroPoint)
+{
+    const __m128 vScale = _mm_set1_ps(scale), vZeroPoint = _mm_set1_ps(zeroPoint);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(load4(src + i)), vZeroPoint), vScale));
+    dequantizeScalar(src + i, dst + i, count - i, scale, zeroPoint);
+}
+
+template <typename T>
+__attribute__((target("avx2"))) inline void dequantizeAvx2(
+    const T* src, float* dst, size_t count, float scale, float zeroPoint)
+{
+    const __m256 vScale = _mm256_set1_ps(scale), vZeroPoint = _mm256_set1_ps(zeroPoint);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(
+            dst + i, _mm256_mul_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(load8(src + i)), vZeroPoint), vScale));
+    dequantizeScalar(src + i, dst + i, count - i, scale, zeroPoint);
+}
+
+template <typename T>
+__attribute__((target("avx512f,avx512bw,avx512vl"))) inline void dequantizeAvx512(
+    const T* src, float* dst, size_t count, float scale, float zeroPoint)
+{
+    const __m512 vScale = _mm512_set1_ps(scale), vZeroPoint = _mm512_set1_ps(zeroPoint);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+        _mm512_storeu_ps(
+            dst + i, _mm512_mul_ps(_mm512_sub_ps(_mm512_cvtepi32_ps(load16(src + i)), vZeroPoint), vScale));
+    dequantizeScalar(src + i, dst + i, count - i, scale, zeroPoint);
+}
+
+// clamped before the conversion, so the narrowing stores never saturate and int32 never overflows
+template <typename T>
+__attribute__((target("sse4.1"))) inline void quantizeSse(
+    const float* src, T* dst, size_t count, float inverse, float lo, float hi, int32_t zeroPoint)
+{
+    const __m128 vInverse = _mm_set1_ps(inverse), vLo = _mm_set1_ps(lo), vHi = _mm_set1_ps(hi);
+    const __m128i vZeroPoint = _mm_set1_epi32(zeroPoint);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 value = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(src + i), vInverse), vHi), vLo);
+        store4(dst + i, _mm_add_epi32(_mm_cvtps_epi32(value), vZeroPoint));
+    }
+    quantizeScalar(src + i, dst + i, count - i, inverse, lo, hi, zeroPoint);
+}
+
+template <typename T>
+__attribute__((target("avx2"))) inline void quantizeAvx2(
+    const float* src, T* dst, size_t count, float inverse, float lo, float hi, int32_t zeroPoint)
+{
+    const __m256 vInverse = _mm256_set1_ps(inverse), vLo = _mm256_set1_ps(lo), vHi = _mm256_set1_ps(hi);
+    const __m256i vZeroPoint = _mm256_set1_epi32(zeroPoint);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 value = _mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i), vInverse), vHi), vLo);
+        store8(dst + i, _mm256_add_epi32(_mm256_cvtps_epi32(value), vZeroPoint));
+    }
+    quantizeScalar(src + i, dst + i, count - i, inverse, lo, hi, zeroPoint);
+}
+
+template <typename T>
+__attribute__((target("avx512f,avx512bw,avx512vl"))) inline void quantizeAvx512(
+    const float* src, T* dst, size_t count, float inverse, float lo, float hi, int32_t zeroPoint)
+{
+    const __m512 vInverse = _mm512_set1_ps(inverse), vLo = _mm512_set1_ps(lo), vHi = _mm512_set1_ps(hi);
+    const __m512i vZeroPoint = _mm512_set1_epi32(zeroPoint);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 value = _mm512_max_ps(_mm512_min_ps(_mm512_mul_ps(_mm512_loadu_ps(src + i), vInverse), vHi), vLo);
+        store16(dst + i, _mm512_add_epi32(_mm512_cvtps_epi32(value), vZeroPoint));
+    }
+    quantizeScalar(src + i, dst + i, count - i, inverse, lo, hi, zeroPoint);
+}
+
+#endif // DTR_SIMD_X86
+
+template <typename T>
+inline void dequantize(const T* src, float* dst, size_t count, float scale, int32_t zeroPoint, SimdLevel level)
+{
+    float zero = static_cast<float>(zeroPoint);
+    // a level the cpu lacks would die of SIGILL
+    switch (std::min(level, cpuSimdLevel()))
+    {
+#ifdef DTR_SIMD_X86
+    case SimdLevel::kAVX512: dequantizeAvx512(src, dst, count, scale, zero); break;
+    case SimdLevel::kAVX2: dequantizeAvx2(src, dst, count, scale, zero); break;
+    case SimdLevel::kSSE: dequantizeSse(src, dst, count, scale, zero); break;
+#endif
+    default: dequantizeScalar(src, dst, count, scale, zero); break;
+    }
+}
+
+template <typename T>
+inline void quantize(const float* src, T* dst, size_t count, float scale, int32_t zeroPoint, SimdLevel level)
+{
+    float inverse = 1.0f / scale, lo, hi;
+    quantizeBounds<T>(zeroPoint, lo, hi);
+    switch (std::min(level, cpuSimdLevel()))
+    {
+#ifdef DTR_SIMD_X86
+    case SimdLevel::kAVX512: quantizeAvx512(src, dst, count, inverse, lo, hi, zeroPoint); break;
+    case SimdLevel::kAVX2: quantizeAvx2(src, dst, count, inverse, lo, hi, zeroPoint); break;
+    case SimdLevel::kSSE: quantizeSse(src, dst, count, inverse, lo, hi, zeroPoint); break;
+#endif
+    default: quantizeScalar(src, dst, count, inverse, lo, hi, zeroPoint); break;
+    }
+}
+
+} // namespace detail
+
+//!
+//! \brief Converts count IEEE half precision values to floats, as halfToFloat() does.
+//!        Every bulk conversion runs at most at cpuSimdLevel(), whatever level asks for.
+//!
+inline void halfToFloat(const uint16_t* src, float* dst, size_t count, SimdLevel level = cpuSimdLevel())
+{
+    switch (std::min(level, cpuSimdLevel()))
+    {
+#ifdef DTR_SIMD_X86
+    case SimdLevel::kAVX512: detail::halfToFloatAvx512(src, dst, count); break;
+    case SimdLevel::kAVX2: detail::halfToFloatAvx2(src, dst, count); break;
+    case SimdLevel::kSSE: detail::halfToFloatSse(src, dst, count); break;
+#endif
+    default: detail::halfToFloatScalar(src, dst, count); break;
+    }
+}
+
+//!
+//! \brief Converts count floats to IEEE half precision values, as floatToHalf() does.
+//!
+inline void floatToHalf(const float* src, uint16_t* dst, size_t count, SimdLevel level = cpuSimdLevel())
+{
+    switch (std::min(level, cpuSimdLevel()))
+    {
+#ifdef DTR_SIMD_X86
+    case SimdLevel::kAVX512: detail::floatToHalfAvx512(src, dst, count); break;
+    case SimdLevel::kAVX2: detail::floatToHalfAvx2(src, dst, count); break;
+    case SimdLevel::kSSE: detail::floatToHalfSse(src, dst, count); break;
+#endif
+    default: detail::floatToHalfScalar(src, dst, count); break;
+    }
+}
+
+//!
+//! \brief Converts count integers to floats, dst[i] = (src[i] - zeroPoint) * scale computed in
+//!        float. The defaults convert the values as they are.
+//!
+inline void dequantize(const int8_t* src, float* dst, size_t count, float scale = 1.0f, int32_t zeroPoint = 0,
+    SimdLevel level = cpuSimdLevel())
+{
+    detail::dequantize(src, dst, count, scale, zeroPoint, level);
+}
+
+inline void dequantize(const uint8_t* src, float* dst, size_t count, float scale = 1.0f, int32_t zeroPoint = 0,
+    SimdLevel level = cpuSimdLevel())
+{
+    detail::dequantize(src, dst, count, scale, zeroPoint, level);
+}
+
+inline void dequantize(const int32_t* src, float* dst, size_t count, float scale = 1.0f, int32_t zeroPoint = 0,
+    SimdLevel level = cpuSimdLevel())
+{
+    detail::dequantize(src, dst, count, scale, zeroPoint, level);
+}
+
+//!
+//! \brief Converts count floats to integers, dst[i] = round(src[i] * (1 / scale)) + zeroPoint
+//!        rounded to nearest even and saturated to the range of the integer type. NaN
+//!        saturates to the maximum. scale must not be 0.
+//!
+inline void quantize(const float* src, int8_t* dst, size_t count, float scale = 1.0f, int32_t zeroPoint = 0,
+    SimdLevel level = cpuSimdLevel())
+{
+    detail::quantize(src, dst, count, scale, zeroPoint, level);
+}
+
+inline void quantize(const float* src, uint8_t* dst, size_t count, float scale = 1.0f, int32_t zeroPoint = 0,
+    SimdLevel level = cpuSimdLevel())
+{
+    detail::quantize(src, dst, count, scale, zeroPoint, level);
+}
+
+//!
+//! \brief Converts count floats to int32, dst[i] = round(src[i] * (1 / scale)) rounded to
+//!        nearest even and saturated to [-2^31, 2^31 - 128], the int32 range floats reach.
+//!
+inline void quantize(const float* src, int32_t* dst, size_t count, float scale = 1.0f, SimdLevel level = cpuSimdLevel())
+{
+    detail::quantize(src, dst, count, scale, 0, level);
+}
+
+} // namespace dtrCommon
+
+#ifdef DTR_SIMD_X86
+#pragma GCC diagnostic pop
+#endif
+
+#endif // TENSORRT_TYPE_CONVERT_H
@@ -13,6 +13,7 @@
 #include "NvCaffeParser.h"
 #include "NvInferPlugin.h"
 #include "common/common.h"
+#include "common/deviceAllocator.h"
 #include "common/logger.h"
 #include "common/argsParser.h"
 
@@ -127,12 +128,14 @@ void doInference(IExecutionContext& context, float* inputData, float* inputImInf
     const int bboxPredSize = batchSize * NMS_MAX_OUT * OUTPUT_BBOX_SIZE;
     const int clsProbSize = batchSize * NMS_MAX_OUT * OUTPUT_CLS_SIZE;
     const int roisSize = batchSize * NMS_MAX_OUT * 4;
-    // Create GPU buffers and a stream
-    CHECK(cudaMalloc(&buffers[inputIndex0], dataSize * sizeof(float)));      // data
-    CHECK(cudaMalloc(&buffers[inputIndex1], imInfoSize * sizeof(float)));    // im_info
-    CHECK(cudaMalloc(&buffers[outputIndex0], bboxPredSize * sizeof(float))); // bbox_pred
-    CHECK(cudaMalloc(&buffers[outputIndex1], clsProbSize * sizeof(float)));  // cls_prob
-    CHECK(cudaMalloc(&buffers[outputIndex2], roisSize * sizeof(float)));     // rois
+    // Create GPU buffers and a stream. The buffers are cached across inferences by the device allocator,
+    // the stream is synchronized before they are freed, so they are allocated for the default stream
+    dtrCommon::CachingDeviceAllocator& allocator = dtrCommon::CachingDeviceAllocator::instance();
+    CHECK(allocator.allocate(&buffers[inputIndex0], dataSize * sizeof(float)));      // data
+    CHECK(allocator.allocate(&buffers[inputIndex1], imInfoSize * sizeof(float)));    // im_info
+    CHECK(allocator.allocate(&buffers[outputIndex0], bboxPredSize * sizeof(float))); // bbox_pred
+    CHECK(allocator.allocate(&buffers[outputIndex1], clsProbSize * sizeof(float)));  // cls_prob
+    CHECK(allocator.allocate(&buffers[outputIndex2], roisSize * sizeof(float)));     // rois
 
     // 给异步操作创建流
     cudaStream_t stream;
@@ -149,11 +152,11 @@ void doInference(IExecutionContext& context, float* inputData, float* inputImInf
 
     // Release the stream and the buffers
     cudaStreamDestroy(stream);
-    CHECK(cudaFree(buffers[inputIndex0]));
-    CHECK(cudaFree(buffers[inputIndex1]));
-    CHECK(cudaFree(buffers[outputIndex0]));
-    CHECK(cudaFree(buffers[outputIndex1]));
-    CHECK(cudaFree(buffers[outputIndex2]));
+    CHECK(allocator.free(buffers[inputIndex0]));
+    CHECK(allocator.free(buffers[inputIndex1]));
+    CHECK(allocator.free(buffers[outputIndex0]));
+    CHECK(allocator.free(buffers[outputIndex1]));
+    CHECK(allocator.free(buffers[outputIndex2]));
 }
 
 void bboxTransformInvAndClip(std::vector<float>& rois, std::vector<float>& deltas, std::vector<float>& predBBoxes, float* imInfo,
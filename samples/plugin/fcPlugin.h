@@ -30,6 +30,8 @@
 
 #include "NvInfer.h"
 #include "common/common.h"
+#include "common/deviceAllocator.h"
+#include "common/typeConvert.h"
 #include "fp16.h"
 
 class FCPlugin : public nvinfer1::IPluginExt {
@@ -144,12 +146,12 @@ public:
 		CHECK(cudnnDestroy(mCudnn));
 		if (mDeviceKernel)
 		{
-			cudaFree(mDeviceKernel);
+			dtrCommon::CachingDeviceAllocator::instance().free(mDeviceKernel);
 			mDeviceKernel = nullptr;
 		}
 		if (mDeviceBias)
 		{
-			cudaFree(mDeviceBias);
+			dtrCommon::CachingDeviceAllocator::instance().free(mDeviceBias);
 			mDeviceBias = nullptr;
 		}
 	}
@@ -225,23 +227,27 @@ private:
 
 	void* copyToDevice(const void* data, size_t count) {
 		void* deviceData;
-		CHECK(cudaMalloc(&deviceData, count));
+		CHECK(dtrCommon::CachingDeviceAllocator::instance().allocate(&deviceData, count));
 		CHECK(cudaMemcpy(deviceData, data, count, cudaMemcpyHostToDevice));
 		return deviceData;
 	}
 
+	// fp16 weights to float and float weights to fp16
+	static void convertWeights(void* dst, const nvinfer1::Weights& weights) {
+		size_t count = static_cast<size_t>(weights.count);
+		if (weights.type == nvinfer1::DataType::kHALF) {
+			dtrCommon::halfToFloat(static_cast<const uint16_t*>(weights.values), static_cast<float*>(dst), count);
+		} else {
+			dtrCommon::floatToHalf(static_cast<const float*>(weights.values), static_cast<uint16_t*>(dst), count);
+		}
+	}
+
 	void convertAndCopyToDevice(void*& deviceWeights, const nvinfer1::Weights& weights) {
 		if (weights.type != mDataType) // Weights are converted in host memory first, if the type does not match
 		{
 			size_t size = weights.count * (mDataType == nvinfer1::DataType::kFLOAT ? sizeof(float) : sizeof(__half));
 			void* buffer = malloc(size);
-			for (int64_t v = 0; v < weights.count; ++v) {
-				if (mDataType == nvinfer1::DataType::kFLOAT) {
-					static_cast<float*>(buffer)[v] = fp16::__half2float(static_cast<const __half*>(weights.values)[v]);
-				} else {
-					static_cast<__half*>(buffer)[v] = fp16::__float2half(static_cast<const float*>(weights.values)[v]);
-				}
-			}
+			convertWeights(buffer, weights);
 			deviceWeights = copyToDevice(buffer, size);
 			free(buffer);
 		} else {
@@ -251,15 +257,7 @@ private:
 
 	void convertAndCopyToBuffer(char*& buffer, const nvinfer1::Weights& weights) {
 		if (weights.type != mDataType) {
-			for (int64_t v = 0; v < weights.count; ++v) {
-				if (mDataType == nvinfer1::DataType::kFLOAT) {
-					reinterpret_cast<float*>(buffer)[v]
-						= fp16::__half2float(static_cast<const __half*>(weights.values)[v]);
-				} else {
-					reinterpret_cast<__half*>(buffer)[v]
-						= fp16::__float2half(static_cast<const float*>(weights.values)[v]);
-				}
-			}
+			convertWeights(buffer, weights);
 		} else {
 			std::memcpy(buffer, weights.values, weights.count * type2size(mDataType));
 		}
@@ -19,6 +19,7 @@
 #include "fp16.h"
 #include "common/logger.h"
 #include "common/common.h"
+#include "common/deviceAllocator.h"
 #include "common/argsParser.h"
 
 using namespace nvinfer1;
@@ -102,9 +103,11 @@ void doInference(IExecutionContext& context, float* input, float* output, int ba
 	int inputIndex = engine.getBindingIndex(INPUT_BLOB_NAME),
 		outputIndex = engine.getBindingIndex(OUTPUT_BLOB_NAME);
 
-	// create GPU buffers and a stream
-	CHECK(cudaMalloc(&buffers[inputIndex], batchSize * INPUT_H * INPUT_W * sizeof(float)));
-	CHECK(cudaMalloc(&buffers[outputIndex], batchSize * OUTPUT_SIZE * sizeof(float)));
+	// create GPU buffers and a stream. The device allocator keeps the buffers for the next inference,
+	// they are allocated for the default stream since the stream is synchronized before they are freed
+	dtrCommon::CachingDeviceAllocator& allocator = dtrCommon::CachingDeviceAllocator::instance();
+	CHECK(allocator.allocate(&buffers[inputIndex], batchSize * INPUT_H * INPUT_W * sizeof(float)));
+	CHECK(allocator.allocate(&buffers[outputIndex], batchSize * OUTPUT_SIZE * sizeof(float)));
 
 	cudaStream_t stream;
 	CHECK(cudaStreamCreate(&stream));
@@ -117,8 +120,8 @@ void doInference(IExecutionContext& context, float* input, float* output, int ba
 
 	// release the stream and the buffers
 	cudaStreamDestroy(stream);
-	CHECK(cudaFree(buffers[inputIndex]));
-	CHECK(cudaFree(buffers[outputIndex]));
+	CHECK(allocator.free(buffers[inputIndex]));
+	CHECK(allocator.free(buffers[outputIndex]));
 }
 
 
@@ -23,6 +23,7 @@
 #include "common/buffers.h"
 #include "common/common.h"
 #include "common/logger.h"
+#include "common/mappedFile.h"
 
 using namespace nvinfer1;
 using namespace nvcaffeparser1;
@@ -545,16 +546,10 @@ static ICudaEngine *createEngine() {
 	ICudaEngine *engine;
 	// load directly from serialized engine file if deploy not specified
 	if (!gParams.loadEngine.empty()) {
-		std::vector<char> trtModelStream;
-		size_t size{0};
-		std::ifstream file(gParams.loadEngine, std::ios::binary);
-		if (file.good()) {
-			file.seekg(0, file.end);
-			size = file.tellg();
-			file.seekg(0, file.beg);
-			trtModelStream.resize(size);
-			file.read(trtModelStream.data(), size);
-			file.close();
+		dtrCommon::MappedFile plan(gParams.loadEngine);
+		if (!plan) {
+			LOG_ERROR(gLogger) << "Could not read " << gParams.loadEngine << std::endl;
+			return nullptr;
 		}
 
 		IRuntime *infer = createInferRuntime(gLogger.getTRTLogger());
@@ -562,7 +557,7 @@ static ICudaEngine *createEngine() {
 			infer->setDLACore(gParams.useDLACore);
 		}
 
-		engine = infer->deserializeCudaEngine(trtModelStream.data(), size, nullptr);
+		engine = infer->deserializeCudaEngine(plan.data(), plan.size(), nullptr);
 		LOG_INFO(gLogger) << gParams.loadEngine << " has been successfully loaded." << std::endl;
 
 		infer->destroy();
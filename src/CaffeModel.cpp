@@ -1,10 +1,103 @@
 #include <CaffeModel.h>
 #include <common/common.h>
+#include <common/mappedFile.h>
+#include <common/typeConvert.h>
+#include <DataBlobPool.h>
+#include <EngineCache.h>
+#include <LayoutConvert.h>
+#include <atomic>
 #include <cstring>
+#include <iomanip>
+
+namespace {
+const int64_t kMaxWorkspaceSize = 1_GB;
+
+// whether the current device shares its memory with the host
+bool integratedDevice() {
+	int device = 0;
+	cudaDeviceProp prop;
+	if (cudaGetDevice(&device) != cudaSuccess || cudaGetDeviceProperties(&prop, device) != cudaSuccess) {
+		cudaGetLastError();
+		return false;
+	}
+	return prop.integrated != 0;
+}
+
+// implicit batch bindings carry no batch dimension, fold the binding dims into CHW
+DataBlobShape blobShapeOf(const nvinfer1::Dims& dims, int batchSize) {
+	size_t c = dims.nbDims > 0 ? dims.d[0] : 1;
+	size_t h = dims.nbDims > 1 ? dims.d[1] : 1;
+	size_t w = 1;
+	for (int i = 2; i < dims.nbDims; ++i) {
+		w *= dims.d[i];
+	}
+	return DataBlobShape(batchSize, c, h, w);
+}
+
+double elapsedMs(std::chrono::high_resolution_clock::time_point begin) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count();
+}
+
+//! adds the time until the end of the scope to ms
+class PhaseTimer {
+public:
+	explicit PhaseTimer(double& ms)
+		: mMs(ms), mBegin(std::chrono::high_resolution_clock::now())
+	{ }
+	~PhaseTimer() { mMs += elapsedMs(mBegin); }
+private:
+	double& mMs;
+	std::chrono::high_resolution_clock::time_point mBegin;
+};
+
+bool sameBindings(const nvinfer1::ICudaEngine& a, const nvinfer1::ICudaEngine& b) {
+	if (a.getNbBindings() != b.getNbBindings()) {
+		return false;
+	}
+	for (int i = 0; i < a.getNbBindings(); ++i) {
+		nvinfer1::Dims da = a.getBindingDimensions(i), db = b.getBindingDimensions(i);
+		if (strcmp(a.getBindingName(i), b.getBindingName(i)) != 0 || a.bindingIsInput(i) != b.bindingIsInput(i)
+			|| a.getBindingDataType(i) != b.getBindingDataType(i) || da.nbDims != db.nbDims
+			|| !std::equal(da.d, da.d + da.nbDims, db.d)) {
+			return false;
+		}
+	}
+	return true;
+}
+}
+
+std::ostream& operator<<(std::ostream& out, const StartupProfile& value) {
+	out << std::fixed << std::setprecision(1) << "file read " << value.fileReadMs << " ms, parse " << value.parseMs
+		<< " ms, build " << value.buildMs << " ms, serialize " << value.serializeMs << " ms, deserialize " << value.deserializeMs
+		<< " ms" << (value.engineCacheHit ? " (engine cache)" : "") << ", context creation " << value.contextCreationMs
+		<< " ms, first inference " << value.firstInferenceMs << " ms, warmup " << value.warmupMs << " ms ("
+		<< value.warmupIterations << " rounds), total " << value.totalMs << " ms";
+	return out;
+}
+
 bool CaffeModel::build() {
 	return this->build(false);
 }
+
+std::vector<DataBlobShape> CaffeModel::inputShapes() {
+	std::vector<DataBlobShape> shapes;
+	std::shared_ptr<ExecutionContextPool> pool = executionPool();
+	if (!pool) {
+		return shapes;
+	}
+	for (int index : pool->inputBindings()) {
+		shapes.push_back(blobShapeOf(pool->engine()->getBindingDimensions(index), 1));
+	}
+	return shapes;
+}
+
+StartupProfile CaffeModel::startupProfile() const {
+	std::lock_guard<std::mutex> lock(mPoolMutex);
+	return mProfile;
+}
+
 CaffeModel::shape_t CaffeModel::getInputDimension(int index) {
+	std::lock_guard<std::mutex> lock(mPoolMutex);
 	if(mEngine != nullptr) {
 		std::string layername = mParams.inputTensorNames[index];
 		if(gInputDimensions.find(layername)!= gInputDimensions.end()) {
@@ -17,7 +110,55 @@ CaffeModel::shape_t CaffeModel::getInputDimension(int index) {
 }
 
 bool CaffeModel::build(bool is_caffe) {
+	auto begin = std::chrono::high_resolution_clock::now();
+	reset();
+	mReady = false;
+	mProfile = StartupProfile();
+	return finishBuild(buildEngine(is_caffe), begin);
+}
+
+bool CaffeModel::build(const void* plan, size_t size) {
+	auto begin = std::chrono::high_resolution_clock::now();
+	reset();
+	mReady = false;
+	mProfile = StartupProfile();
+	bool status = false;
+	{
+		PhaseTimer timer(mProfile.deserializeMs);
+		status = deserializeEngine(plan, size);
+	}
+	if (!status) {
+		LOG_ERROR(gLogger) <<  "ICudaEngine" << " load failed\n";
+	}
+	return finishBuild(status, begin);
+}
+
+//!
+//! \brief Creates mEngine, parsing and building the network or deserializing a plan.
+//!
+bool CaffeModel::buildEngine(bool is_caffe) {
 	if(is_caffe) {
+		EngineKey key;
+		std::unique_ptr<EngineCache> cache;
+		if (!mParams.engineCacheDir.empty()) {
+			dtrCommon::MappedFile plan;
+			{
+				PhaseTimer timer(mProfile.fileReadMs);
+				if (engineCacheKey(key)) {
+					cache.reset(new EngineCache(mParams.engineCacheDir));
+					plan = cache->load(key);
+				}
+			}
+			if (plan) {
+				PhaseTimer timer(mProfile.deserializeMs);
+				mProfile.engineCacheHit = deserializeEngine(plan.data(), plan.size());
+			}
+			if (mProfile.engineCacheHit) {
+				LOG_INFO(gLogger) << "loaded cached engine " << cache->pathOf(key) << std::endl;
+				recordInputs();
+				return true;
+			}
+		}
 		auto builder = UniquePtr<nvinfer1::IBuilder>(nvinfer1::createInferBuilder(gLogger.getTRTLogger()));
 		if (!builder)
 			return false;
@@ -29,42 +170,323 @@ bool CaffeModel::build(bool is_caffe) {
 		auto parser = UniquePtr<nvcaffeparser1::ICaffeParser>(nvcaffeparser1::createCaffeParser());
 		if (!parser)
 			return false;
-		constructNetwork(builder, network, parser);
-		mEngine = std::shared_ptr<nvinfer1::ICudaEngine>(builder->buildCudaEngine(*network), dtrCommon::DtrInferDeleter());
+		{
+			PhaseTimer timer(mProfile.parseMs);
+			constructNetwork(builder, network, parser);
+		}
+		{
+			PhaseTimer timer(mProfile.buildMs);
+			mEngine = std::shared_ptr<nvinfer1::ICudaEngine>(builder->buildCudaEngine(*network), dtrCommon::DtrInferDeleter());
+		}
 		if (!mEngine)
 			return false;
+		if (cache) {
+			PhaseTimer timer(mProfile.serializeMs);
+			UniquePtr<nvinfer1::IHostMemory> serialized(mEngine->serialize());
+			if (serialized && cache->store(key, serialized->data(), serialized->size())) {
+				LOG_INFO(gLogger) << "cached engine as " << cache->pathOf(key) << std::endl;
+			}
+		}
 	} else {
-		ICudaEngine* engine = nullptr;
-		std::vector<char> trtModelStream;
-		size_t size = 0;
-		std::ifstream file(locateFile(mParams.gieFileName, mParams.dataDirs).c_str(), std::ios::binary);
-		if (file.good()) {
-			file.seekg(0, file.end);
-			size = file.tellg();
-			file.seekg(0, file.beg);
-			trtModelStream.resize(size);
-			file.read(trtModelStream.data(), size);
-			file.close();
-		} else {
+		// the plan is deserialized straight from the page cache while readahead brings in the rest
+		dtrCommon::MappedFile plan;
+		{
+			PhaseTimer timer(mProfile.fileReadMs);
+			plan = dtrCommon::MappedFile(locateFile(mParams.gieFileName, mParams.dataDirs));
+		}
+		if (!plan) {
 			LOG_ERROR(gLogger) << mParams.gieFileName << " load failed\n";
 			return false;
 		}
-		IRuntime* infer = createInferRuntime(gLogger.getTRTLogger());
-		if (mParams.useDLACore >= 0) {
-			infer->setDLACore(mParams.useDLACore);
+		bool status = false;
+		{
+			PhaseTimer timer(mProfile.deserializeMs);
+			status = deserializeEngine(plan.data(), plan.size());
 		}
-		engine = infer->deserializeCudaEngine(trtModelStream.data(), size, nullptr);
-		mEngine = std::shared_ptr<nvinfer1::ICudaEngine>(engine, dtrCommon::DtrInferDeleter());
-		LOG_INFO(gLogger) << mParams.gieFileName << " has been successfully loaded." << std::endl;
-		infer->destroy();
-		if (!mEngine) {
+		if (!status) {
 			LOG_ERROR(gLogger) <<  "ICudaEngine" << " load failed\n";
 			return false;
 		}
+		LOG_INFO(gLogger) << mParams.gieFileName << " has been successfully loaded." << std::endl;
+	}
+	return true;
+}
+
+//!
+//! \brief Checks that a built engine runs mParams.batchSize samples, creates its execution state
+//!        and warms it up.
+//!
+bool CaffeModel::finishBuild(bool status, std::chrono::high_resolution_clock::time_point begin) {
+	// every request is split into mParams.batchSize chunks, a plan built for less can not run them
+	if (status && mEngine->getMaxBatchSize() < mParams.batchSize) {
+		LOG_ERROR(gLogger) << "the engine runs at most " << mEngine->getMaxBatchSize() << " samples, batchSize is "
+			<< mParams.batchSize << std::endl;
+		status = false;
+	}
+	if (status) {
+		PhaseTimer timer(mProfile.contextCreationMs);
+		status = executionPool() != nullptr;
+	}
+	status = status && warmup();
+	mProfile.totalMs = elapsedMs(begin);
+	if (status) {
+		LOG_INFO(gLogger) << "startup: " << mProfile << std::endl;
+	}
+	mReady = status;
+	return status;
+}
+
+//!
+//! \brief Runs mParams.warmupIterations rounds of one full batch on every execution slot,
+//!        so the lazy kernel and cudnn initialization is not paid by the first requests.
+//!        The inputs are zeros, the results do not depend on what the buffers held before.
+//!
+bool CaffeModel::warmup() {
+	PhaseTimer timer(mProfile.warmupMs);
+	std::shared_ptr<ExecutionContextPool> pool = executionPool();
+	if (!pool) {
+		return false;
+	}
+	// every slot is held at once, so each round runs on all of them
+	std::vector<Slot> slots;
+	for (int i = 0; i < pool->size(); ++i) {
+		slots.push_back(pool->acquire());
+		dtrCommon::BufferManager& buffers = *slots.back()->buffers;
+		for (int index : pool->inputBindings()) {
+			memset(buffers.getHostBuffer(index), 0, buffers.size(index));
+		}
 	}
+	for (int i = 0; i < mParams.warmupIterations; ++i) {
+		for (Slot& slot : slots) {
+			auto begin = std::chrono::high_resolution_clock::now();
+			if (!infer(slot)) {
+				LOG_ERROR(gLogger) << "warmup inference failed" << std::endl;
+				return false;
+			}
+			if (i == 0 && &slot == &slots.front()) {
+				mProfile.firstInferenceMs = elapsedMs(begin);
+			}
+		}
+		mProfile.warmupIterations++;
+	}
+	return true;
+}
+
+bool CaffeModel::serializeEngine(std::vector<char>& plan) {
+	std::shared_ptr<nvinfer1::ICudaEngine> engine = currentEngine();
+	if (!engine) {
+		return false;
+	}
+	UniquePtr<nvinfer1::IHostMemory> serialized(engine->serialize());
+	if (!serialized) {
+		return false;
+	}
+	const char* data = static_cast<const char*>(serialized->data());
+	plan.assign(data, data + serialized->size());
+	return true;
+}
+
+bool CaffeModel::reload(const dtrCommon::CaffeNNParams& params, bool is_caffe) {
+	std::lock_guard<std::mutex> reloadLock(mReloadMutex);
+	dtrCommon::CaffeNNParams nextParams = params;
+	nextParams.batchSize = mParams.batchSize;
+	nextParams.inputTensorNames = mParams.inputTensorNames;
+	nextParams.outputTensorNames = mParams.outputTensorNames;
+	// build() warms up every slot of the new engine before the requests get there, and
+	// refuses one that can not run batchSize samples
+	CaffeModel next(nextParams);
+	if (!next.build(is_caffe)) {
+		LOG_ERROR(gLogger) << "reload: the new engine could not be built" << std::endl;
+		return false;
+	}
+	std::shared_ptr<nvinfer1::ICudaEngine> current = currentEngine();
+	if (current && !sameBindings(*current, *next.mEngine)) {
+		LOG_ERROR(gLogger) << "reload: the bindings of the new engine differ, keeping the old one" << std::endl;
+		return false;
+	}
+	current.reset();
+
+	std::shared_ptr<ExecutionContextPool> retired;
+	{
+		std::lock_guard<std::mutex> lock(mPoolMutex);
+		retired = std::move(mPool);
+		mPool = std::move(next.mPool);
+		mEngine = next.mEngine;
+		gInputDimensions = next.gInputDimensions;
+		mProfile = next.mProfile;
+		mParams.gieFileName = params.gieFileName;
+		mParams.prototxtFileName = params.prototxtFileName;
+		mParams.weightsFileName = params.weightsFileName;
+	}
+	// inferences in flight hold slots of the old pool, it goes away here once they are back
+	if (retired) {
+		retired->waitIdle();
+	}
+	retired.reset();
+	LOG_INFO(gLogger) << "reload: now serving the new engine" << std::endl;
+	return true;
+}
+
+std::future<bool> CaffeModel::reloadAsync(const dtrCommon::CaffeNNParams& params, bool is_caffe) {
+	return std::async(std::launch::async, [this, params, is_caffe]() { return reload(params, is_caffe); });
+}
+
+void CaffeModel::release() {
+	mReady = false;
+	reset();
+	std::lock_guard<std::mutex> lock(mPoolMutex);
+	mEngine.reset();
+}
+
+bool CaffeModel::isBuilt() const {
+	return currentEngine() != nullptr;
+}
+
+std::shared_ptr<nvinfer1::ICudaEngine> CaffeModel::currentEngine() const {
+	std::lock_guard<std::mutex> lock(mPoolMutex);
+	return mEngine;
+}
+
+size_t CaffeModel::deviceMemorySize() {
+	std::shared_ptr<ExecutionContextPool> pool;
+	{
+		std::lock_guard<std::mutex> lock(mPoolMutex);
+		pool = mPool;
+	}
+	if (!pool) {
+		return 0;
+	}
+	const nvinfer1::ICudaEngine& engine = *pool->engine();
+	size_t slotSize = engine.getDeviceMemorySize();
+	for (int i = 0; i < engine.getNbBindings(); ++i) {
+		slotSize += dtrCommon::volume(engine.getBindingDimensions(i)) * dtrCommon::getElementSize(engine.getBindingDataType(i))
+			* static_cast<size_t>(pool->batchSize());
+	}
+	return slotSize * pool->size();
+}
+
+bool CaffeModel::deserializeEngine(const void* data, size_t size) {
+	IRuntime* infer = createInferRuntime(gLogger.getTRTLogger());
+	if (!infer) {
+		return false;
+	}
+	if (mParams.useDLACore >= 0) {
+		infer->setDLACore(mParams.useDLACore);
+	}
+	mEngine = std::shared_ptr<nvinfer1::ICudaEngine>(infer->deserializeCudaEngine(data, size, nullptr), dtrCommon::DtrInferDeleter());
+	infer->destroy();
+	return mEngine != nullptr;
+}
+
+//!
+//! \brief Hashes everything the engine built by build(true) depends on: the network files,
+//!        the precision and builder settings, the TensorRT version and the device.
+//!        Returns false if the key can not be computed, the cache is skipped then.
+//!
+bool CaffeModel::engineCacheKey(EngineKey& key) {
+	if (!key.addFile(locateFile(mParams.prototxtFileName, mParams.dataDirs))
+		|| !key.addFile(locateFile(mParams.weightsFileName, mParams.dataDirs))) {
+		return false;
+	}
+	key.add(mParams.fp16).add(mParams.int8);
+	if (mParams.int8) {
+		// a missing range file builds an engine without dynamic ranges, hash its name instead
+		if (!key.addFile(mParams.perTensorDynamicRangeFileName)) {
+			key.add(mParams.perTensorDynamicRangeFileName);
+		}
+	}
+	key.add(mParams.inputTensorNames.size());
+	for (auto& name : mParams.inputTensorNames) {
+		key.add(name);
+	}
+	key.add(mParams.outputTensorNames.size());
+	for (auto& name : mParams.outputTensorNames) {
+		key.add(name);
+	}
+	key.add(mParams.batchSize).add(kMaxWorkspaceSize).add(mParams.useDLACore);
+
+	int device = 0, runtimeVersion = 0;
+	cudaDeviceProp props;
+	if (cudaGetDevice(&device) != cudaSuccess || cudaGetDeviceProperties(&props, device) != cudaSuccess
+		|| cudaRuntimeGetVersion(&runtimeVersion) != cudaSuccess) {
+		return false;
+	}
+	key.add(getInferLibVersion()).add(runtimeVersion);
+	key.add(std::string(props.name)).add(props.major).add(props.minor).add(props.multiProcessorCount).add(props.totalGlobalMem);
 	return true;
 }
 
+//!
+//! \brief Records the inputs of a deserialized engine the way constructNetwork() does
+//!        for a parsed network.
+//!
+void CaffeModel::recordInputs() {
+	bool parseInput = mParams.inputTensorNames.empty();
+	for (int i = 0, n = mEngine->getNbBindings(); i < n; i++) {
+		if (!mEngine->bindingIsInput(i)) {
+			continue;
+		}
+		Dims3 dims = static_cast<Dims3&&>(mEngine->getBindingDimensions(i));
+		if(parseInput) mParams.inputTensorNames.push_back(mEngine->getBindingName(i));
+		gInputDimensions.insert(std::make_pair(mEngine->getBindingName(i), convertToShape(dims)));
+	}
+}
+
+//!
+//! \brief Creates the pool of execution contexts, streams and binding buffers used by infer(),
+//!        and resolves the binding index of each input and output tensor into it.
+//!        The caller holds mPoolMutex.
+//!
+bool CaffeModel::setupExecution() {
+	if (!mEngine) {
+		return false;
+	}
+	std::vector<int> inputBindings, outputBindings;
+	for (auto& name : mParams.inputTensorNames) {
+		int index = mEngine->getBindingIndex(name.c_str());
+		if (index < 0 || !mEngine->bindingIsInput(index)) {
+			LOG_ERROR(gLogger) << "could not find input binding " << name << std::endl;
+			return false;
+		}
+		inputBindings.push_back(index);
+	}
+	for (auto& name : mParams.outputTensorNames) {
+		int index = mEngine->getBindingIndex(name.c_str());
+		if (index < 0 || mEngine->bindingIsInput(index)) {
+			LOG_ERROR(gLogger) << "could not find output binding " << name << std::endl;
+			return false;
+		}
+		outputBindings.push_back(index);
+	}
+	// page-locked buffers let the copies of one slot overlap with the other slots
+	dtrCommon::HostMemoryType hostMemoryType = !mParams.pinnedHostMemory ? dtrCommon::HostMemoryType::kPAGEABLE
+		: mParams.writeCombinedInputs ? dtrCommon::HostMemoryType::kWRITE_COMBINED : dtrCommon::HostMemoryType::kPINNED;
+	if (mParams.mappedHostMemory) {
+		hostMemoryType = dtrCommon::HostMemoryType::kMAPPED;
+		if (!integratedDevice()) {
+			LOG_WARN(gLogger) << "mapped host memory on a discrete GPU, every access of the engine crosses the bus" << std::endl;
+		}
+	}
+	dtrCommon::BufferLayout layout = mParams.slabBuffers ? dtrCommon::BufferLayout::kSLAB : dtrCommon::BufferLayout::kPER_BINDING;
+	mPool = ExecutionContextPool::create(mEngine, mParams.batchSize, mParams.nbExecutionContexts, std::move(inputBindings),
+		std::move(outputBindings), hostMemoryType, layout);
+	return mPool != nullptr;
+}
+
+std::shared_ptr<ExecutionContextPool> CaffeModel::executionPool() {
+	std::lock_guard<std::mutex> lock(mPoolMutex);
+	if (!mPool) {
+		setupExecution();
+	}
+	return mPool;
+}
+
+void CaffeModel::reset() {
+	stopCompletionThread();
+	std::lock_guard<std::mutex> lock(mPoolMutex);
+	mPool.reset();
+}
+
 void CaffeModel::setLayerPrecision(UniquePtr<nvinfer1::INetworkDefinition>& network) {
     LOG_INFO(gLogger) << "Setting Per Layer Computation Precision" << std::endl;
     for (int i = 0; i < network->getNbLayers(); ++i) {
@@ -175,7 +597,7 @@ void CaffeModel::constructNetwork(UniquePtr<nvinfer1::IBuilder>& builder, Unique
         }
     }
     builder->setMaxBatchSize(maxBatchSize);
-	builder->setMaxWorkspaceSize(1_GB);
+	builder->setMaxWorkspaceSize(kMaxWorkspaceSize);
 	if(mParams.fp16 && builder->platformHasFastFp16()) {
 		LOG_INFO(gLogger) << "Use FP16\n";
 		builder->setHalf2Mode(true);
@@ -196,60 +618,192 @@ void CaffeModel::constructNetwork(UniquePtr<nvinfer1::IBuilder>& builder, Unique
     }
 }
 
-DataBlob32f CaffeModel::getDataBlobFromBuffer(dtrCommon::BufferManager& buffers, std::string& tensorname) {
-	int index = mEngine->getBindingIndex(tensorname.c_str());
-	nvinfer1::Dims bufDims = mEngine->getBindingDimensions(index);
-	DataBlob32f res(bufDims.d[0],bufDims.d[1],bufDims.d[2],bufDims.d[3]);
+//!
+//! \brief Converts the first count samples of the host buffer of binding index into
+//!        samples [offset, offset + count) of res.
+//!
+void CaffeModel::copyFromBuffer(const nvinfer1::ICudaEngine& engine, dtrCommon::BufferManager& buffers, int index, DataBlob32f& res, size_t offset, size_t count) {
 	size_t inst_size = res.inst_n_elem();
 
-	nvinfer1::DataType data_type = mEngine->getBindingDataType(index);
-	void* buf = buffers.getHostBuffer(tensorname);
-	size_t bufSize = buffers.size(tensorname);
+	nvinfer1::DataType data_type = engine.getBindingDataType(index);
+	void* buf = buffers.getHostBuffer(index);
+	assert(offset + count <= res.nums());
+	assert(count * inst_size * dtrCommon::getElementSize(data_type) <= buffers.size(index));
 	if(nvinfer1::DataType::kFLOAT == data_type) {
-		LOG_INFO(gLogger) << "float" << std::endl;
-		CHECK(bufSize == res.nums()*inst_size);
-		float* typebuf = static_cast<float*>(buf);
-		for(size_t i = 0; i < res.nums(); ++i) {
-			float* dst = res.ptr(i);
-			for(size_t j = 0; j < inst_size; ++j) {
-				dst[j] = typebuf[j];
-			}
-			typebuf += inst_size;
-		}
+		// same layout on both sides, the samples are contiguous in res
+		memcpy(res.ptr(offset), buf, count * inst_size * sizeof(float));
 	} else if(nvinfer1::DataType::kHALF == data_type){
-		LOG_INFO(gLogger) << "half" << std::endl;
-		half_float::half* half_typebuf = static_cast<half_float::half*>(buf);
-		for(size_t i = 0; i < res.nums(); ++i) {
-			float* dst = res.ptr(i);
-			for(size_t j = 0; j < inst_size; ++j) {
-				dst[j] = (float)(half_typebuf[j]);
-			}
-			half_typebuf += inst_size;
-		}
+		dtrCommon::halfToFloat(static_cast<const uint16_t*>(buf), res.ptr(offset), count * inst_size);
 	} else if(data_type == nvinfer1::DataType::kINT8) {
-		LOG_INFO(gLogger) << "int8" << std::endl;
-		char* c_typebuf = static_cast<char*>(buf);
-		for(size_t i = 0; i < res.nums(); ++i) {
-			float* dst = res.ptr(i);
-			for(size_t j = 0; j < inst_size; ++j) {
-				dst[j] = static_cast<float>(c_typebuf[j]);
-			}
-			c_typebuf += inst_size;
-		}
+		dtrCommon::dequantize(static_cast<const int8_t*>(buf), res.ptr(offset), count * inst_size);
 	} else if(data_type == nvinfer1::DataType::kINT32) {
-		LOG_INFO(gLogger) << "int32" << std::endl;
-		int* i_typebuf = static_cast<int*>(buf);
-		for(size_t i = 0; i < res.nums(); ++i) {
-			float* dst = res.ptr(i);
-			for(size_t j = 0; j < inst_size; ++j) {
-				dst[j] = static_cast<float>(i_typebuf[j]);
-			}
-			i_typebuf += inst_size;
-		}
+		dtrCommon::dequantize(static_cast<const int32_t*>(buf), res.ptr(offset), count * inst_size);
 	} else {
 		LOG_ERROR(gLogger) << "not support type" << std::endl;
+		memset(res.ptr(offset), 0, count * inst_size * sizeof(float));
+	}
+}
+
+//!
+//! \brief Returns the number of samples of input_blobs, or 0 if they do not match the
+//!        input bindings of pool or disagree on the number of samples.
+//!
+size_t CaffeModel::batchOf(const ExecutionContextPool& pool, const std::vector<DataBlob32f>& input_blobs) {
+	const nvinfer1::ICudaEngine& engine = *pool.engine();
+	const std::vector<int>& inputs = pool.inputBindings();
+	if (input_blobs.empty() || input_blobs.size() != inputs.size()) {
+		LOG_ERROR(gLogger) << "expected " << inputs.size() << " input blobs, got " << input_blobs.size() << std::endl;
+		return 0;
+	}
+	size_t batchSize = input_blobs[0].nums();
+	for (size_t i = 0; i < input_blobs.size(); ++i) {
+		size_t sampleSize = dtrCommon::volume(engine.getBindingDimensions(inputs[i]));
+		if (input_blobs[i].nums() != batchSize || input_blobs[i].inst_n_elem() != sampleSize) {
+			LOG_ERROR(gLogger) << "input " << engine.getBindingName(inputs[i]) << " expects " << batchSize << " samples of "
+				<< sampleSize << " elements, got " << input_blobs[i].nums() << " of " << input_blobs[i].inst_n_elem() << std::endl;
+			return 0;
+		}
+	}
+	return batchSize;
+}
+
+//!
+//! \brief Resolves output_names to the binding indices of engine outputs.
+//!
+bool CaffeModel::outputBindingsOf(const nvinfer1::ICudaEngine& engine, const std::vector<std::string>& output_names, std::vector<int>& bindings) {
+	bindings.clear();
+	for (auto& name : output_names) {
+		int index = engine.getBindingIndex(name.c_str());
+		if (index < 0 || engine.bindingIsInput(index)) {
+			LOG_ERROR(gLogger) << "could not find output binding " << name << std::endl;
+			return false;
+		}
+		bindings.push_back(index);
+	}
+	return true;
+}
+
+std::vector<DataBlob32f> CaffeModel::allocateOutputs(const nvinfer1::ICudaEngine& engine, const std::vector<int>& bindings, size_t batchSize) {
+	std::vector<DataBlob32f> outputs;
+	for (int index : bindings) {
+		// every sample is written by copyFromBuffer
+		outputs.push_back(DataBlobPool::instance().acquire<float>(blobShapeOf(engine.getBindingDimensions(index), batchSize),
+			BlobInit::kUNINITIALIZED));
+	}
+	return outputs;
+}
+
+//!
+//! \brief Stages samples [offset, offset + count) of input_blobs in the host buffers of the
+//!        slot and issues their copy to the device on the slot stream, a single transfer
+//!        with the slab layout. The blobs are not used once it returns.
+//!
+bool CaffeModel::copyInputs(const Slot& slot, const std::vector<DataBlob32f>& input_blobs, size_t offset, size_t count) {
+	dtrCommon::BufferManager& buffers = *slot->buffers;
+	const std::vector<int>& inputs = slot.pool()->inputBindings();
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		int index = inputs[i];
+		size_t size = sizeof(float) * input_blobs[i].inst_n_elem() * count;
+		if (offset + count > input_blobs[i].nums() || buffers.size(index) < size) {
+			LOG_ERROR(gLogger) << "input " << slot.pool()->engine()->getBindingName(index) << " holds " << buffers.size(index) << " bytes, got " << size << std::endl;
+			return false;
+		}
+		DataBlob32f samples = input_blobs[i].slice_batch(offset, offset + count);
+		float* host = static_cast<float*>(buffers.getHostBuffer(index));
+		if (samples.layout() != BlobLayout::kNCHW && samples.is_continuous()) {
+			// interleaved frames are converted to the planar layout of the engine on the calling
+			// thread, concurrent requests already keep the cores busy
+			convertLayout(samples.ptr(), samples.layout(), host, BlobLayout::kNCHW,
+				count, samples.channels(), samples.heights(), samples.widths());
+		} else if (samples.is_continuous()) {
+			// from the page-locked buffer the transfer is really asynchronous
+			memcpy(host, samples.ptr(), size);
+		} else {
+			// a strided view is gathered sample by sample
+			DataBlob32f staging(samples.shape(), host);
+			samples.copy_to(staging);
+		}
+	}
+	buffers.copyInputToDeviceAsync(slot->stream, static_cast<int>(count));
+	return true;
+}
+
+//!
+//! \brief Enqueues batchSize samples of the network and the device to host copies of the
+//!        output bindings on the slot stream without waiting for them. The inputs are
+//!        already on the device, the other outputs stay there.
+//!
+bool CaffeModel::enqueue(ExecutionSlot& slot, int batchSize, bool use_cudastream, const std::vector<int>& outputs) {
+	dtrCommon::BufferManager& buffers = *slot.buffers;
+	bool status = false;
+	if(use_cudastream) {
+		status = slot.context->enqueue(batchSize, buffers.getDeviceBindings().data(), slot.stream, nullptr);
+	} else {
+		CHECK(cudaStreamSynchronize(slot.stream));
+		status = slot.context->execute(batchSize, buffers.getDeviceBindings().data());
+	}
+	if (!status) {
+		return false;
+	}
+	buffers.copyOutputToHostAsync(outputs, slot.stream, batchSize);
+	return true;
+}
+
+bool CaffeModel::execute(ExecutionSlot& slot, int batchSize, bool use_cudastream, const std::vector<int>& outputs) {
+	if (!enqueue(slot, batchSize, use_cudastream, outputs)) {
+		return false;
+	}
+	CHECK(cudaStreamSynchronize(slot.stream));
+	return true;
+}
+
+//!
+//! \brief Runs input_blobs in chunks of at most the engine batch size and converts the
+//!        output bindings into output_blobs, which hold as many samples as input_blobs.
+//!
+//! \details Each chunk takes a free slot, so the chunks overlap on the slot streams. When
+//!          no slot is free the oldest chunk in flight is finished to make room.
+//!
+bool CaffeModel::run(ExecutionContextPool& pool, const std::vector<DataBlob32f>& input_blobs, size_t total,
+	const std::vector<int>& outputs, std::vector<DataBlob32f>& output_blobs, bool use_cudastream) {
+	const size_t maxBatchSize = static_cast<size_t>(pool.batchSize());
+	struct Chunk {
+		Slot slot;
+		size_t offset;
+		size_t count;
+	};
+	std::deque<Chunk> inflight;
+	auto finish = [&]() {
+		Chunk& chunk = inflight.front();
+		CHECK(cudaStreamSynchronize(chunk.slot->stream));
+		for (size_t i = 0; i < outputs.size(); ++i) {
+			copyFromBuffer(*pool.engine(), *chunk.slot->buffers, outputs[i], output_blobs[i], chunk.offset, chunk.count);
+		}
+		inflight.pop_front();
+	};
+	bool status = true;
+	for (size_t offset = 0; status && offset < total; offset += maxBatchSize) {
+		Chunk chunk{pool.tryAcquire(), offset, std::min(maxBatchSize, total - offset)};
+		while (!chunk.slot) {
+			if (inflight.empty()) {
+				chunk.slot = pool.acquire();
+				break;
+			}
+			finish();
+			chunk.slot = pool.tryAcquire();
+		}
+		status = chunk.slot && copyInputs(chunk.slot, input_blobs, chunk.offset, chunk.count)
+			&& enqueue(*chunk.slot, static_cast<int>(chunk.count), use_cudastream, outputs);
+		if (status) {
+			inflight.push_back(std::move(chunk));
+		} else if (chunk.slot) {
+			CHECK(cudaStreamSynchronize(chunk.slot->stream));
+		}
 	}
-	return std::move(res);
+	while (!inflight.empty()) {
+		finish();
+	}
+	return status;
 }
 
 std::vector<DataBlob32f> CaffeModel::infer(const std::vector<DataBlob32f>& input_blobs) {
@@ -257,35 +811,211 @@ std::vector<DataBlob32f> CaffeModel::infer(const std::vector<DataBlob32f>& input
 }
 
 std::vector<DataBlob32f> CaffeModel::infer(const std::vector<DataBlob32f>& input_blobs, bool use_cudastream = true) {
-	dtrCommon::BufferManager buffers(mEngine, mParams.batchSize);
-	auto context = UniquePtr<nvinfer1::IExecutionContext>(mEngine->createExecutionContext());
-	if(!context || mParams.inputTensorNames.size() != input_blobs.size()) {
+	std::shared_ptr<ExecutionContextPool> pool = executionPool();
+	size_t total = pool ? batchOf(*pool, input_blobs) : 0;
+	if (total == 0) {
+		return {};
+	}
+	std::vector<DataBlob32f> outputs = allocateOutputs(*pool->engine(), pool->outputBindings(), total);
+	if (!run(*pool, input_blobs, total, pool->outputBindings(), outputs, use_cudastream)) {
 		return {};
 	}
-	cudaStream_t stream;
-	CHECK(cudaStreamCreate(&stream));
-	for (size_t i = 0; i < mParams.inputTensorNames.size(); ++i) {
+	return outputs;
+}
 
-		std::string input = mParams.inputTensorNames[i];
-		size_t size = sizeof(float)*input_blobs[i].total_n_elem();
-		CHECK(buffers.size(input) == size);
-		void* devicebuffer = buffers.getDeviceBuffer(input);
-		CHECK(cudaMemcpyAsync(devicebuffer, (void*)input_blobs[i].ptr(), size, cudaMemcpyHostToDevice, stream));
+std::vector<DataBlob32f> CaffeModel::infer(const std::vector<DataBlob32f>& input_blobs, const std::vector<std::string>& output_names) {
+	std::shared_ptr<ExecutionContextPool> pool = executionPool();
+	std::vector<int> bindings;
+	size_t total = pool && outputBindingsOf(*pool->engine(), output_names, bindings) ? batchOf(*pool, input_blobs) : 0;
+	if (total == 0) {
+		return {};
 	}
-	bool status = false;
-	if(use_cudastream) {
-		status = context->enqueue(mParams.batchSize, buffers.getDeviceBindings().data(), stream, nullptr);
-	} else {
-		status = context->execute(mParams.batchSize, buffers.getDeviceBindings().data());
+	std::vector<DataBlob32f> outputs = allocateOutputs(*pool->engine(), bindings, total);
+	if (!run(*pool, input_blobs, total, bindings, outputs, true)) {
+		return {};
+	}
+	return outputs;
+}
+
+bool CaffeModel::infer(const std::vector<DataBlob32f>& input_blobs, std::vector<DataBlob32f>& output_blobs) {
+	std::shared_ptr<ExecutionContextPool> pool = executionPool();
+	size_t total = pool ? batchOf(*pool, input_blobs) : 0;
+	if(total == 0 || pool->outputBindings().size() != output_blobs.size()) {
+		return false;
+	}
+	const std::vector<int>& outputs = pool->outputBindings();
+	for (size_t i = 0; i < outputs.size(); ++i) {
+		size_t sampleSize = dtrCommon::volume(pool->engine()->getBindingDimensions(outputs[i]));
+		if (output_blobs[i].nums() != total || output_blobs[i].inst_n_elem() != sampleSize) {
+			LOG_ERROR(gLogger) << "output " << pool->engine()->getBindingName(outputs[i]) << " blob does not match the binding size" << std::endl;
+			return false;
+		}
+	}
+	return run(*pool, input_blobs, total, outputs, output_blobs, true);
+}
+
+std::future<std::vector<DataBlob32f>> CaffeModel::inferAsync(const std::vector<DataBlob32f>& input_blobs) {
+	auto promise = std::make_shared<std::promise<std::vector<DataBlob32f>>>();
+	std::future<std::vector<DataBlob32f>> result = promise->get_future();
+	inferAsync(input_blobs, [promise](std::vector<DataBlob32f> outputs) {
+		promise->set_value(std::move(outputs));
+	});
+	return result;
+}
+
+bool CaffeModel::inferAsync(const std::vector<DataBlob32f>& input_blobs, InferCallback done) {
+	std::shared_ptr<ExecutionContextPool> pool = executionPool();
+	size_t total = pool ? batchOf(*pool, input_blobs) : 0;
+	if (total == 0) {
+		if (done) {
+			done({});
+		}
+		return false;
+	}
+	// every chunk converts its samples into the shared outputs, the last one to complete hands them over
+	struct Request {
+		std::vector<DataBlob32f> outputs;
+		std::atomic<size_t> remaining{0};
+		std::atomic<bool> failed{false};
+		InferCallback done;
+	};
+	const size_t maxBatchSize = static_cast<size_t>(pool->batchSize());
+	auto request = std::make_shared<Request>();
+	request->outputs = allocateOutputs(*pool->engine(), pool->outputBindings(), total);
+	request->remaining = (total + maxBatchSize - 1) / maxBatchSize;
+	request->done = std::move(done);
+	auto chunkDone = [request](bool status) {
+		if (!status) {
+			request->failed = true;
+		}
+		if (--request->remaining == 0 && request->done) {
+			request->done(request->failed ? std::vector<DataBlob32f>() : std::move(request->outputs));
+		}
+	};
+	bool status = true;
+	for (size_t offset = 0; offset < total; offset += maxBatchSize) {
+		status = submit(*pool, input_blobs, request->outputs, offset, std::min(maxBatchSize, total - offset), chunkDone) && status;
+	}
+	return status;
+}
+
+//!
+//! \brief Issues samples [offset, offset + count) of input_blobs on a slot and hands it
+//!        to the completion thread, which converts them into output_blobs and calls done.
+//!        done(false) is called right away if the chunk can not be issued.
+//!
+bool CaffeModel::submit(ExecutionContextPool& pool, const std::vector<DataBlob32f>& input_blobs, const std::vector<DataBlob32f>& output_blobs,
+	size_t offset, size_t count, std::function<void(bool)> done) {
+	PendingInference pending;
+	pending.slot = pool.acquire();
+	pending.offset = offset;
+	pending.count = count;
+	pending.outputs = output_blobs;
+	pending.done = std::move(done);
+	if (!pending.slot || !copyInputs(pending.slot, input_blobs, offset, count)
+		|| !enqueue(*pending.slot, static_cast<int>(count), true, pool.outputBindings())) {
+		// the slot goes back to the pool before the caller hears about the failure
+		if (pending.slot) {
+			CHECK(cudaStreamSynchronize(pending.slot->stream));
+		}
+		pending.slot.release();
+		pending.done(false);
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(mCompletionMutex);
+	if (!mCompletionThread.joinable()) {
+		int device = 0;
+		CHECK(cudaGetDevice(&device));
+		mCompletionThread = std::thread(&CaffeModel::completionLoop, this, device);
+	}
+	mCompletions.push_back(std::move(pending));
+	mCompletionReady.notify_one();
+	return true;
+}
+
+//!
+//! \brief Waits for the chunks issued by inferAsync() in submission order, converts
+//!        their outputs, returns their slots to the pool and runs their callbacks.
+//!
+void CaffeModel::completionLoop(int device) {
+	CHECK(cudaSetDevice(device));
+	while (true) {
+		PendingInference pending;
+		{
+			std::unique_lock<std::mutex> lock(mCompletionMutex);
+			mCompletionReady.wait(lock, [this] { return mStopCompletion || !mCompletions.empty(); });
+			if (mCompletions.empty()) {
+				return;
+			}
+			pending = std::move(mCompletions.front());
+			mCompletions.pop_front();
+		}
+		CHECK(cudaStreamSynchronize(pending.slot->stream));
+		const ExecutionContextPool& pool = *pending.slot.pool();
+		for (size_t i = 0; i < pool.outputBindings().size(); ++i) {
+			copyFromBuffer(*pool.engine(), *pending.slot->buffers, pool.outputBindings()[i], pending.outputs[i], pending.offset, pending.count);
+		}
+		pending.slot.release();
+		pending.outputs.clear();
+		pending.done(true);
+	}
+}
+
+void CaffeModel::stopCompletionThread() {
+	{
+		std::lock_guard<std::mutex> lock(mCompletionMutex);
+		if (!mCompletionThread.joinable()) {
+			return;
+		}
+		mStopCompletion = true;
 	}
-	cudaStreamDestroy(stream);
-	if (!status) return {};
-	buffers.copyOutputToHost();
-	std::vector<DataBlob32f> results;
-	for(auto& tensorName: mParams.outputTensorNames) {
-		results.push_back(getDataBlobFromBuffer(buffers, tensorName));
+	mCompletionReady.notify_one();
+	mCompletionThread.join();
+	std::lock_guard<std::mutex> lock(mCompletionMutex);
+	mStopCompletion = false;
+}
+
+CaffeModel::Slot CaffeModel::acquire() {
+	std::shared_ptr<ExecutionContextPool> pool = executionPool();
+	if (!pool) {
+		return Slot();
+	}
+	return pool->acquire();
+}
+
+//!
+//! \brief Returns a DataBlob aliasing the host buffer of a kFLOAT binding of slot.
+//!
+DataBlob32f CaffeModel::bindingView(const Slot& slot, int index) {
+	const nvinfer1::ICudaEngine& engine = *slot.pool()->engine();
+	if (engine.getBindingDataType(index) != nvinfer1::DataType::kFLOAT) {
+		LOG_ERROR(gLogger) << engine.getBindingName(index) << " is not a float binding and can not be viewed" << std::endl;
+		return DataBlob32f();
+	}
+	return DataBlob32f(blobShapeOf(engine.getBindingDimensions(index), slot.pool()->batchSize()),
+		static_cast<float*>(slot->buffers->getHostBuffer(index)));
+}
+
+DataBlob32f CaffeModel::inputBlob(const Slot& slot, size_t index) {
+	if (!slot || index >= slot.pool()->inputBindings().size()) {
+		return DataBlob32f();
+	}
+	return bindingView(slot, slot.pool()->inputBindings()[index]);
+}
+
+DataBlob32f CaffeModel::outputBlob(const Slot& slot, size_t index) {
+	if (!slot || index >= slot.pool()->outputBindings().size()) {
+		return DataBlob32f();
+	}
+	return bindingView(slot, slot.pool()->outputBindings()[index]);
+}
+
+bool CaffeModel::infer(const Slot& slot, bool use_cudastream) {
+	if (!slot) {
+		return false;
 	}
-	return results;
+	slot->buffers->copyInputToDeviceAsync(slot->stream);
+	return execute(*slot, slot.pool()->batchSize(), use_cudastream, slot.pool()->outputBindings());
 }
 
 bool CaffeModel::teardown() {
@@ -1,21 +1,145 @@
 #include <common/common.h>
 #include <DataBlob.h>
+#include <LayoutConvert.h>
+#include <cstdlib>
 #include <iomanip>
+#include <stdexcept>
+#include <sys/mman.h>
+
+namespace {
+// below this calloc recycles heap chunks and the arena serves aligned blocks, both memset
+const size_t kFreshPagesMinBytes = 128 << 10;
+
+std::shared_ptr<void> arenaAlloc(size_t bytes, unsigned int flags) {
+	dtrCommon::HostArena &arena = dtrCommon::HostArena::instance();
+	void *ptr = arena.allocate(bytes, flags);
+	if (!ptr) {
+		return nullptr;
+	}
+	return std::shared_ptr<void>(ptr, [&arena](void *d) { arena.free(d); });
+}
+
+std::shared_ptr<void> pinnedAlloc(size_t bytes) {
+	void *ptr = nullptr;
+	if (cudaHostAlloc(&ptr, std::max<size_t>(bytes, 1), cudaHostAllocDefault) != cudaSuccess) {
+		cudaGetLastError();
+		LOG_WARN(gLogger) << "cudaHostAlloc of " << bytes << " bytes failed, the blob is pageable" << std::endl;
+		return arenaAlloc(bytes, 0);
+	}
+	return std::shared_ptr<void>(ptr, cudaFreeHost);
+}
+
+// storage of memory that is already zero, or nullptr if memory can not be had that way
+std::shared_ptr<void> zeroedAlloc(BlobMemory memory, size_t bytes) {
+	if (memory == BlobMemory::kHEAP) {
+		// large blocks are fresh mmap pages, which glibc knows not to clear
+		void *ptr = calloc(1, std::max<size_t>(bytes, 1));
+		return ptr ? std::shared_ptr<void>(ptr, free) : nullptr;
+	}
+	if (memory == BlobMemory::kALIGNED && bytes >= kFreshPagesMinBytes) {
+		void *ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED) {
+			return nullptr;
+		}
+		return std::shared_ptr<void>(ptr, [bytes](void *d) { munmap(d, bytes); });
+	}
+	return nullptr;
+}
+}
+
+BlobAllocator blobAllocator(BlobMemory memory) {
+	switch (memory) {
+	case BlobMemory::kHEAP:
+		return [](size_t bytes) { return std::shared_ptr<void>(new char[bytes], [](void *d) { delete[] static_cast<char *>(d); }); };
+	case BlobMemory::kALIGNED:
+		return [](size_t bytes) { return arenaAlloc(bytes, 0); };
+	case BlobMemory::kPINNED:
+		return pinnedAlloc;
+	case BlobMemory::kHUGE_PAGES:
+		return [](size_t bytes) { return arenaAlloc(bytes, dtrCommon::HostArena::kHUGE_PAGES); };
+	case BlobMemory::kEXTERNAL:
+		break;
+	}
+	return nullptr;
+}
 
 template <typename T>
 DataBlob<T>::DataBlob():
-	m_num(0), m_channel(0), m_height(0), m_width(0), m_step(-1),
-	m_data(0), m_offset(0)
+	m_num(0), m_channel(0), m_height(0), m_width(0),
+	m_data(0), m_offset(0), m_memory(BlobMemory::kHEAP), m_layout(BlobLayout::kNCHW)
 {
+	reset_steps();
 }
 template <typename T>
-DataBlob<T>::DataBlob(size_t num, size_t height, size_t width, size_t channels):
-	m_num(num), m_channel(channels), m_height(height), m_width(width),
-	m_offset(0) 
+DataBlob<T>::DataBlob(size_t num, size_t channel, size_t height, size_t width):
+	m_num(num), m_channel(channel), m_height(height), m_width(width),
+	m_offset(0), m_memory(BlobMemory::kHEAP), m_layout(BlobLayout::kNCHW)
 {
-	m_step = m_width*m_channel;
-	m_data.reset(new T[m_num* m_height * m_step], [](T *d) { delete[] d; });
-	memset(m_data.get(), 0, sizeof(T) * m_num* m_height * m_step);
+	reset_steps();
+	m_data.reset(new T[total_n_elem()], [](T *d) { delete[] d; });
+	memset(m_data.get(), 0, sizeof(T) * total_n_elem());
+}
+
+template <typename T>
+DataBlob<T>::DataBlob(size_t num, size_t channel, size_t height, size_t width, BlobMemory memory, BlobInit init, BlobLayout layout):
+	m_num(num), m_channel(channel), m_height(height), m_width(width),
+	m_offset(0), m_memory(memory), m_layout(layout)
+{
+	reset_steps();
+	allocate(blobAllocator(memory), init);
+}
+
+template <typename T>
+DataBlob<T>::DataBlob(DataBlobShape shape, BlobMemory memory, BlobInit init, BlobLayout layout):
+	DataBlob(shape.nums(), shape.channels(), shape.heights(), shape.widths(), memory, init, layout)
+{}
+
+template <typename T>
+DataBlob<T>::DataBlob(size_t num, size_t channel, size_t height, size_t width, const BlobAllocator &allocator, BlobInit init, BlobLayout layout):
+	m_num(num), m_channel(channel), m_height(height), m_width(width),
+	m_offset(0), m_memory(BlobMemory::kEXTERNAL), m_layout(layout)
+{
+	reset_steps();
+	allocate(allocator, init);
+}
+
+template <typename T>
+DataBlob<T>::DataBlob(DataBlobShape shape, const BlobAllocator &allocator, BlobInit init, BlobLayout layout):
+	DataBlob(shape.nums(), shape.channels(), shape.heights(), shape.widths(), allocator, init, layout)
+{}
+
+template <typename T>
+void DataBlob<T>::allocate(const BlobAllocator &allocator, BlobInit init)
+{
+	size_t bytes = sizeof(T) * total_n_elem();
+	std::shared_ptr<void> storage = init == BlobInit::kLAZY_ZEROED ? zeroedAlloc(m_memory, bytes) : nullptr;
+	bool zeroed = storage != nullptr;
+	if (!storage) {
+		storage = allocator ? allocator(bytes) : nullptr;
+	}
+	if (!storage) {
+		throw std::bad_alloc();
+	}
+	// the blob shares ownership of the storage, whatever its deleter
+	m_data = std::shared_ptr<T>(storage, static_cast<T *>(storage.get()));
+	if (init != BlobInit::kUNINITIALIZED && !zeroed) {
+		memset(m_data.get(), 0, bytes);
+	}
+}
+
+template <typename T>
+void DataBlob<T>::reset_steps()
+{
+	if (m_layout == BlobLayout::kNCHW) {
+		m_pixel_step = 1;
+		m_step = m_width;
+		m_plane_step = m_height * m_width;
+	} else {
+		m_pixel_step = m_channel;
+		m_step = m_width * m_channel;
+		m_plane_step = 1;
+	}
+	m_sample_step = inst_n_elem();
 }
 
 template <typename T>
@@ -24,14 +148,16 @@ DataBlob<T>::DataBlob(DataBlobShape shape):
 {}
 
 template <typename T>
-DataBlob<T>::DataBlob(size_t nums, size_t channels, size_t height, size_t width, T *data):
+DataBlob<T>::DataBlob(size_t nums, size_t channels, size_t height, size_t width, T *data, BlobLayout layout):
 	m_num(nums), m_channel(channels), m_height(height), m_width(width),
-	m_step(width * channels), m_data(data, [](T *) {}), m_offset(0)
-{}
+	m_data(data, [](T *) {}), m_offset(0), m_memory(BlobMemory::kEXTERNAL), m_layout(layout)
+{
+	reset_steps();
+}
 
 template <typename T>
-DataBlob<T>::DataBlob(DataBlobShape shape, T *data):
-	DataBlob(shape.nums(), shape.channels(), shape.heights(), shape.widths(), data)
+DataBlob<T>::DataBlob(DataBlobShape shape, T *data, BlobLayout layout):
+	DataBlob(shape.nums(), shape.channels(), shape.heights(), shape.widths(), data, layout)
 {}
 
 template <typename T>
@@ -39,8 +165,8 @@ DataBlob<T>::DataBlob(const DataBlob<T> &rhs):
 	m_num(rhs.m_num),
 	m_channel(rhs.m_channel),
 	m_height(rhs.m_height), m_width(rhs.m_width), 
-	m_step(rhs.m_step),
-	m_data(rhs.m_data), m_offset(0)
+	m_step(rhs.m_step), m_pixel_step(rhs.m_pixel_step), m_plane_step(rhs.m_plane_step), m_sample_step(rhs.m_sample_step),
+	m_data(rhs.m_data), m_offset(rhs.m_offset), m_memory(rhs.m_memory), m_layout(rhs.m_layout)
 {}
 
 template <typename T>
@@ -51,63 +177,178 @@ DataBlob<T> &DataBlob<T>::operator=(const DataBlob<T> &rhs)
 	this->m_height = rhs.m_height;
 	this->m_width = rhs.m_width;
 	this->m_step = rhs.m_step;
+	this->m_pixel_step = rhs.m_pixel_step;
+	this->m_plane_step = rhs.m_plane_step;
+	this->m_sample_step = rhs.m_sample_step;
 	this->m_data = rhs.m_data;
 	this->m_offset = rhs.m_offset;
+	this->m_memory = rhs.m_memory;
+	this->m_layout = rhs.m_layout;
 	return *this;
 }
 
 template <typename T>
 T &DataBlob<T>::at(size_t n, size_t c, size_t h, size_t w)
 {
-	CHECK(h < m_height && w < m_width && c < m_channel && n < m_num);
-	return ptr(n)[c*(m_width*m_height)+ h * m_width + w];
+	// CHECK() aborts on a nonzero value
+	CHECK(!(h < m_height && w < m_width && c < m_channel && n < m_num));
+	return row(n, c, h)[w * m_pixel_step];
 }
 
 template <typename T>
 const T &DataBlob<T>::at(size_t n, size_t c, size_t h, size_t w) const
 {
-	CHECK(h < m_height && w < m_width && c < m_channel && n < m_num);
-	return ptr(n)[c*(m_width*m_height)+ h * m_width + w];
+	// CHECK() aborts on a nonzero value
+	CHECK(!(h < m_height && w < m_width && c < m_channel && n < m_num));
+	return row(n, c, h)[w * m_pixel_step];
 }
 
 template <typename T>
-DataBlob<T> DataBlob<T>::clone() const
+DataBlob<T> DataBlob<T>::view(size_t n, size_t c, size_t h, size_t w, size_t offset) const
 {
-	DataBlob<T> res(m_num, m_channel, m_height, m_width);
-	for (size_t r = 0; r < m_num; ++r) {
-		memcpy(res.ptr(r), this->ptr(r), sizeof(T) * this->inst_n_elem());
+	DataBlob<T> res(*this);
+	res.m_num = n;
+	res.m_channel = c;
+	res.m_height = h;
+	res.m_width = w;
+	res.m_offset = m_offset + offset;
+	return res;
+}
+
+template <typename T>
+DataBlob<T> DataBlob<T>::slice_batch(size_t begin, size_t end) const
+{
+	if (begin > end || end > m_num) {
+		throw std::out_of_range("DataBlob::slice_batch");
 	}
+	return view(end - begin, m_channel, m_height, m_width, begin * m_sample_step);
+}
+
+template <typename T>
+DataBlob<T> DataBlob<T>::slice_channels(size_t begin, size_t end) const
+{
+	if (begin > end || end > m_channel) {
+		throw std::out_of_range("DataBlob::slice_channels");
+	}
+	return view(m_num, end - begin, m_height, m_width, begin * m_plane_step);
+}
+
+template <typename T>
+DataBlob<T> DataBlob<T>::roi(size_t top, size_t left, size_t height, size_t width) const
+{
+	if (top + height > m_height || left + width > m_width) {
+		throw std::out_of_range("DataBlob::roi");
+	}
+	return view(m_num, m_channel, height, width, top * m_step + left * m_pixel_step);
+}
+
+template <typename T>
+DataBlob<T> DataBlob<T>::clone() const
+{
+	DataBlob<T> res(shape(), BlobMemory::kHEAP, BlobInit::kUNINITIALIZED, m_layout);
+	copy_to(res);
+	return res;
+}
+
+template <typename T>
+DataBlob<T> DataBlob<T>::clone(BlobMemory memory) const
+{
+	DataBlob<T> res(shape(), memory, BlobInit::kUNINITIALIZED, m_layout);
+	copy_to(res);
+	return res;
+}
+
+template <typename T>
+DataBlob<T> DataBlob<T>::to_layout(BlobLayout layout, BlobMemory memory) const
+{
+	DataBlob<T> res(shape(), memory, BlobInit::kUNINITIALIZED, layout);
+	copy_to(res);
 	return res;
 }
 
+template <typename T>
+void DataBlob<T>::copy_to(DataBlob<T> &dst) const
+{
+	// a mismatched destination would be overrun
+	CHECK(!(shape() == dst.shape()));
+	if (is_continuous() && dst.is_continuous()) {
+		convertLayout(ptr(), m_layout, dst.ptr(), dst.m_layout, m_num, m_channel, m_height, m_width);
+		return;
+	}
+	for (size_t n = 0; n < m_num; ++n) {
+		if (m_layout == dst.m_layout && m_pixel_step == 1 && dst.m_pixel_step == 1) {
+			// rows of a planar view
+			for (size_t c = 0; c < m_channel; ++c) {
+				for (size_t h = 0; h < m_height; ++h) {
+					memcpy(dst.row(n, c, h), row(n, c, h), sizeof(T) * m_width);
+				}
+			}
+		} else if (m_layout == dst.m_layout && m_pixel_step == m_channel && dst.m_pixel_step == m_channel) {
+			// rows of whole pixels of an interleaved view
+			for (size_t h = 0; h < m_height; ++h) {
+				memcpy(dst.row(n, 0, h), row(n, 0, h), sizeof(T) * m_width * m_channel);
+			}
+		} else {
+			for (size_t c = 0; c < m_channel; ++c) {
+				for (size_t h = 0; h < m_height; ++h) {
+					const T *s = row(n, c, h);
+					T *d = dst.row(n, c, h);
+					for (size_t w = 0; w < m_width; ++w) {
+						d[w * dst.m_pixel_step] = s[w * m_pixel_step];
+					}
+				}
+			}
+		}
+	}
+}
+
 template <typename T>
 bool DataBlob<T>::equals(const DataBlob<T> &rhs) const
 {
-	if (this->m_height != rhs.m_height) return false;
-	if (this->m_width != rhs.m_width) return false;
-	if (this->m_channel != rhs.m_channel) return false;
-	for (size_t r = 0; r < m_height; ++r) {
-		if (0 != memcmp(this->ptr(r), rhs.ptr(r), sizeof(T) * inst_n_elem())) return false;
+	if (!(shape() == rhs.shape())) return false;
+	if (m_layout == rhs.m_layout && is_continuous() && rhs.is_continuous()) {
+		return 0 == memcmp(ptr(), rhs.ptr(), sizeof(T) * total_n_elem());
+	}
+	for (size_t n = 0; n < m_num; ++n) {
+		for (size_t c = 0; c < m_channel; ++c) {
+			for (size_t h = 0; h < m_height; ++h) {
+				const T *l = row(n, c, h);
+				const T *r = rhs.row(n, c, h);
+				for (size_t w = 0; w < m_width; ++w) {
+					if (memcmp(l + w * m_pixel_step, r + w * rhs.m_pixel_step, sizeof(T))) return false;
+				}
+			}
+		}
 	}
 	return true;
 }
 
 template <typename T>
 bool DataBlob<T>::is_continuous() const
-{ return m_step == m_width * m_channel; }
+{
+	// the step of a single pixel, row, plane or sample does not matter
+	bool samples = m_sample_step == inst_n_elem() || m_num <= 1;
+	if (m_layout == BlobLayout::kNCHW) {
+		return (m_step == m_width || m_height <= 1)
+			&& (m_plane_step == m_height * m_width || m_channel <= 1) && samples;
+	}
+	return (m_plane_step == 1 || m_channel <= 1)
+		&& (m_pixel_step == m_channel || m_width <= 1)
+		&& (m_step == m_width * m_channel || m_height <= 1) && samples;
+}
 
 template <typename T>
 void DataBlob<T>::read(const T *src)
 {
-	CHECK(is_continuous());
-	memcpy(m_data.get(), src, sizeof(T) * this->total_n_elem());
+	DataBlob<T> contiguous(shape(), const_cast<T *>(src), m_layout);
+	contiguous.copy_to(*this);
 }
 
 template <typename T>
 void DataBlob<T>::write(T *dst) const
 {
-	CHECK(is_continuous());
-	memcpy(dst, m_data.get(), sizeof(T) * this->total_n_elem());
+	DataBlob<T> contiguous(shape(), dst, m_layout);
+	copy_to(contiguous);
 }
 
 template <typename T>
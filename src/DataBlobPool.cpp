@@ -0,0 +1,89 @@
+#include <DataBlobPool.h>
+#include <iomanip>
+
+std::ostream& operator<<(std::ostream& out, const DataBlobPoolStats& value) {
+	out << std::fixed << std::setprecision(1) << value.hitRate() * 100 << "% hits (" << value.hits << "/"
+		<< value.hits + value.misses << "), " << value.recycled << " recycled, " << value.releases << " released, "
+		<< (value.bytesCached >> 10) << " KB cached in " << value.blocksCached << " blocks";
+	return out;
+}
+
+DataBlobPool::DataBlobPool(BlobMemory memory, size_t maxCachedBytes)
+	: mAllocator(blobAllocator(memory)), mState(std::make_shared<State>())
+{
+	mState->maxCachedBytes = maxCachedBytes;
+}
+
+DataBlobPool& DataBlobPool::instance() {
+	// never destroyed, blobs may be released by static destructors of other units
+	static DataBlobPool* pool = new DataBlobPool();
+	return *pool;
+}
+
+std::shared_ptr<void> DataBlobPool::take(const Key& key, size_t bytes) {
+	std::shared_ptr<void> storage;
+	{
+		std::lock_guard<std::mutex> lock(mState->mutex);
+		auto list = mState->lists.find(key);
+		if (list != mState->lists.end() && !list->second.empty()) {
+			storage = std::move(list->second.back());
+			list->second.pop_back();
+			--mState->stats.blocksCached;
+			mState->stats.bytesCached -= bytes;
+			++mState->stats.hits;
+		} else {
+			++mState->stats.misses;
+		}
+	}
+	if (!storage) {
+		storage = mAllocator ? mAllocator(bytes) : nullptr;
+		if (!storage) {
+			return nullptr;
+		}
+	}
+	// the blob owns a handle whose deleter hands the storage back
+	std::weak_ptr<State> state = mState;
+	void* data = storage.get();
+	return std::shared_ptr<void>(data, [state, key, bytes, storage](void*) { recycle(state, key, bytes, storage); });
+}
+
+void DataBlobPool::recycle(const std::weak_ptr<State>& state, const Key& key, size_t bytes, const std::shared_ptr<void>& storage) {
+	std::shared_ptr<State> pool = state.lock();
+	if (!pool) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(pool->mutex);
+	++pool->stats.recycled;
+	if (pool->stats.bytesCached + bytes > pool->maxCachedBytes) {
+		// dropped with the deleter, outside the lock
+		++pool->stats.releases;
+		return;
+	}
+	pool->lists[key].push_back(storage);
+	++pool->stats.blocksCached;
+	pool->stats.bytesCached += bytes;
+}
+
+size_t DataBlobPool::trim() {
+	std::map<Key, std::vector<std::shared_ptr<void>>> lists;
+	size_t released = 0;
+	{
+		std::lock_guard<std::mutex> lock(mState->mutex);
+		lists.swap(mState->lists);
+		released = mState->stats.bytesCached;
+		mState->stats.releases += mState->stats.blocksCached;
+		mState->stats.bytesCached = 0;
+		mState->stats.blocksCached = 0;
+	}
+	return released;
+}
+
+void DataBlobPool::setMaxCachedBytes(size_t bytes) {
+	std::lock_guard<std::mutex> lock(mState->mutex);
+	mState->maxCachedBytes = bytes;
+}
+
+DataBlobPoolStats DataBlobPool::stats() const {
+	std::lock_guard<std::mutex> lock(mState->mutex);
+	return mState->stats;
+}
@@ -0,0 +1,225 @@
+#include <DynamicBatcher.h>
+#include <DataBlobPool.h>
+#include <common/logger.h>
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+
+Histogram::Histogram(std::vector<double> upperBounds)
+	: mUpperBounds(std::move(upperBounds)), mCounts(mUpperBounds.size() + 1, 0)
+{}
+
+Histogram Histogram::linear(size_t n) {
+	std::vector<double> bounds;
+	for (size_t i = 1; i <= n; ++i) {
+		bounds.push_back(static_cast<double>(i));
+	}
+	return Histogram(bounds);
+}
+
+Histogram Histogram::exponential(size_t n) {
+	std::vector<double> bounds;
+	for (size_t i = 0; i < n; ++i) {
+		bounds.push_back(static_cast<double>(1ULL << i));
+	}
+	return Histogram(bounds);
+}
+
+void Histogram::add(double value) {
+	size_t bucket = std::lower_bound(mUpperBounds.begin(), mUpperBounds.end(), value) - mUpperBounds.begin();
+	++mCounts[bucket];
+	++mTotal;
+	mSum += value;
+}
+
+std::ostream& operator<<(std::ostream& out, const Histogram& value) {
+	for (size_t i = 0; i < value.mCounts.size(); ++i) {
+		if (value.mCounts[i] == 0) {
+			continue;
+		}
+		if (i < value.mUpperBounds.size()) {
+			out << "<= " << std::setw(12) << value.mUpperBounds[i];
+		} else if (!value.mUpperBounds.empty()) {
+			out << " > " << std::setw(12) << value.mUpperBounds.back();
+		} else {
+			out << "   " << std::setw(12) << "all";
+		}
+		out << " " << std::setw(12) << value.mCounts[i] << std::endl;
+	}
+	out << "total " << value.mTotal << ", mean " << value.mean() << std::endl;
+	return out;
+}
+
+std::ostream& operator<<(std::ostream& out, const DynamicBatcherStats& value) {
+	out << "========== batch size ==========" << std::endl << value.batchSize;
+	out << "========== queue delay (us) ==========" << std::endl << value.queueDelayUs;
+	out << "failed batches " << value.failedBatches << std::endl;
+	return out;
+}
+
+DynamicBatcher::DynamicBatcher(IBaseModel& model, const DynamicBatcherParams& params)
+	: mModel(model), mParams(params) {
+	mParams.maxBatchSize = std::max(mParams.maxBatchSize, 1);
+	mStats.batchSize = Histogram::linear(mParams.maxBatchSize);
+	mStats.queueDelayUs = Histogram::exponential(24);
+	for (int i = 0; i < std::max(mParams.nbWorkers, 1); ++i) {
+		mWorkers.emplace_back(&DynamicBatcher::workerLoop, this);
+	}
+}
+
+DynamicBatcher::~DynamicBatcher() {
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mQueueChanged.notify_all();
+	for (auto& worker : mWorkers) {
+		worker.join();
+	}
+}
+
+std::future<std::vector<DataBlob32f>> DynamicBatcher::submit(const std::vector<DataBlob32f>& sample) {
+	Request request;
+	request.inputs = sample;
+	request.arrival = clock_type::now();
+	std::future<std::vector<DataBlob32f>> result = request.result.get_future();
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQueue.push_back(std::move(request));
+	}
+	mQueueChanged.notify_one();
+	return result;
+}
+
+DynamicBatcherStats DynamicBatcher::stats() const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStats;
+}
+
+void DynamicBatcher::workerLoop() {
+	const size_t maxBatchSize = static_cast<size_t>(mParams.maxBatchSize);
+	while (true) {
+		std::vector<Request> batch;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mQueueChanged.wait(lock, [this] { return mStopping || !mQueue.empty(); });
+			// wait for the batch to fill, or for the oldest request to run out of time
+			while (!mStopping && !mQueue.empty() && mQueue.size() < maxBatchSize) {
+				clock_type::time_point deadline = mQueue.front().arrival + mParams.maxDelay;
+				if (clock_type::now() >= deadline) {
+					break;
+				}
+				mQueueChanged.wait_until(lock, deadline);
+			}
+			if (mQueue.empty()) {
+				if (mStopping) {
+					return;
+				}
+				continue;
+			}
+			clock_type::time_point now = clock_type::now();
+			size_t n = std::min(mQueue.size(), maxBatchSize);
+			for (size_t i = 0; i < n; ++i) {
+				mStats.queueDelayUs.add(std::chrono::duration<double, std::micro>(now - mQueue.front().arrival).count());
+				batch.push_back(std::move(mQueue.front()));
+				mQueue.pop_front();
+			}
+			mStats.batchSize.add(static_cast<double>(n));
+			if (!mQueue.empty()) {
+				mQueueChanged.notify_one();
+			}
+		}
+		runBatch(batch);
+	}
+}
+
+void DynamicBatcher::runBatch(std::vector<Request>& batch) {
+	// requests whose inputs do not match the model are rejected on their own. A model that does
+	// not report its inputs is matched against the first well-formed request
+	std::vector<DataBlobShape> shapes = mModel.inputShapes();
+	std::vector<Request> valid;
+	for (auto& request : batch) {
+		bool ok = !request.inputs.empty();
+		for (auto& blob : request.inputs) {
+			ok = ok && blob.nums() == 1;
+		}
+		if (ok && shapes.empty()) {
+			for (auto& blob : request.inputs) {
+				shapes.push_back(blob.shape());
+			}
+		}
+		ok = ok && request.inputs.size() == shapes.size();
+		for (size_t i = 0; ok && i < shapes.size(); ++i) {
+			ok = request.inputs[i].shape() == shapes[i];
+		}
+		if (ok) {
+			valid.push_back(std::move(request));
+		} else {
+			LOG_ERROR(gLogger) << "DynamicBatcher: request inputs do not match the batch" << std::endl;
+			request.result.set_value({});
+		}
+	}
+
+	size_t n = valid.size();
+	if (n == 0) {
+		return;
+	}
+	size_t batchNum = mParams.padBatch ? std::max(n, static_cast<size_t>(mParams.maxBatchSize)) : n;
+	// a worker must not die with the batch, its requests see the exception instead
+	auto fail = [&](std::exception_ptr error) {
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			++mStats.failedBatches;
+		}
+		for (auto& request : valid) {
+			request.result.set_exception(error);
+		}
+	};
+	std::vector<DataBlob32f> outputs;
+	try {
+		std::vector<DataBlob32f> inputs;
+		for (size_t i = 0; i < shapes.size(); ++i) {
+			DataBlob32f blob = DataBlobPool::instance().acquire<float>(
+				DataBlobShape(batchNum, shapes[i].channels(), shapes[i].heights(), shapes[i].widths()), BlobInit::kUNINITIALIZED);
+			for (size_t k = 0; k < n; ++k) {
+				DataBlob32f sample = blob.slice_batch(k, k + 1);
+				valid[k].inputs[i].copy_to(sample);
+			}
+			// only the padding samples are zeroed
+			memset(blob.ptr(n), 0, sizeof(float) * (batchNum - n) * blob.inst_n_elem());
+			inputs.push_back(blob);
+		}
+		outputs = mModel.infer(inputs);
+	} catch (std::exception& e) {
+		LOG_ERROR(gLogger) << "DynamicBatcher: " << e.what() << std::endl;
+		fail(std::current_exception());
+		return;
+	} catch (...) {
+		LOG_ERROR(gLogger) << "DynamicBatcher: unknown exception" << std::endl;
+		fail(std::current_exception());
+		return;
+	}
+	bool ok = !outputs.empty();
+	for (auto& output : outputs) {
+		ok = ok && output.nums() >= n;
+	}
+	if (!ok) {
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			++mStats.failedBatches;
+		}
+		for (auto& request : valid) {
+			request.result.set_value({});
+		}
+		return;
+	}
+	for (size_t k = 0; k < n; ++k) {
+		std::vector<DataBlob32f> result;
+		// views of the batch outputs, which are recycled once every request has dropped its samples
+		for (auto& output : outputs) {
+			result.push_back(output.slice_batch(k, k + 1));
+		}
+		valid[k].result.set_value(std::move(result));
+	}
+}
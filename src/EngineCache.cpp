@@ -0,0 +1,88 @@
+#include <EngineCache.h>
+#include <common/logger.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <functional>
+
+void EngineKey::update(const void* data, size_t size) {
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; ++i) {
+		mHash ^= bytes[i];
+		mHash *= 1099511628211ULL;
+	}
+}
+
+EngineKey& EngineKey::add(const void* data, size_t size) {
+	uint64_t length = size;
+	update(&length, sizeof(length));
+	update(data, size);
+	return *this;
+}
+
+bool EngineKey::addFile(const std::string& path) {
+	dtrCommon::MappedFile file(path, dtrCommon::MappedFile::Prefetch::kREADAHEAD);
+	if (!file) {
+		// an empty file is a valid input, only a missing one is an error
+		struct stat st;
+		if (::stat(path.c_str(), &st) != 0 || st.st_size != 0) {
+			return false;
+		}
+	}
+	add(file.data(), file.size());
+	return true;
+}
+
+std::string EngineKey::str() const {
+	char hex[17];
+	snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(mHash));
+	return hex;
+}
+
+std::string EngineCache::pathOf(const EngineKey& key) const {
+	return mDirectory + "/" + key.str() + ".engine";
+}
+
+dtrCommon::MappedFile EngineCache::load(const EngineKey& key) const {
+	return dtrCommon::MappedFile(pathOf(key));
+}
+
+bool EngineCache::store(const EngineKey& key, const void* data, size_t size) const {
+	if (::mkdir(mDirectory.c_str(), 0755) != 0 && errno != EEXIST) {
+		LOG_ERROR(gLogger) << "could not create engine cache directory " << mDirectory << ": " << strerror(errno) << std::endl;
+		return false;
+	}
+	std::string path = pathOf(key);
+	std::string tmpPath = path + ".tmp." + std::to_string(::getpid()) + "."
+		+ std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+	int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		LOG_ERROR(gLogger) << "could not write " << tmpPath << ": " << strerror(errno) << std::endl;
+		return false;
+	}
+	const char* bytes = static_cast<const char*>(data);
+	size_t written = 0;
+	while (written < size) {
+		ssize_t n = ::write(fd, bytes + written, size - written);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			break;
+		}
+		written += static_cast<size_t>(n);
+	}
+	bool status = written == size && ::fsync(fd) == 0;
+	status = ::close(fd) == 0 && status;
+	// rename() replaces the entry atomically, readers see the old plan or the whole new one
+	if (!status || ::rename(tmpPath.c_str(), path.c_str()) != 0) {
+		LOG_ERROR(gLogger) << "could not store engine " << path << ": " << strerror(errno) << std::endl;
+		::unlink(tmpPath.c_str());
+		return false;
+	}
+	return true;
+}
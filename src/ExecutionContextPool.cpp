@@ -0,0 +1,111 @@
+#include <ExecutionContextPool.h>
+#include <common/logger.h>
+
+ExecutionContextPool::Lease::Lease(std::shared_ptr<ExecutionContextPool> pool, int index)
+	: mPool(std::move(pool)), mSlot(mPool->mSlots[index].get()), mIndex(index)
+{}
+
+ExecutionContextPool::Lease::Lease(Lease&& rhs)
+	: mPool(std::move(rhs.mPool)), mSlot(rhs.mSlot), mIndex(rhs.mIndex) {
+	rhs.mSlot = nullptr;
+	rhs.mIndex = -1;
+}
+
+ExecutionContextPool::Lease& ExecutionContextPool::Lease::operator=(Lease&& rhs) {
+	if (this != &rhs) {
+		release();
+		mPool = std::move(rhs.mPool);
+		mSlot = rhs.mSlot;
+		mIndex = rhs.mIndex;
+		rhs.mSlot = nullptr;
+		rhs.mIndex = -1;
+	}
+	return *this;
+}
+
+void ExecutionContextPool::Lease::release() {
+	if (mSlot) {
+		mPool->release(mIndex);
+		mSlot = nullptr;
+		mIndex = -1;
+	}
+	mPool.reset();
+}
+
+ExecutionContextPool::ExecutionContextPool(std::shared_ptr<nvinfer1::ICudaEngine> engine, int batchSize,
+	std::vector<int> inputBindings, std::vector<int> outputBindings)
+	: mEngine(std::move(engine)), mBatchSize(batchSize), mInputBindings(std::move(inputBindings)),
+	mOutputBindings(std::move(outputBindings))
+{}
+
+std::shared_ptr<ExecutionContextPool> ExecutionContextPool::create(std::shared_ptr<nvinfer1::ICudaEngine> engine, int batchSize, int nbSlots,
+	std::vector<int> inputBindings, std::vector<int> outputBindings, dtrCommon::HostMemoryType hostMemoryType,
+	dtrCommon::BufferLayout layout) {
+	if (!engine) {
+		return nullptr;
+	}
+	std::shared_ptr<ExecutionContextPool> pool(new ExecutionContextPool(engine, batchSize,
+		std::move(inputBindings), std::move(outputBindings)));
+	for (int i = 0; i < std::max(nbSlots, 1); ++i) {
+		std::unique_ptr<ExecutionSlot> slot(new ExecutionSlot());
+		slot->context.reset(engine->createExecutionContext());
+		if (!slot->context) {
+			LOG_ERROR(gLogger) << "IExecutionContext create failed\n";
+			return nullptr;
+		}
+		CHECK(cudaStreamCreate(&slot->stream));
+		// the device buffers are cached for the stream of the slot, the one they are used on
+		slot->buffers.reset(new dtrCommon::BufferManager(engine, batchSize, hostMemoryType, layout, slot->stream));
+		pool->mSlots.push_back(std::move(slot));
+		pool->mFreeSlots.push_back(i);
+	}
+	return pool;
+}
+
+ExecutionContextPool::~ExecutionContextPool() {
+	for (auto& slot : mSlots) {
+		if (slot->stream) {
+			cudaStreamSynchronize(slot->stream);
+			// nothing allocates for the stream again, its cached blocks would never be reused
+			slot->buffers.reset();
+			dtrCommon::CachingDeviceAllocator::instance().trimStream(slot->stream);
+			cudaStreamDestroy(slot->stream);
+		}
+	}
+}
+
+ExecutionContextPool::Lease ExecutionContextPool::acquire() {
+	std::unique_lock<std::mutex> lock(mMutex);
+	mSlotReleased.wait(lock, [this] { return !mFreeSlots.empty(); });
+	int index = mFreeSlots.back();
+	mFreeSlots.pop_back();
+	return Lease(shared_from_this(), index);
+}
+
+ExecutionContextPool::Lease ExecutionContextPool::tryAcquire() {
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (mFreeSlots.empty()) {
+		return Lease();
+	}
+	int index = mFreeSlots.back();
+	mFreeSlots.pop_back();
+	return Lease(shared_from_this(), index);
+}
+
+void ExecutionContextPool::waitIdle() {
+	std::unique_lock<std::mutex> lock(mMutex);
+	mIdle.wait(lock, [this] { return mFreeSlots.size() == mSlots.size(); });
+}
+
+void ExecutionContextPool::release(int index) {
+	bool idle = false;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mFreeSlots.push_back(index);
+		idle = mFreeSlots.size() == mSlots.size();
+	}
+	mSlotReleased.notify_one();
+	if (idle) {
+		mIdle.notify_all();
+	}
+}
@@ -0,0 +1,414 @@
+#include <LayoutConvert.h>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+#ifdef DTR_SIMD_X86
+#include <immintrin.h>
+
+// the avx512 intrinsics of gcc 12 self-initialize their undefined operands, which -Wall flags when inlined
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+using dtrCommon::SimdLevel;
+
+namespace {
+// a tile of kTile x kTile elements is read and written while it is in L1
+const size_t kTile = 32;
+// below this many elements a thread costs more than it saves
+const size_t kMinElementsPerThread = 1 << 16;
+
+// dst[j * ds + i] = src[i * ss + j] for i < rows, j < cols
+template <typename T>
+void transposeScalar(const T *src, size_t ss, T *dst, size_t ds, size_t rows, size_t cols) {
+	for (size_t i0 = 0; i0 < rows; i0 += kTile) {
+		size_t i1 = std::min(i0 + kTile, rows);
+		for (size_t j0 = 0; j0 < cols; j0 += kTile) {
+			size_t j1 = std::min(j0 + kTile, cols);
+			for (size_t i = i0; i < i1; ++i) {
+				for (size_t j = j0; j < j1; ++j) {
+					dst[j * ds + i] = src[i * ss + j];
+				}
+			}
+		}
+	}
+}
+
+#ifdef DTR_SIMD_X86
+using TileKernel = void (*)(const float *, size_t, float *, size_t);
+using TransposeKernel = void (*)(const float *, size_t, float *, size_t, size_t, size_t);
+
+// transposes the rows x cols block rounded down to tiles of B by kernel, the strips left over by next;
+// inlined into the callers so that kernel is compiled for their target
+template <size_t B, TileKernel kernel, TransposeKernel next>
+__attribute__((always_inline)) inline
+void transposeTiled(const float *src, size_t ss, float *dst, size_t ds, size_t rows, size_t cols) {
+	size_t rowsB = rows / B * B;
+	size_t colsB = cols / B * B;
+	for (size_t i0 = 0; i0 < rowsB; i0 += kTile) {
+		size_t i1 = std::min(i0 + kTile, rowsB);
+		for (size_t j0 = 0; j0 < colsB; j0 += kTile) {
+			size_t j1 = std::min(j0 + kTile, colsB);
+			for (size_t i = i0; i < i1; i += B) {
+				for (size_t j = j0; j < j1; j += B) {
+					kernel(src + i * ss + j, ss, dst + j * ds + i, ds);
+				}
+			}
+		}
+	}
+	if (colsB < cols) {
+		next(src + colsB, ss, dst + colsB * ds, ds, rowsB, cols - colsB);
+	}
+	if (rowsB < rows) {
+		next(src + rowsB * ss, ss, dst + rowsB, ds, rows - rowsB, cols);
+	}
+}
+
+__attribute__((target("sse4.1")))
+inline void tile4x4(const float *s, size_t ss, float *d, size_t ds) {
+	__m128 r0 = _mm_loadu_ps(s);
+	__m128 r1 = _mm_loadu_ps(s + ss);
+	__m128 r2 = _mm_loadu_ps(s + 2 * ss);
+	__m128 r3 = _mm_loadu_ps(s + 3 * ss);
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	_mm_storeu_ps(d, r0);
+	_mm_storeu_ps(d + ds, r1);
+	_mm_storeu_ps(d + 2 * ds, r2);
+	_mm_storeu_ps(d + 3 * ds, r3);
+}
+
+__attribute__((target("sse4.1")))
+void transposeSse(const float *src, size_t ss, float *dst, size_t ds, size_t rows, size_t cols) {
+	transposeTiled<4, tile4x4, transposeScalar<float>>(src, ss, dst, ds, rows, cols);
+}
+
+__attribute__((target("avx2")))
+inline void tile8x8(const float *s, size_t ss, float *d, size_t ds) {
+	__m256 r[8], t[8];
+	for (int k = 0; k < 8; ++k) {
+		r[k] = _mm256_loadu_ps(s + k * ss);
+	}
+	for (int k = 0; k < 8; k += 2) {
+		t[k] = _mm256_unpacklo_ps(r[k], r[k + 1]);
+		t[k + 1] = _mm256_unpackhi_ps(r[k], r[k + 1]);
+	}
+	for (int k = 0; k < 8; k += 4) {
+		r[k] = _mm256_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(1, 0, 1, 0));
+		r[k + 1] = _mm256_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(3, 2, 3, 2));
+		r[k + 2] = _mm256_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(1, 0, 1, 0));
+		r[k + 3] = _mm256_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(3, 2, 3, 2));
+	}
+	for (int k = 0; k < 4; ++k) {
+		_mm256_storeu_ps(d + k * ds, _mm256_permute2f128_ps(r[k], r[k + 4], 0x20));
+		_mm256_storeu_ps(d + (k + 4) * ds, _mm256_permute2f128_ps(r[k], r[k + 4], 0x31));
+	}
+}
+
+__attribute__((target("avx2")))
+void transposeAvx2(const float *src, size_t ss, float *dst, size_t ds, size_t rows, size_t cols) {
+	transposeTiled<8, tile8x8, transposeSse>(src, ss, dst, ds, rows, cols);
+}
+
+__attribute__((target("avx512f")))
+inline void tile16x16(const float *s, size_t ss, float *d, size_t ds) {
+	__m512 r[16], t[16];
+	for (int k = 0; k < 16; ++k) {
+		r[k] = _mm512_loadu_ps(s + k * ss);
+	}
+	for (int k = 0; k < 16; k += 2) {
+		t[k] = _mm512_unpacklo_ps(r[k], r[k + 1]);
+		t[k + 1] = _mm512_unpackhi_ps(r[k], r[k + 1]);
+	}
+	for (int k = 0; k < 16; k += 4) {
+		r[k] = _mm512_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(1, 0, 1, 0));
+		r[k + 1] = _mm512_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(3, 2, 3, 2));
+		r[k + 2] = _mm512_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(1, 0, 1, 0));
+		r[k + 3] = _mm512_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(3, 2, 3, 2));
+	}
+	// rows k of each 128-bit lane now hold columns 4 * lane + k
+	for (int k = 0; k < 4; ++k) {
+		t[k] = _mm512_shuffle_f32x4(r[k], r[k + 4], 0x88);
+		t[k + 4] = _mm512_shuffle_f32x4(r[k], r[k + 4], 0xdd);
+		t[k + 8] = _mm512_shuffle_f32x4(r[k + 8], r[k + 12], 0x88);
+		t[k + 12] = _mm512_shuffle_f32x4(r[k + 8], r[k + 12], 0xdd);
+	}
+	for (int k = 0; k < 8; ++k) {
+		_mm512_storeu_ps(d + k * ds, _mm512_shuffle_f32x4(t[k], t[k + 8], 0x88));
+		_mm512_storeu_ps(d + (k + 8) * ds, _mm512_shuffle_f32x4(t[k], t[k + 8], 0xdd));
+	}
+}
+
+__attribute__((target("avx512f")))
+void transposeAvx512(const float *src, size_t ss, float *dst, size_t ds, size_t rows, size_t cols) {
+	transposeTiled<16, tile16x16, transposeAvx2>(src, ss, dst, ds, rows, cols);
+}
+
+//!
+//! Three channels of V pixels are 3 vectors a, b, c. Element e of the three holds channel
+//! e % 3 of pixel e / 3, and as V is not a multiple of 3, each vector holds a channel in
+//! lanes no other vector holds it in. A channel is blended from the three and permuted
+//! into pixel order, and the reverse interleaves them.
+//!
+template <int V>
+struct Interleave3 {
+	int gather[3][V];  // lane of the blend of channel k holding pixel p
+	int scatter[3][V]; // pixel of channel k that lane L of the blend holds
+	int select[3][3][V]; // -1 in the lanes vector s holds channel k in
+	unsigned int mask[3][3];
+	Interleave3() {
+		memset(mask, 0, sizeof(mask));
+		for (int s = 0; s < 3; ++s) {
+			for (int lane = 0; lane < V; ++lane) {
+				int e = s * V + lane;
+				for (int k = 0; k < 3; ++k) {
+					select[k][s][lane] = e % 3 == k ? -1 : 0;
+				}
+				mask[e % 3][s] |= 1U << lane;
+				gather[e % 3][e / 3] = lane;
+				scatter[e % 3][lane] = e / 3;
+			}
+		}
+	}
+	static const Interleave3 &get() {
+		static const Interleave3 tables;
+		return tables;
+	}
+};
+
+// out[k][i] = in[3 * i + k], the NHWC to NCHW conversion of a three channel sample
+void deinterleave3Scalar(const float *in, float *out0, float *out1, float *out2, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		out0[i] = in[3 * i];
+		out1[i] = in[3 * i + 1];
+		out2[i] = in[3 * i + 2];
+	}
+}
+
+void interleave3Scalar(const float *in0, const float *in1, const float *in2, float *out, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		out[3 * i] = in0[i];
+		out[3 * i + 1] = in1[i];
+		out[3 * i + 2] = in2[i];
+	}
+}
+
+__attribute__((target("sse4.1")))
+void deinterleave3Sse(const float *in, float *out0, float *out1, float *out2, size_t count) {
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 a = _mm_loadu_ps(in + 3 * i);
+		__m128 b = _mm_loadu_ps(in + 3 * i + 4);
+		__m128 c = _mm_loadu_ps(in + 3 * i + 8);
+		__m128 x = _mm_blend_ps(_mm_blend_ps(a, b, 0x4), c, 0x2);
+		__m128 y = _mm_blend_ps(_mm_blend_ps(b, a, 0x2), c, 0x4);
+		__m128 z = _mm_blend_ps(_mm_blend_ps(c, b, 0x2), a, 0x4);
+		_mm_storeu_ps(out0 + i, _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 2, 3, 0)));
+		_mm_storeu_ps(out1 + i, _mm_shuffle_ps(y, y, _MM_SHUFFLE(2, 3, 0, 1)));
+		_mm_storeu_ps(out2 + i, _mm_shuffle_ps(z, z, _MM_SHUFFLE(3, 0, 1, 2)));
+	}
+	deinterleave3Scalar(in + 3 * i, out0 + i, out1 + i, out2 + i, count - i);
+}
+
+__attribute__((target("sse4.1")))
+void interleave3Sse(const float *in0, const float *in1, const float *in2, float *out, size_t count) {
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		// the permutations of deinterleave3Sse are their own inverses
+		__m128 x = _mm_loadu_ps(in0 + i);
+		__m128 y = _mm_loadu_ps(in1 + i);
+		__m128 z = _mm_loadu_ps(in2 + i);
+		x = _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 2, 3, 0));
+		y = _mm_shuffle_ps(y, y, _MM_SHUFFLE(2, 3, 0, 1));
+		z = _mm_shuffle_ps(z, z, _MM_SHUFFLE(3, 0, 1, 2));
+		_mm_storeu_ps(out + 3 * i, _mm_blend_ps(_mm_blend_ps(x, y, 0x2), z, 0x4));
+		_mm_storeu_ps(out + 3 * i + 4, _mm_blend_ps(_mm_blend_ps(y, x, 0x4), z, 0x2));
+		_mm_storeu_ps(out + 3 * i + 8, _mm_blend_ps(_mm_blend_ps(z, x, 0x2), y, 0x4));
+	}
+	interleave3Scalar(in0 + i, in1 + i, in2 + i, out + 3 * i, count - i);
+}
+
+__attribute__((target("avx2")))
+void deinterleave3Avx2(const float *in, float *out0, float *out1, float *out2, size_t count) {
+	const Interleave3<8> &tables = Interleave3<8>::get();
+	float *out[3] = {out0, out1, out2};
+	__m256i gather[3], select[3][3];
+	for (int k = 0; k < 3; ++k) {
+		gather[k] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tables.gather[k]));
+		for (int s = 0; s < 3; ++s) {
+			select[k][s] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tables.select[k][s]));
+		}
+	}
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 a = _mm256_loadu_ps(in + 3 * i);
+		__m256 b = _mm256_loadu_ps(in + 3 * i + 8);
+		__m256 c = _mm256_loadu_ps(in + 3 * i + 16);
+		for (int k = 0; k < 3; ++k) {
+			__m256 blend = _mm256_blendv_ps(_mm256_blendv_ps(a, b, _mm256_castsi256_ps(select[k][1])), c,
+				_mm256_castsi256_ps(select[k][2]));
+			_mm256_storeu_ps(out[k] + i, _mm256_permutevar8x32_ps(blend, gather[k]));
+		}
+	}
+	deinterleave3Sse(in + 3 * i, out0 + i, out1 + i, out2 + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void interleave3Avx2(const float *in0, const float *in1, const float *in2, float *out, size_t count) {
+	const Interleave3<8> &tables = Interleave3<8>::get();
+	const float *in[3] = {in0, in1, in2};
+	__m256i scatter[3], select[3][3];
+	for (int k = 0; k < 3; ++k) {
+		scatter[k] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tables.scatter[k]));
+		for (int s = 0; s < 3; ++s) {
+			select[k][s] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tables.select[k][s]));
+		}
+	}
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 x[3];
+		for (int k = 0; k < 3; ++k) {
+			x[k] = _mm256_permutevar8x32_ps(_mm256_loadu_ps(in[k] + i), scatter[k]);
+		}
+		for (int s = 0; s < 3; ++s) {
+			__m256 v = _mm256_blendv_ps(_mm256_blendv_ps(x[0], x[1], _mm256_castsi256_ps(select[1][s])), x[2],
+				_mm256_castsi256_ps(select[2][s]));
+			_mm256_storeu_ps(out + 3 * i + 8 * s, v);
+		}
+	}
+	interleave3Sse(in0 + i, in1 + i, in2 + i, out + 3 * i, count - i);
+}
+
+__attribute__((target("avx512f")))
+void deinterleave3Avx512(const float *in, float *out0, float *out1, float *out2, size_t count) {
+	const Interleave3<16> &tables = Interleave3<16>::get();
+	float *out[3] = {out0, out1, out2};
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m512 a = _mm512_loadu_ps(in + 3 * i);
+		__m512 b = _mm512_loadu_ps(in + 3 * i + 16);
+		__m512 c = _mm512_loadu_ps(in + 3 * i + 32);
+		for (int k = 0; k < 3; ++k) {
+			__m512 blend = _mm512_mask_blend_ps(static_cast<__mmask16>(tables.mask[k][2]),
+				_mm512_mask_blend_ps(static_cast<__mmask16>(tables.mask[k][1]), a, b), c);
+			__m512i gather = _mm512_loadu_si512(tables.gather[k]);
+			_mm512_storeu_ps(out[k] + i, _mm512_permutexvar_ps(gather, blend));
+		}
+	}
+	deinterleave3Avx2(in + 3 * i, out0 + i, out1 + i, out2 + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+void interleave3Avx512(const float *in0, const float *in1, const float *in2, float *out, size_t count) {
+	const Interleave3<16> &tables = Interleave3<16>::get();
+	const float *in[3] = {in0, in1, in2};
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m512 x[3];
+		for (int k = 0; k < 3; ++k) {
+			__m512i scatter = _mm512_loadu_si512(tables.scatter[k]);
+			x[k] = _mm512_permutexvar_ps(scatter, _mm512_loadu_ps(in[k] + i));
+		}
+		for (int s = 0; s < 3; ++s) {
+			__m512 v = _mm512_mask_blend_ps(static_cast<__mmask16>(tables.mask[2][s]),
+				_mm512_mask_blend_ps(static_cast<__mmask16>(tables.mask[1][s]), x[0], x[1]), x[2]);
+			_mm512_storeu_ps(out + 3 * i + 16 * s, v);
+		}
+	}
+	interleave3Avx2(in0 + i, in1 + i, in2 + i, out + 3 * i, count - i);
+}
+
+#endif // DTR_SIMD_X86
+
+// other element types, and every type off x86, take the cache-blocked scalar path
+template <typename T>
+void transpose(const T *src, size_t ss, T *dst, size_t ds, size_t rows, size_t cols, SimdLevel) {
+	transposeScalar(src, ss, dst, ds, rows, cols);
+}
+
+#ifdef DTR_SIMD_X86
+template <>
+void transpose<float>(const float *src, size_t ss, float *dst, size_t ds, size_t rows, size_t cols, SimdLevel level) {
+	level = std::min(level, dtrCommon::cpuSimdLevel());
+	if (level != SimdLevel::kSCALAR && cols == 3 && ss == 3) {
+		auto kernel = level == SimdLevel::kAVX512 ? deinterleave3Avx512 : level == SimdLevel::kAVX2 ? deinterleave3Avx2 : deinterleave3Sse;
+		kernel(src, dst, dst + ds, dst + 2 * ds, rows);
+		return;
+	}
+	if (level != SimdLevel::kSCALAR && rows == 3 && ds == 3) {
+		auto kernel = level == SimdLevel::kAVX512 ? interleave3Avx512 : level == SimdLevel::kAVX2 ? interleave3Avx2 : interleave3Sse;
+		kernel(src, src + ss, src + 2 * ss, dst, cols);
+		return;
+	}
+	switch (level) {
+	case SimdLevel::kAVX512: transposeAvx512(src, ss, dst, ds, rows, cols); break;
+	case SimdLevel::kAVX2: transposeAvx2(src, ss, dst, ds, rows, cols); break;
+	case SimdLevel::kSSE: transposeSse(src, ss, dst, ds, rows, cols); break;
+	case SimdLevel::kSCALAR: transposeScalar(src, ss, dst, ds, rows, cols); break;
+	}
+}
+#endif
+
+// converts pixels [begin, end) of the batch, counted over all its samples
+template <typename T>
+void convertPixels(const T *src, BlobLayout from, T *dst, size_t channel, size_t pixels,
+	size_t begin, size_t end, SimdLevel level) {
+	while (begin < end) {
+		size_t sample = begin / pixels;
+		size_t first = begin % pixels;
+		size_t last = std::min(pixels, first + (end - begin));
+		const T *s = src + sample * channel * pixels;
+		T *d = dst + sample * channel * pixels;
+		if (from == BlobLayout::kNCHW) {
+			// channels x pixels to pixels x channels
+			transpose(s + first, pixels, d + first * channel, channel, channel, last - first, level);
+		} else {
+			transpose(s + first * channel, channel, d + first, pixels, last - first, channel, level);
+		}
+		begin += last - first;
+	}
+}
+}
+
+template <typename T>
+void convertLayout(const T *src, BlobLayout from, T *dst, BlobLayout to,
+	size_t n, size_t channel, size_t height, size_t width, SimdLevel level) {
+	size_t pixels = height * width;
+	if (from == to || channel == 1 || pixels == 1) {
+		memcpy(dst, src, sizeof(T) * n * channel * pixels);
+		return;
+	}
+	convertPixels(src, from, dst, channel, pixels, 0, n * pixels, level);
+}
+
+template <typename T>
+void convertLayoutParallel(const T *src, BlobLayout from, T *dst, BlobLayout to,
+	size_t n, size_t channel, size_t height, size_t width, size_t threads) {
+	size_t pixels = height * width;
+	size_t total = n * pixels;
+	if (threads == 0) {
+		threads = std::max(1U, std::thread::hardware_concurrency());
+	}
+	threads = std::min(threads, std::max<size_t>(1, total * channel / kMinElementsPerThread));
+	if (threads <= 1 || from == to || channel == 1 || pixels == 1) {
+		convertLayout(src, from, dst, to, n, channel, height, width);
+		return;
+	}
+	// whole tiles per thread, so no two threads write the same cache line of a tile
+	size_t chunk = (total + threads - 1) / threads;
+	chunk = (chunk + kTile - 1) / kTile * kTile;
+	SimdLevel level = layoutSimdLevel();
+	std::vector<std::thread> workers;
+	for (size_t begin = chunk; begin < total; begin += chunk) {
+		workers.emplace_back(convertPixels<T>, src, from, dst, channel, pixels, begin, std::min(total, begin + chunk), level);
+	}
+	convertPixels(src, from, dst, channel, pixels, 0, std::min(total, chunk), level);
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+template void convertLayout<uchar>(const uchar *, BlobLayout, uchar *, BlobLayout, size_t, size_t, size_t, size_t, SimdLevel);
+template void convertLayout<float>(const float *, BlobLayout, float *, BlobLayout, size_t, size_t, size_t, size_t, SimdLevel);
+template void convertLayoutParallel<uchar>(const uchar *, BlobLayout, uchar *, BlobLayout, size_t, size_t, size_t, size_t, size_t);
+template void convertLayoutParallel<float>(const float *, BlobLayout, float *, BlobLayout, size_t, size_t, size_t, size_t, size_t);
@@ -0,0 +1,81 @@
+#include <ModelLoader.h>
+#include <common/logger.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <thread>
+
+namespace {
+double elapsedMs(std::chrono::high_resolution_clock::time_point begin) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count();
+}
+}
+
+std::ostream& operator<<(std::ostream& out, const ModelLoadReport& value) {
+	out << value.name << ": " << (value.loaded ? "loaded" : value.skipped ? "skipped" : "FAILED")
+		<< std::fixed << std::setprecision(1) << ", build " << value.buildMs << " ms, warmup " << value.warmupMs << " ms";
+	return out;
+}
+
+bool ModelLoader::loadOne(CaffeModel& model, ModelLoadReport& report) {
+	auto begin = std::chrono::high_resolution_clock::now();
+	bool status = false;
+	try {
+		// build() runs the warmup batches, they pay for lazy cuda and cudnn initialization
+		status = model.build(model.mParams.gieFileName.empty());
+	} catch (std::exception& e) {
+		LOG_ERROR(gLogger) << report.name << ": " << e.what() << std::endl;
+	}
+	report.profile = model.startupProfile();
+	report.warmupMs = report.profile.warmupMs;
+	report.buildMs = elapsedMs(begin) - report.warmupMs;
+	if (!status) {
+		LOG_ERROR(gLogger) << report.name << " could not be built" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+std::vector<std::unique_ptr<CaffeModel>> ModelLoader::load(const std::vector<dtrCommon::CaffeNNParams>& models) {
+	std::vector<std::unique_ptr<CaffeModel>> results(models.size());
+	mReports.assign(models.size(), ModelLoadReport());
+	for (size_t i = 0; i < models.size(); ++i) {
+		mReports[i].name = models[i].gieFileName.empty() ? models[i].prototxtFileName : models[i].gieFileName;
+		mReports[i].skipped = true;
+	}
+
+	std::atomic<size_t> next{0};
+	std::atomic<bool> failed{false};
+	int device = 0;
+	CHECK(cudaGetDevice(&device));
+	auto worker = [&]() {
+		CHECK(cudaSetDevice(device));
+		for (size_t i = next++; i < models.size() && !failed; i = next++) {
+			mReports[i].skipped = false;
+			dtrCommon::CaffeNNParams params = models[i];
+			params.warmupIterations = mParams.warmupIterations;
+			std::unique_ptr<CaffeModel> model(new CaffeModel(params));
+			mReports[i].loaded = loadOne(*model, mReports[i]);
+			if (!mReports[i].loaded) {
+				failed = true;
+				continue;
+			}
+			results[i] = std::move(model);
+		}
+	};
+	size_t nbWorkers = std::min(models.size(), static_cast<size_t>(std::max(mParams.concurrency, 1)));
+	std::vector<std::thread> workers;
+	for (size_t i = 0; i < nbWorkers; ++i) {
+		workers.emplace_back(worker);
+	}
+	for (auto& thread : workers) {
+		thread.join();
+	}
+
+	if (failed) {
+		// the models that did load are released here, the caller gets all of them or none
+		results.clear();
+	}
+	return results;
+}
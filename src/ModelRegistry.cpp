@@ -0,0 +1,162 @@
+#include <ModelRegistry.h>
+#include <common/deviceAllocator.h>
+#include <common/logger.h>
+#include <chrono>
+#include <iomanip>
+
+std::ostream& operator<<(std::ostream& out, const ModelRegistryStats& value) {
+	out << value.name << ": " << (value.resident ? "resident" : "evicted") << ", " << (value.deviceMemory >> 20)
+		<< " MB device, " << (value.planSize >> 20) << " MB plan, " << value.reloads << " reloads"
+		<< std::fixed << std::setprecision(1) << " (last " << value.lastReloadMs << " ms, total " << value.totalReloadMs << " ms)";
+	return out;
+}
+
+bool ModelRegistry::add(const std::string& name, std::unique_ptr<CaffeModel> model) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (!model || !model->isBuilt() || mEntries.count(name)) {
+		LOG_ERROR(gLogger) << "ModelRegistry: can not add " << name << std::endl;
+		return false;
+	}
+	Entry entry;
+	if (!model->serializeEngine(entry.plan)) {
+		LOG_ERROR(gLogger) << "ModelRegistry: " << name << " could not be serialized" << std::endl;
+		return false;
+	}
+	entry.stats.name = name;
+	entry.stats.planSize = entry.plan.size();
+	entry.stats.deviceMemory = entry.plan.size() + model->deviceMemorySize();
+	entry.stats.resident = true;
+	entry.model = std::shared_ptr<CaffeModel>(model.release());
+	mLru.push_front(name);
+	entry.lru = mLru.begin();
+	mUsage += entry.stats.deviceMemory;
+	mEntries.insert(std::make_pair(name, std::move(entry)));
+	// the new model is the most recently used one, it goes last
+	makeRoom(0, nullptr);
+	return true;
+}
+
+//!
+//! \brief Returns the entry of name once no get() is loading it, end() if there is none.
+//!
+std::map<std::string, ModelRegistry::Entry>::iterator ModelRegistry::waitLoaded(std::unique_lock<std::mutex>& lock,
+	const std::string& name) {
+	auto it = mEntries.find(name);
+	while (it != mEntries.end() && it->second.loading) {
+		it->second.loaded->wait(lock);
+		it = mEntries.find(name);
+	}
+	return it;
+}
+
+std::shared_ptr<CaffeModel> ModelRegistry::get(const std::string& name) {
+	std::unique_lock<std::mutex> lock(mMutex);
+	// a concurrent get() of the same model is loading it, its result is ours too
+	auto it = waitLoaded(lock, name);
+	if (it == mEntries.end()) {
+		return nullptr;
+	}
+	Entry& entry = it->second;
+	if (entry.stats.resident) {
+		touch(entry);
+		return entry.model;
+	}
+	// the footprint of the last residency is the best estimate of the next one
+	if (!makeRoom(entry.stats.deviceMemory, &entry)) {
+		LOG_ERROR(gLogger) << "ModelRegistry: " << name << " does not fit in the device memory budget" << std::endl;
+		return nullptr;
+	}
+	// the room stays reserved while the lock is dropped, the entry is not in mLru so nobody
+	// evicts it, and remove() waits for the load to end
+	size_t reserved = entry.stats.deviceMemory;
+	mUsage += reserved;
+	entry.loading = true;
+	lock.unlock();
+	auto begin = std::chrono::high_resolution_clock::now();
+	bool status = entry.model->build(entry.plan.data(), entry.plan.size());
+	double reloadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count();
+	lock.lock();
+	mUsage -= reserved;
+	entry.loading = false;
+	entry.loaded->notify_all();
+	if (!status) {
+		LOG_ERROR(gLogger) << "ModelRegistry: " << name << " could not be reloaded" << std::endl;
+		return nullptr;
+	}
+	entry.stats.reloads++;
+	entry.stats.lastReloadMs = reloadMs;
+	entry.stats.totalReloadMs += reloadMs;
+	entry.stats.deviceMemory = entry.plan.size() + entry.model->deviceMemorySize();
+	entry.stats.resident = true;
+	mUsage += entry.stats.deviceMemory;
+	mLru.push_front(name);
+	entry.lru = mLru.begin();
+	LOG_INFO(gLogger) << "ModelRegistry: reloaded " << name << " in " << reloadMs << " ms" << std::endl;
+	return entry.model;
+}
+
+bool ModelRegistry::remove(const std::string& name) {
+	std::unique_lock<std::mutex> lock(mMutex);
+	auto it = waitLoaded(lock, name);
+	if (it == mEntries.end()) {
+		return false;
+	}
+	// holders of the model keep it alive, the registry only stops accounting for it
+	if (it->second.stats.resident) {
+		mUsage -= it->second.stats.deviceMemory;
+		mLru.erase(it->second.lru);
+	}
+	mEntries.erase(it);
+	return true;
+}
+
+size_t ModelRegistry::deviceMemoryUsage() const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mUsage;
+}
+
+std::vector<ModelRegistryStats> ModelRegistry::stats() const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	std::vector<ModelRegistryStats> results;
+	for (auto& entry : mEntries) {
+		results.push_back(entry.second.stats);
+	}
+	return results;
+}
+
+void ModelRegistry::touch(Entry& entry) {
+	mLru.splice(mLru.begin(), mLru, entry.lru);
+}
+
+void ModelRegistry::evict(Entry& entry) {
+	LOG_INFO(gLogger) << "ModelRegistry: evicting " << entry.stats.name << std::endl;
+	entry.model->release();
+	// the freed buffers would otherwise stay cached and count against nobody's budget
+	dtrCommon::CachingDeviceAllocator::instance().trim();
+	entry.stats.resident = false;
+	mUsage -= entry.stats.deviceMemory;
+	mLru.erase(entry.lru);
+}
+
+//!
+//! \brief Evicts the least recently used models nobody holds until size more bytes fit in
+//!        the budget. keep is never evicted. Returns false if they do not fit.
+//!
+bool ModelRegistry::makeRoom(size_t size, const Entry* keep) {
+	if (mParams.deviceMemoryBudget == 0) {
+		return true;
+	}
+	auto it = mLru.end();
+	while (mUsage + size > mParams.deviceMemoryBudget && it != mLru.begin()) {
+		--it;
+		Entry& entry = mEntries.at(*it);
+		// only the registry holds it, and get() can not hand it out while we hold the lock
+		if (&entry == keep || entry.model.use_count() > 1) {
+			continue;
+		}
+		// step past the victim, its mLru node goes away with the eviction
+		++it;
+		evict(entry);
+	}
+	return mUsage + size <= mParams.deviceMemoryBudget;
+}
@@ -13,6 +13,8 @@
 #include "NvInfer.h"
 #include <PluginManager.h>
 #include "common/common.h"
+#include "common/deviceAllocator.h"
+#include "common/typeConvert.h"
 #include "extplugin/interpPlugin.h"
 namespace {
 size_t type2size(nvinfer1::DataType type) {
@@ -33,10 +35,20 @@ void read(const char*& buffer, T& val) {
 
 void* copyToDevice(const void* data, size_t count) {
 	void* deviceData;
-	CHECK(cudaMalloc(&deviceData, count));
+	CHECK(dtrCommon::CachingDeviceAllocator::instance().allocate(&deviceData, count));
 	CHECK(cudaMemcpy(deviceData, data, count, cudaMemcpyHostToDevice));
 	return deviceData;
 }
+
+// fp16 weights to float and float weights to fp16
+void convertWeights(void* dst, const nvinfer1::Weights& weights) {
+	size_t count = static_cast<size_t>(weights.count);
+	if (weights.type == nvinfer1::DataType::kHALF) {
+		dtrCommon::halfToFloat(static_cast<const uint16_t*>(weights.values), static_cast<float*>(dst), count);
+	} else {
+		dtrCommon::floatToHalf(static_cast<const float*>(weights.values), static_cast<uint16_t*>(dst), count);
+	}
+}
 }
 
 InterpPlugin::InterpPlugin(const nvinfer1::Weights* weights, int nbWeights, int nbOutputChannels)
@@ -148,12 +160,12 @@ void InterpPlugin::terminate()
 	CHECK(cudnnDestroy(mCudnn));
 	if (mDeviceKernel)
 	{
-		cudaFree(mDeviceKernel);
+		dtrCommon::CachingDeviceAllocator::instance().free(mDeviceKernel);
 		mDeviceKernel = nullptr;
 	}
 	if (mDeviceBias)
 	{
-		cudaFree(mDeviceBias);
+		dtrCommon::CachingDeviceAllocator::instance().free(mDeviceBias);
 		mDeviceBias = nullptr;
 	}
 }
@@ -216,13 +228,7 @@ void InterpPlugin::convertAndCopyToDevice(void*& deviceWeights, const nvinfer1::
 	{
 		size_t size = weights.count * (mDataType == nvinfer1::DataType::kFLOAT ? sizeof(float) : sizeof(__half));
 		void* buffer = malloc(size);
-		for (int64_t v = 0; v < weights.count; ++v) {
-			if (mDataType == nvinfer1::DataType::kFLOAT) {
-				static_cast<float*>(buffer)[v] = fp16::__half2float(static_cast<const __half*>(weights.values)[v]);
-			} else {
-				static_cast<__half*>(buffer)[v] = fp16::__float2half(static_cast<const float*>(weights.values)[v]);
-			}
-		}
+		convertWeights(buffer, weights);
 		deviceWeights = copyToDevice(buffer, size);
 		free(buffer);
 	} else {
@@ -232,15 +238,7 @@ void InterpPlugin::convertAndCopyToDevice(void*& deviceWeights, const nvinfer1::
 
 void InterpPlugin::convertAndCopyToBuffer(char*& buffer, const nvinfer1::Weights& weights) {
 	if (weights.type != mDataType) {
-		for (int64_t v = 0; v < weights.count; ++v) {
-			if (mDataType == nvinfer1::DataType::kFLOAT) {
-				reinterpret_cast<float*>(buffer)[v]
-					= fp16::__half2float(static_cast<const __half*>(weights.values)[v]);
-			} else {
-				reinterpret_cast<__half*>(buffer)[v]
-					= fp16::__float2half(static_cast<const float*>(weights.values)[v]);
-			}
-		}
+		convertWeights(buffer, weights);
 	} else {
 		std::memcpy(buffer, weights.values, weights.count * type2size(mDataType));
 	}
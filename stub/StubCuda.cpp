@@ -0,0 +1,461 @@
+#include "StubStream.h"
+#include <StubRuntime.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace {
+const size_t kTotalDeviceMemory = size_t(8) << 30;
+
+struct HostAllocation {
+	size_t size;
+	unsigned int flags;
+	bool owned; //!< allocated by cudaHostAlloc(), not registered with cudaHostRegister()
+};
+
+std::mutex gMemoryMutex;
+std::map<void*, size_t> gDeviceAllocations;
+size_t gDeviceMemoryInUse = 0;
+std::atomic<size_t> gBytesCopiedToHost{0};
+std::map<uintptr_t, HostAllocation> gHostAllocations;
+
+//! the page-locked allocation holding p, nullptr if there is none. The caller holds gMemoryMutex.
+const HostAllocation* findHostAllocation(const void* p) {
+	uintptr_t address = reinterpret_cast<uintptr_t>(p);
+	auto it = gHostAllocations.upper_bound(address);
+	if (it == gHostAllocations.begin()) {
+		return nullptr;
+	}
+	--it;
+	return address < it->first + std::max<size_t>(it->second.size, 1) ? &it->second : nullptr;
+}
+
+// the current device is per host thread, as in cuda
+thread_local int gDevice = 0;
+}
+
+struct CUevent_st {
+	std::mutex mutex;
+	std::condition_variable completed;
+	uint64_t nbRecorded{0};
+	uint64_t nbCompleted{0};
+	std::chrono::steady_clock::time_point time;
+};
+
+namespace {
+// the live streams, with the number of synchronizeStreams() waiting on each
+std::mutex gStreamsMutex;
+std::condition_variable gStreamReleased;
+std::map<CUstream_st*, int> gStreams;
+// the stream whose thread runs the caller, which must not wait for itself
+thread_local CUstream_st* tCurrentStream = nullptr;
+}
+
+CUstream_st::CUstream_st(bool blocking)
+	: mBlocking(blocking)
+	, mThread(&CUstream_st::loop, this)
+{
+	std::lock_guard<std::mutex> lock(gStreamsMutex);
+	gStreams[this] = 0;
+}
+
+CUstream_st::~CUstream_st() {
+	{
+		std::unique_lock<std::mutex> lock(gStreamsMutex);
+		gStreamReleased.wait(lock, [this]() { return gStreams[this] == 0; });
+		gStreams.erase(this);
+	}
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mWorkReady.notify_one();
+	mThread.join();
+}
+
+void CUstream_st::push(std::function<void()> work) {
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mWork.push_back(std::move(work));
+		++mNbPushed;
+	}
+	mWorkReady.notify_one();
+}
+
+void CUstream_st::synchronize() {
+	std::unique_lock<std::mutex> lock(mMutex);
+	uint64_t target = mNbPushed;
+	mDone.wait(lock, [this, target]() { return mNbDone >= target; });
+}
+
+bool CUstream_st::idle() {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mNbDone == mNbPushed;
+}
+
+void CUstream_st::loop() {
+	tCurrentStream = this;
+	std::unique_lock<std::mutex> lock(mMutex);
+	for (;;) {
+		mWorkReady.wait(lock, [this]() { return mStop || !mWork.empty(); });
+		if (mWork.empty()) {
+			return;
+		}
+		std::function<void()> work = std::move(mWork.front());
+		mWork.pop_front();
+		lock.unlock();
+		work();
+		lock.lock();
+		++mNbDone;
+		mDone.notify_all();
+	}
+}
+
+void dtrStub::synchronizeStreams(bool blockingOnly) {
+	std::vector<CUstream_st*> streams;
+	{
+		std::lock_guard<std::mutex> lock(gStreamsMutex);
+		for (auto& entry : gStreams) {
+			if (entry.first != tCurrentStream && (!blockingOnly || entry.first->blocking())) {
+				++entry.second;
+				streams.push_back(entry.first);
+			}
+		}
+	}
+	// without the lock, so that work on the streams may create and destroy streams
+	for (CUstream_st* stream : streams) {
+		stream->synchronize();
+	}
+	{
+		std::lock_guard<std::mutex> lock(gStreamsMutex);
+		for (CUstream_st* stream : streams) {
+			--gStreams[stream];
+		}
+	}
+	gStreamReleased.notify_all();
+}
+
+void dtrStub::launch(cudaStream_t stream, std::function<void()> work) {
+	if (stream) {
+		stream->push(std::move(work));
+	} else {
+		synchronizeStreams(true);
+		work();
+	}
+}
+
+size_t dtrStub::deviceMemoryInUse() {
+	std::lock_guard<std::mutex> lock(gMemoryMutex);
+	return gDeviceMemoryInUse;
+}
+
+size_t dtrStub::bytesCopiedToHost() {
+	return gBytesCopiedToHost;
+}
+
+extern "C" {
+
+cudaError_t cudaMalloc(void** devPtr, size_t size) {
+	*devPtr = malloc(std::max<size_t>(size, 1));
+	if (!*devPtr) {
+		return cudaErrorMemoryAllocation;
+	}
+	std::lock_guard<std::mutex> lock(gMemoryMutex);
+	gDeviceAllocations[*devPtr] = size;
+	gDeviceMemoryInUse += size;
+	return cudaSuccess;
+}
+
+cudaError_t cudaFree(void* devPtr) {
+	if (!devPtr) {
+		return cudaSuccess;
+	}
+	{
+		std::lock_guard<std::mutex> lock(gMemoryMutex);
+		auto it = gDeviceAllocations.find(devPtr);
+		if (it == gDeviceAllocations.end()) {
+			return cudaErrorInvalidValue;
+		}
+		gDeviceMemoryInUse -= it->second;
+		gDeviceAllocations.erase(it);
+	}
+	free(devPtr);
+	return cudaSuccess;
+}
+
+cudaError_t cudaHostAlloc(void** pHost, size_t size, unsigned int flags) {
+	*pHost = malloc(std::max<size_t>(size, 1));
+	if (!*pHost) {
+		return cudaErrorMemoryAllocation;
+	}
+	std::lock_guard<std::mutex> lock(gMemoryMutex);
+	gHostAllocations[reinterpret_cast<uintptr_t>(*pHost)] = HostAllocation{size, flags, true};
+	return cudaSuccess;
+}
+
+cudaError_t cudaMallocHost(void** ptr, size_t size) {
+	return cudaHostAlloc(ptr, size, cudaHostAllocDefault);
+}
+
+cudaError_t cudaFreeHost(void* ptr) {
+	if (!ptr) {
+		return cudaSuccess;
+	}
+	{
+		std::lock_guard<std::mutex> lock(gMemoryMutex);
+		auto it = gHostAllocations.find(reinterpret_cast<uintptr_t>(ptr));
+		if (it == gHostAllocations.end() || !it->second.owned) {
+			return cudaErrorInvalidValue;
+		}
+		gHostAllocations.erase(it);
+	}
+	free(ptr);
+	return cudaSuccess;
+}
+
+cudaError_t cudaHostRegister(void* ptr, size_t size, unsigned int flags) {
+	std::lock_guard<std::mutex> lock(gMemoryMutex);
+	gHostAllocations[reinterpret_cast<uintptr_t>(ptr)] = HostAllocation{size, flags, false};
+	return cudaSuccess;
+}
+
+cudaError_t cudaHostUnregister(void* ptr) {
+	std::lock_guard<std::mutex> lock(gMemoryMutex);
+	auto it = gHostAllocations.find(reinterpret_cast<uintptr_t>(ptr));
+	if (it == gHostAllocations.end() || it->second.owned) {
+		return cudaErrorInvalidValue;
+	}
+	gHostAllocations.erase(it);
+	return cudaSuccess;
+}
+
+cudaError_t cudaHostGetFlags(unsigned int* pFlags, void* pHost) {
+	std::lock_guard<std::mutex> lock(gMemoryMutex);
+	const HostAllocation* allocation = findHostAllocation(pHost);
+	if (!allocation) {
+		return cudaErrorInvalidValue;
+	}
+	*pFlags = allocation->flags;
+	return cudaSuccess;
+}
+
+cudaError_t cudaHostGetDevicePointer(void** pDevice, void* pHost, unsigned int) {
+	std::lock_guard<std::mutex> lock(gMemoryMutex);
+	const HostAllocation* allocation = findHostAllocation(pHost);
+	if (!allocation || !(allocation->flags & cudaHostAllocMapped)) {
+		return cudaErrorInvalidValue;
+	}
+	// device and host share the address space of the stub
+	*pDevice = pHost;
+	return cudaSuccess;
+}
+
+cudaError_t cudaMemGetInfo(size_t* free, size_t* total) {
+	std::lock_guard<std::mutex> lock(gMemoryMutex);
+	*total = kTotalDeviceMemory;
+	*free = kTotalDeviceMemory - std::min(gDeviceMemoryInUse, kTotalDeviceMemory);
+	return cudaSuccess;
+}
+
+cudaError_t cudaMemcpy(void* dst, const void* src, size_t count, cudaMemcpyKind kind) {
+	if (kind == cudaMemcpyDeviceToHost) {
+		gBytesCopiedToHost += count;
+	}
+	dtrStub::launch(nullptr, [=]() { memcpy(dst, src, count); });
+	return cudaSuccess;
+}
+
+cudaError_t cudaMemcpyAsync(void* dst, const void* src, size_t count, cudaMemcpyKind kind, cudaStream_t stream) {
+	if (kind == cudaMemcpyDeviceToHost) {
+		gBytesCopiedToHost += count;
+	}
+	dtrStub::launch(stream, [=]() { memcpy(dst, src, count); });
+	return cudaSuccess;
+}
+
+cudaError_t cudaMemset(void* devPtr, int value, size_t count) {
+	dtrStub::launch(nullptr, [=]() { memset(devPtr, value, count); });
+	return cudaSuccess;
+}
+
+cudaError_t cudaMemsetAsync(void* devPtr, int value, size_t count, cudaStream_t stream) {
+	dtrStub::launch(stream, [=]() { memset(devPtr, value, count); });
+	return cudaSuccess;
+}
+
+cudaError_t cudaStreamCreate(cudaStream_t* pStream) {
+	*pStream = new CUstream_st();
+	return cudaSuccess;
+}
+
+cudaError_t cudaStreamCreateWithFlags(cudaStream_t* pStream, unsigned int flags) {
+	*pStream = new CUstream_st(!(flags & cudaStreamNonBlocking));
+	return cudaSuccess;
+}
+
+cudaError_t cudaStreamDestroy(cudaStream_t stream) {
+	if (!stream) {
+		return cudaErrorInvalidValue;
+	}
+	// like cuda, the work already pushed completes before the stream goes away
+	stream->synchronize();
+	delete stream;
+	return cudaSuccess;
+}
+
+cudaError_t cudaStreamSynchronize(cudaStream_t stream) {
+	if (stream) {
+		stream->synchronize();
+	} else {
+		dtrStub::synchronizeStreams(true);
+	}
+	return cudaSuccess;
+}
+
+cudaError_t cudaStreamQuery(cudaStream_t stream) {
+	return !stream || stream->idle() ? cudaSuccess : cudaErrorNotReady;
+}
+
+cudaError_t cudaStreamWaitEvent(cudaStream_t stream, cudaEvent_t event, unsigned int) {
+	uint64_t target;
+	{
+		std::lock_guard<std::mutex> lock(event->mutex);
+		target = event->nbRecorded;
+	}
+	dtrStub::launch(stream, [event, target]() {
+		std::unique_lock<std::mutex> lock(event->mutex);
+		event->completed.wait(lock, [event, target]() { return event->nbCompleted >= target; });
+	});
+	return cudaSuccess;
+}
+
+cudaError_t cudaStreamAddCallback(cudaStream_t stream, cudaStreamCallback_t callback, void* userData, unsigned int) {
+	dtrStub::launch(stream, [stream, callback, userData]() { callback(stream, cudaSuccess, userData); });
+	return cudaSuccess;
+}
+
+cudaError_t cudaEventCreate(cudaEvent_t* event) {
+	*event = new CUevent_st();
+	return cudaSuccess;
+}
+
+cudaError_t cudaEventCreateWithFlags(cudaEvent_t* event, unsigned int) {
+	return cudaEventCreate(event);
+}
+
+cudaError_t cudaEventDestroy(cudaEvent_t event) {
+	if (!event) {
+		return cudaErrorInvalidValue;
+	}
+	cudaEventSynchronize(event);
+	delete event;
+	return cudaSuccess;
+}
+
+cudaError_t cudaEventRecord(cudaEvent_t event, cudaStream_t stream) {
+	uint64_t generation;
+	{
+		std::lock_guard<std::mutex> lock(event->mutex);
+		generation = ++event->nbRecorded;
+	}
+	dtrStub::launch(stream, [event, generation]() {
+		{
+			std::lock_guard<std::mutex> lock(event->mutex);
+			event->nbCompleted = std::max(event->nbCompleted, generation);
+			event->time = std::chrono::steady_clock::now();
+		}
+		event->completed.notify_all();
+	});
+	return cudaSuccess;
+}
+
+cudaError_t cudaEventSynchronize(cudaEvent_t event) {
+	std::unique_lock<std::mutex> lock(event->mutex);
+	uint64_t target = event->nbRecorded;
+	event->completed.wait(lock, [event, target]() { return event->nbCompleted >= target; });
+	return cudaSuccess;
+}
+
+cudaError_t cudaEventQuery(cudaEvent_t event) {
+	std::lock_guard<std::mutex> lock(event->mutex);
+	return event->nbCompleted >= event->nbRecorded ? cudaSuccess : cudaErrorNotReady;
+}
+
+cudaError_t cudaEventElapsedTime(float* ms, cudaEvent_t start, cudaEvent_t end) {
+	std::chrono::steady_clock::time_point begin;
+	{
+		std::lock_guard<std::mutex> lock(start->mutex);
+		begin = start->time;
+	}
+	std::lock_guard<std::mutex> lock(end->mutex);
+	*ms = std::chrono::duration<float, std::milli>(end->time - begin).count();
+	return cudaSuccess;
+}
+
+cudaError_t cudaDeviceSynchronize() {
+	dtrStub::synchronizeStreams(false);
+	return cudaSuccess;
+}
+
+cudaError_t cudaSetDevice(int device) {
+	if (device != 0) {
+		return cudaErrorInvalidDevice;
+	}
+	gDevice = device;
+	return cudaSuccess;
+}
+
+cudaError_t cudaGetDevice(int* device) {
+	*device = gDevice;
+	return cudaSuccess;
+}
+
+cudaError_t cudaSetDeviceFlags(unsigned int) {
+	return cudaSuccess;
+}
+
+cudaError_t cudaGetDeviceProperties(cudaDeviceProp* prop, int device) {
+	if (device != 0) {
+		return cudaErrorInvalidDevice;
+	}
+	memset(prop, 0, sizeof(*prop));
+	strncpy(prop->name, "nvinfer stub", sizeof(prop->name) - 1);
+	prop->totalGlobalMem = kTotalDeviceMemory;
+	prop->major = 7;
+	prop->minor = 0;
+	prop->multiProcessorCount = 1;
+	prop->canMapHostMemory = 1;
+	return cudaSuccess;
+}
+
+cudaError_t cudaRuntimeGetVersion(int* runtimeVersion) {
+	*runtimeVersion = 9000;
+	return cudaSuccess;
+}
+
+cudaError_t cudaDriverGetVersion(int* driverVersion) {
+	*driverVersion = 9000;
+	return cudaSuccess;
+}
+
+cudaError_t cudaGetLastError() {
+	return cudaSuccess;
+}
+
+const char* cudaGetErrorString(cudaError_t error) {
+	switch (error) {
+	case cudaSuccess: return "no error";
+	case cudaErrorInvalidValue: return "invalid argument";
+	case cudaErrorMemoryAllocation: return "out of memory";
+	case cudaErrorInvalidDevice: return "invalid device ordinal";
+	case cudaErrorNotReady: return "device not ready";
+	default: return "unknown error";
+	}
+}
+
+}
@@ -0,0 +1,66 @@
+#include <cublas_v2.h>
+#include <cudnn.h>
+
+// cublas and cudnn are only reached through the plugins, which the stub engines never run:
+// handles and descriptors are dummies and the math does nothing.
+namespace {
+int gHandle;
+}
+
+extern "C" {
+
+cublasStatus_t cublasCreate(cublasHandle_t* handle) {
+	*handle = reinterpret_cast<cublasHandle_t>(&gHandle);
+	return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t cublasDestroy(cublasHandle_t) {
+	return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t cublasSetStream(cublasHandle_t, cudaStream_t) {
+	return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t cublasSgemm(cublasHandle_t, cublasOperation_t, cublasOperation_t, int, int, int, const float*,
+	const float*, int, const float*, int, const float*, float*, int) {
+	return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t cublasHgemm(cublasHandle_t, cublasOperation_t, cublasOperation_t, int, int, int, const __half*,
+	const __half*, int, const __half*, int, const __half*, __half*, int) {
+	return CUBLAS_STATUS_SUCCESS;
+}
+
+cudnnStatus_t cudnnCreate(cudnnHandle_t* handle) {
+	*handle = reinterpret_cast<cudnnHandle_t>(&gHandle);
+	return CUDNN_STATUS_SUCCESS;
+}
+
+cudnnStatus_t cudnnDestroy(cudnnHandle_t) {
+	return CUDNN_STATUS_SUCCESS;
+}
+
+cudnnStatus_t cudnnSetStream(cudnnHandle_t, cudaStream_t) {
+	return CUDNN_STATUS_SUCCESS;
+}
+
+cudnnStatus_t cudnnCreateTensorDescriptor(cudnnTensorDescriptor_t* descriptor) {
+	*descriptor = reinterpret_cast<cudnnTensorDescriptor_t>(&gHandle);
+	return CUDNN_STATUS_SUCCESS;
+}
+
+cudnnStatus_t cudnnDestroyTensorDescriptor(cudnnTensorDescriptor_t) {
+	return CUDNN_STATUS_SUCCESS;
+}
+
+cudnnStatus_t cudnnSetTensor4dDescriptor(cudnnTensorDescriptor_t, cudnnTensorFormat_t, cudnnDataType_t, int, int, int, int) {
+	return CUDNN_STATUS_SUCCESS;
+}
+
+cudnnStatus_t cudnnAddTensor(cudnnHandle_t, const void*, const cudnnTensorDescriptor_t, const void*, const void*,
+	const cudnnTensorDescriptor_t, void*) {
+	return CUDNN_STATUS_SUCCESS;
+}
+
+}
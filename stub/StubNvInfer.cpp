@@ -0,0 +1,294 @@
+#include "StubStream.h"
+#include <StubRuntime.h>
+#include <NvCaffeParser.h>
+#include <NvInferPlugin.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace {
+const char kPlanMagic[] = "dtrstub-plan 1";
+
+long long latencyFromEnv(const char* name) {
+	const char* value = getenv(name);
+	return value ? atoll(value) : 0;
+}
+std::atomic<long long> gKernelLatencyUs{latencyFromEnv("DTR_STUB_KERNEL_LATENCY_US")};
+std::atomic<long long> gSampleLatencyUs{latencyFromEnv("DTR_STUB_SAMPLE_LATENCY_US")};
+
+struct EngineDescription {
+	std::vector<dtrStub::Binding> bindings;
+	int maxBatchSize{1};
+};
+
+size_t volumeOf(const dtrStub::Binding& binding) {
+	size_t volume = 1;
+	for (int d : binding.dims) {
+		volume *= d;
+	}
+	return volume;
+}
+
+size_t elementSizeOf(nvinfer1::DataType type) {
+	switch (type) {
+	case nvinfer1::DataType::kFLOAT: return 4;
+	case nvinfer1::DataType::kHALF: return 2;
+	case nvinfer1::DataType::kINT8: return 1;
+	case nvinfer1::DataType::kINT32: return 4;
+	}
+	return 0;
+}
+
+bool parsePlan(const void* blob, size_t size, EngineDescription& description) {
+	std::string text(static_cast<const char*>(blob), size);
+	std::istringstream in(text);
+	std::string line;
+	if (!std::getline(in, line) || line != kPlanMagic) {
+		return false;
+	}
+	std::string field;
+	if (!(in >> field >> description.maxBatchSize) || field != "maxBatchSize") {
+		return false;
+	}
+	while (in >> field) {
+		dtrStub::Binding binding;
+		std::string direction;
+		int type = 0, nbDims = 0;
+		if (field != "binding" || !(in >> binding.name >> direction >> type >> nbDims) || nbDims > nvinfer1::Dims::MAX_DIMS) {
+			return false;
+		}
+		binding.isInput = direction == "input";
+		binding.type = static_cast<nvinfer1::DataType>(type);
+		binding.dims.resize(nbDims);
+		for (int& d : binding.dims) {
+			in >> d;
+		}
+		description.bindings.push_back(binding);
+	}
+	return !in.bad();
+}
+
+class StubHostMemory : public nvinfer1::IHostMemory {
+public:
+	explicit StubHostMemory(std::string data)
+		: mData(std::move(data))
+	{ }
+	void* data() const override { return const_cast<char*>(mData.data()); }
+	std::size_t size() const override { return mData.size(); }
+	nvinfer1::DataType type() const override { return nvinfer1::DataType::kINT8; }
+	void destroy() override { delete this; }
+private:
+	std::string mData;
+};
+
+class StubEngine : public nvinfer1::ICudaEngine {
+public:
+	explicit StubEngine(EngineDescription description)
+		: mDescription(std::move(description))
+	{ }
+	int getNbBindings() const override { return static_cast<int>(mDescription.bindings.size()); }
+	int getBindingIndex(const char* name) const override {
+		for (int i = 0; i < getNbBindings(); ++i) {
+			if (mDescription.bindings[i].name == name) {
+				return i;
+			}
+		}
+		return -1;
+	}
+	const char* getBindingName(int bindingIndex) const override { return binding(bindingIndex) ? binding(bindingIndex)->name.c_str() : nullptr; }
+	bool bindingIsInput(int bindingIndex) const override { return binding(bindingIndex) && binding(bindingIndex)->isInput; }
+	nvinfer1::Dims getBindingDimensions(int bindingIndex) const override {
+		nvinfer1::Dims dims;
+		memset(&dims, 0, sizeof(dims));
+		if (binding(bindingIndex)) {
+			dims.nbDims = static_cast<int>(binding(bindingIndex)->dims.size());
+			std::copy(binding(bindingIndex)->dims.begin(), binding(bindingIndex)->dims.end(), dims.d);
+		}
+		return dims;
+	}
+	nvinfer1::DataType getBindingDataType(int bindingIndex) const override {
+		return binding(bindingIndex) ? binding(bindingIndex)->type : nvinfer1::DataType::kFLOAT;
+	}
+	int getMaxBatchSize() const override { return mDescription.maxBatchSize; }
+	int getNbLayers() const override { return 1; }
+	std::size_t getWorkspaceSize() const override { return 0; }
+	nvinfer1::IHostMemory* serialize() const override {
+		return new StubHostMemory(dtrStub::makePlan(mDescription.bindings, mDescription.maxBatchSize));
+	}
+	nvinfer1::IExecutionContext* createExecutionContext() override;
+	void destroy() override { delete this; }
+	nvinfer1::TensorLocation getLocation(int) const override { return nvinfer1::TensorLocation::kDEVICE; }
+	nvinfer1::IExecutionContext* createExecutionContextWithoutDeviceMemory() override { return createExecutionContext(); }
+	size_t getDeviceMemorySize() const override { return 0; }
+	bool isRefittable() const override { return false; }
+
+	//!
+	//! \brief The simulated kernel: every float output sample gets the mean of a few hundred
+	//!        values of the matching input samples plus a ramp, so outputs follow inputs
+	//!        sample by sample while the host cost stays small next to the simulated latency.
+	//!
+	void compute(int batchSize, const std::vector<void*>& bindings) const {
+		for (int n = 0; n < batchSize; ++n) {
+			float seed = 0;
+			for (size_t i = 0; i < bindings.size(); ++i) {
+				const dtrStub::Binding& input = mDescription.bindings[i];
+				if (!input.isInput || input.type != nvinfer1::DataType::kFLOAT) {
+					continue;
+				}
+				size_t volume = volumeOf(input);
+				size_t stride = std::max<size_t>(volume / 256, 1);
+				const float* sample = static_cast<const float*>(bindings[i]) + n * volume;
+				double sum = 0;
+				for (size_t k = 0; k < volume; k += stride) {
+					sum += sample[k];
+				}
+				seed += static_cast<float>(sum / ((volume + stride - 1) / stride));
+			}
+			for (size_t i = 0; i < bindings.size(); ++i) {
+				const dtrStub::Binding& output = mDescription.bindings[i];
+				if (output.isInput) {
+					continue;
+				}
+				size_t volume = volumeOf(output);
+				if (output.type != nvinfer1::DataType::kFLOAT) {
+					memset(static_cast<char*>(bindings[i]) + n * volume * elementSizeOf(output.type), 0, volume * elementSizeOf(output.type));
+					continue;
+				}
+				float* sample = static_cast<float*>(bindings[i]) + n * volume;
+				for (size_t k = 0; k < volume; ++k) {
+					sample[k] = seed + k * 1e-3f;
+				}
+			}
+		}
+	}
+private:
+	const dtrStub::Binding* binding(int index) const {
+		return index >= 0 && index < getNbBindings() ? &mDescription.bindings[index] : nullptr;
+	}
+	EngineDescription mDescription;
+};
+
+void simulateLatency(int batchSize) {
+	std::chrono::microseconds latency(gKernelLatencyUs + gSampleLatencyUs * batchSize);
+	if (latency.count() > 0) {
+		std::this_thread::sleep_for(latency);
+	}
+}
+
+class StubContext : public nvinfer1::IExecutionContext {
+public:
+	explicit StubContext(StubEngine& engine)
+		: mEngine(engine)
+	{ }
+	bool execute(int batchSize, void** bindings) override {
+		if (batchSize <= 0 || batchSize > mEngine.getMaxBatchSize()) {
+			return false;
+		}
+		mEngine.compute(batchSize, std::vector<void*>(bindings, bindings + mEngine.getNbBindings()));
+		simulateLatency(batchSize);
+		return true;
+	}
+	bool enqueue(int batchSize, void** bindings, cudaStream_t stream, cudaEvent_t* inputConsumed) override {
+		if (batchSize <= 0 || batchSize > mEngine.getMaxBatchSize()) {
+			return false;
+		}
+		// the binding array belongs to the caller once enqueue() returns
+		std::vector<void*> pointers(bindings, bindings + mEngine.getNbBindings());
+		StubEngine* engine = &mEngine;
+		dtrStub::launch(stream, [engine, batchSize, pointers]() { engine->compute(batchSize, pointers); });
+		if (inputConsumed) {
+			cudaEventRecord(*inputConsumed, stream);
+		}
+		dtrStub::launch(stream, [batchSize]() { simulateLatency(batchSize); });
+		return true;
+	}
+	void setDebugSync(bool sync) override { mDebugSync = sync; }
+	bool getDebugSync() const override { return mDebugSync; }
+	void setProfiler(nvinfer1::IProfiler* profiler) override { mProfiler = profiler; }
+	nvinfer1::IProfiler* getProfiler() const override { return mProfiler; }
+	const nvinfer1::ICudaEngine& getEngine() const override { return mEngine; }
+	void destroy() override { delete this; }
+	void setName(const char* name) override { mName = name; }
+	const char* getName() const override { return mName.c_str(); }
+	void setDeviceMemory(void*) override { }
+private:
+	StubEngine& mEngine;
+	bool mDebugSync{false};
+	nvinfer1::IProfiler* mProfiler{nullptr};
+	std::string mName;
+};
+
+nvinfer1::IExecutionContext* StubEngine::createExecutionContext() {
+	return new StubContext(*this);
+}
+
+class StubRuntime : public nvinfer1::IRuntime {
+public:
+	explicit StubRuntime(nvinfer1::ILogger* logger)
+		: mLogger(logger)
+	{ }
+	nvinfer1::ICudaEngine* deserializeCudaEngine(const void* blob, std::size_t size, nvinfer1::IPluginFactory*) override {
+		EngineDescription description;
+		// like TensorRT with a plan of another version, anything but a stub plan is refused
+		if (!parsePlan(blob, size, description)) {
+			if (mLogger) {
+				mLogger->log(nvinfer1::ILogger::Severity::kERROR, "the nvinfer stub can only deserialize plans of dtrStub::makePlan()");
+			}
+			return nullptr;
+		}
+		return new StubEngine(description);
+	}
+	void setDLACore(int dlaCore) override { mDLACore = dlaCore; }
+	int getDLACore() const override { return mDLACore; }
+	int getNbDLACores() const override { return 0; }
+	void destroy() override { delete this; }
+	void setGpuAllocator(nvinfer1::IGpuAllocator*) override { }
+private:
+	nvinfer1::ILogger* mLogger;
+	int mDLACore{-1};
+};
+}
+
+void dtrStub::setKernelLatency(std::chrono::microseconds fixed, std::chrono::microseconds perSample) {
+	gKernelLatencyUs = fixed.count();
+	gSampleLatencyUs = perSample.count();
+}
+
+std::string dtrStub::makePlan(const std::vector<Binding>& bindings, int maxBatchSize) {
+	std::ostringstream out;
+	out << kPlanMagic << "\nmaxBatchSize " << maxBatchSize << "\n";
+	for (auto& binding : bindings) {
+		out << "binding " << binding.name << (binding.isInput ? " input " : " output ") << static_cast<int>(binding.type)
+			<< " " << binding.dims.size();
+		for (int d : binding.dims) {
+			out << " " << d;
+		}
+		out << "\n";
+	}
+	return out.str();
+}
+
+extern "C" void* createInferRuntime_INTERNAL(void* logger, int) {
+	return static_cast<nvinfer1::IRuntime*>(new StubRuntime(static_cast<nvinfer1::ILogger*>(logger)));
+}
+
+extern "C" void* createInferBuilder_INTERNAL(void* logger, int) {
+	static_cast<nvinfer1::ILogger*>(logger)->log(nvinfer1::ILogger::Severity::kERROR,
+		"the nvinfer stub can not build engines, deserialize a plan instead");
+	return nullptr;
+}
+
+extern "C" int getInferLibVersion() {
+	return NV_TENSORRT_VERSION;
+}
+
+extern "C" bool initLibNvInferPlugins(void*, const char*) {
+	return true;
+}
+
+nvcaffeparser1::ICaffeParser* nvcaffeparser1::createCaffeParser() {
+	return nullptr;
+}
+
+void nvcaffeparser1::shutdownProtobufLibrary() { }
@@ -0,0 +1,50 @@
+#ifndef DEPLOY_STUB_STUBSTREAM_H_
+#define DEPLOY_STUB_STUBSTREAM_H_
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <cuda_runtime_api.h>
+
+//!
+//! \brief A cuda stream: the work pushed on it runs in order on a thread of its own.
+//!
+struct CUstream_st {
+	//! \brief blocking streams are ordered with the default stream, as cudaStreamCreate() makes them.
+	explicit CUstream_st(bool blocking = true);
+	~CUstream_st();
+	void push(std::function<void()> work);
+	//! \brief Waits until all the work pushed before the call has run.
+	void synchronize();
+	bool idle();
+	bool blocking() const { return mBlocking; }
+private:
+	void loop();
+	const bool mBlocking;
+	std::mutex mMutex;
+	std::condition_variable mWorkReady;
+	std::condition_variable mDone;
+	std::deque<std::function<void()>> mWork;
+	uint64_t mNbPushed{0};
+	uint64_t mNbDone{0};
+	bool mStop{false};
+	std::thread mThread;
+};
+
+namespace dtrStub {
+//!
+//! \brief Runs work on stream. For the default stream it runs right away on the calling thread
+//!        once the work pushed so far on the blocking streams has run, like the legacy default
+//!        stream of cuda.
+//!
+void launch(cudaStream_t stream, std::function<void()> work);
+
+//!
+//! \brief Waits for the work pushed so far on every stream, only on the blocking ones if
+//!        blockingOnly, except the stream whose thread calls it.
+//!
+void synchronizeStreams(bool blockingOnly);
+}
+#endif
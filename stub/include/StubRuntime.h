@@ -0,0 +1,54 @@
+#ifndef DEPLOY_STUB_INCLUDE_STUBRUNTIME_H_
+#define DEPLOY_STUB_INCLUDE_STUBRUNTIME_H_
+#include <chrono>
+#include <string>
+#include <vector>
+#include <NvInfer.h>
+
+//!
+//! \brief Controls of the stub TensorRT and CUDA runtime built with BUILD_WITH_NVINFER_STUB.
+//!
+//! \details The stub keeps "device" memory in host memory and runs every cuda stream on a
+//!          thread of its own, so copies, events and callbacks keep their stream order.
+//!          An inference sleeps for the simulated kernel latency and fills each float output
+//!          sample with values derived from the matching input sample. Building engines and
+//!          parsing caffe models are not supported, engines come from makePlan() plans only.
+//!          The default stream waits for the blocking streams, as the legacy cuda one does.
+//!
+namespace dtrStub {
+
+struct Binding {
+	Binding() = default;
+	Binding(const std::string& name, bool isInput, const std::vector<int>& dims, nvinfer1::DataType type = nvinfer1::DataType::kFLOAT)
+		: name(name), isInput(isInput), type(type), dims(dims)
+	{ }
+	std::string name;
+	bool isInput{false};
+	nvinfer1::DataType type{nvinfer1::DataType::kFLOAT};
+	std::vector<int> dims; //!< without the batch dimension
+};
+
+//!
+//! \brief Sets the latency of every enqueue() and execute(): fixed plus perSample for each
+//!        sample of the batch. Initialized from DTR_STUB_KERNEL_LATENCY_US and
+//!        DTR_STUB_SAMPLE_LATENCY_US, 0 if they are not set.
+//!
+void setKernelLatency(std::chrono::microseconds fixed, std::chrono::microseconds perSample = std::chrono::microseconds(0));
+
+//!
+//! \brief Returns a serialized stub engine with these bindings, the only plans the stub
+//!        deserializes.
+//!
+std::string makePlan(const std::vector<Binding>& bindings, int maxBatchSize);
+
+//!
+//! \brief Returns the bytes currently allocated with cudaMalloc().
+//!
+size_t deviceMemoryInUse();
+
+//!
+//! \brief Returns the bytes cudaMemcpy() and cudaMemcpyAsync() have copied from device to host.
+//!
+size_t bytesCopiedToHost();
+}
+#endif
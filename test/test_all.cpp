@@ -2,12 +2,24 @@
 #include <common/logger.h>
 #include <cuda_runtime_api.h>
 #include <NvInferPlugin.h>
+#ifdef DTR_NVINFER_STUB
+#include <StubRuntime.h>
+#include <fstream>
+#endif
 int main(int argc, char *argv[]){
 #ifdef CONFIG_USE_LOG
     setReportableSeverity(Logger::Severity::kINFO);
 #endif
     cudaSetDevice(0);
     initLibNvInferPlugins(&gLogger.getTRTLogger(), "");
+#ifdef DTR_NVINFER_STUB
+    // the stub only deserializes its own plans, the tests load a GoogLeNet shaped one
+    const char* plan = "data/googlenet/googlenet_gie.bin";
+    if (!std::ifstream(plan)) {
+        std::ofstream(plan, std::ios::binary) << dtrStub::makePlan({dtrStub::Binding("data", true, {3, 224, 224}),
+            dtrStub::Binding("prob", false, {1000, 1, 1})}, 256);
+    }
+#endif
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
 }
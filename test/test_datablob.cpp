@@ -0,0 +1,174 @@
+#include <DataBlob.h>
+#include <gtest/gtest.h>
+#include <cuda_runtime_api.h>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+TEST(DataBlob, StorageSources) {
+	for (BlobMemory memory : {BlobMemory::kHEAP, BlobMemory::kALIGNED, BlobMemory::kPINNED, BlobMemory::kHUGE_PAGES}) {
+		DataBlob32f blob(2, 3, 5, 7, memory);
+		EXPECT_EQ(blob.memory(), memory);
+		ASSERT_NE(blob.ptr(), nullptr);
+		EXPECT_EQ(blob.total_n_elem(), 2U * 3 * 5 * 7);
+		for (size_t i = 0; i < blob.total_n_elem(); ++i) {
+			EXPECT_EQ(blob.ptr()[i], 0.0f);
+		}
+		if (memory == BlobMemory::kALIGNED) {
+			EXPECT_EQ(reinterpret_cast<uintptr_t>(blob.ptr()) % 64, 0U);
+		}
+		if (memory == BlobMemory::kHUGE_PAGES) {
+			EXPECT_EQ(reinterpret_cast<uintptr_t>(blob.ptr()) % (2 << 20), 0U);
+		}
+		if (memory == BlobMemory::kPINNED) {
+			unsigned int flags = 0;
+			EXPECT_EQ(cudaHostGetFlags(&flags, blob.ptr()), cudaSuccess);
+		}
+	}
+}
+
+TEST(DataBlob, SharesStorageAcrossCopies) {
+	DataBlob32f blob(DataBlobShape(1, 3, 4, 4), BlobMemory::kPINNED);
+	DataBlob32f copy = blob;
+	copy.ptr()[5] = 1.5f;
+	EXPECT_EQ(blob.ptr()[5], 1.5f);
+	EXPECT_EQ(copy.memory(), BlobMemory::kPINNED);
+
+	DataBlob32f deep = blob.clone(BlobMemory::kALIGNED);
+	EXPECT_NE(deep.ptr(), blob.ptr());
+	EXPECT_EQ(deep.memory(), BlobMemory::kALIGNED);
+	EXPECT_EQ(0, memcmp(deep.ptr(), blob.ptr(), blob.total_n_elem() * sizeof(float)));
+}
+
+TEST(DataBlob, UserAllocator) {
+	// a bump arena: the blobs hand their storage back by dropping the last reference
+	alignas(64) static char arena[1 << 16];
+	size_t used = 0;
+	int live = 0;
+	BlobAllocator allocator = [&](size_t bytes) -> std::shared_ptr<void> {
+		size_t offset = (used + 63) / 64 * 64;
+		if (offset + bytes > sizeof(arena)) {
+			return nullptr;
+		}
+		used = offset + bytes;
+		++live;
+		return std::shared_ptr<void>(arena + offset, [&live](void *) { --live; });
+	};
+	{
+		DataBlob32f a(1, 3, 8, 8, allocator);
+		DataBlob32f b(DataBlobShape(2, 1, 8, 8), allocator);
+		EXPECT_EQ(a.memory(), BlobMemory::kEXTERNAL);
+		EXPECT_EQ(static_cast<void *>(a.ptr()), static_cast<void *>(arena));
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(b.ptr()) % 64, 0U);
+		EXPECT_EQ(live, 2);
+		DataBlob32f shared = a;
+		a = b;
+		EXPECT_EQ(live, 2);
+	}
+	EXPECT_EQ(live, 0);
+	EXPECT_THROW(DataBlob32f(1, 1, 1, 1 << 20, allocator), std::bad_alloc);
+}
+
+TEST(DataBlob, InitModes) {
+	// one small and one large enough for fresh pages
+	for (size_t w : {7, 1 << 16}) {
+		for (BlobMemory memory : {BlobMemory::kHEAP, BlobMemory::kALIGNED, BlobMemory::kPINNED, BlobMemory::kHUGE_PAGES}) {
+			DataBlob32f lazy(1, 3, 2, w, memory, BlobInit::kLAZY_ZEROED);
+			EXPECT_EQ(lazy.memory(), memory);
+			for (size_t i = 0; i < lazy.total_n_elem(); ++i) {
+				ASSERT_EQ(lazy.ptr()[i], 0.0f);
+			}
+			if (memory == BlobMemory::kALIGNED || memory == BlobMemory::kHUGE_PAGES) {
+				EXPECT_EQ(reinterpret_cast<uintptr_t>(lazy.ptr()) % 64, 0U);
+			}
+			DataBlob32f raw(DataBlobShape(1, 3, 2, w), memory, BlobInit::kUNINITIALIZED);
+			ASSERT_NE(raw.ptr(), nullptr);
+			raw.ptr()[raw.total_n_elem() - 1] = 1.0f;
+		}
+	}
+}
+
+TEST(DataBlob, CloneKeepsShapeAndData) {
+	DataBlob32f blob(DataBlobShape(2, 3, 4, 5), BlobMemory::kALIGNED, BlobInit::kUNINITIALIZED);
+	for (size_t i = 0; i < blob.total_n_elem(); ++i) {
+		blob.ptr()[i] = static_cast<float>(i);
+	}
+	DataBlob32f deep = blob.clone();
+	EXPECT_EQ(deep.shape(), blob.shape());
+	EXPECT_EQ(deep.memory(), BlobMemory::kHEAP);
+	EXPECT_EQ(0, memcmp(deep.ptr(), blob.ptr(), blob.total_n_elem() * sizeof(float)));
+}
+
+namespace {
+DataBlob32f iota(DataBlobShape shape) {
+	DataBlob32f blob(shape, BlobMemory::kHEAP, BlobInit::kUNINITIALIZED);
+	for (size_t i = 0; i < blob.total_n_elem(); ++i) {
+		blob.ptr()[i] = static_cast<float>(i);
+	}
+	return blob;
+}
+}
+
+TEST(DataBlob, Accessors) {
+	DataBlob32f blob = iota(DataBlobShape(2, 3, 4, 5));
+	EXPECT_EQ(blob.at(1, 2, 3, 4), blob.total_n_elem() - 1.0f);
+	EXPECT_EQ(blob.at(1, 0, 2, 1), 60.0f + 2 * 5 + 1);
+	EXPECT_EQ(blob.row(1, 0, 2)[1], 71.0f);
+	EXPECT_EQ(blob.plane(0, 1)[0], 20.0f);
+	EXPECT_DEATH(blob.at(2, 0, 0, 0), "");
+	EXPECT_DEATH(blob.at(0, 0, 0, 5), "");
+}
+
+TEST(DataBlob, BatchSlices) {
+	DataBlob32f blob = iota(DataBlobShape(4, 3, 4, 5));
+	DataBlob32f middle = blob.slice_batch(1, 3);
+	EXPECT_EQ(middle.shape(), DataBlobShape(2, 3, 4, 5));
+	EXPECT_TRUE(middle.is_continuous());
+	EXPECT_EQ(middle.ptr(), blob.ptr(1));
+	// copies keep the offset of the view
+	DataBlob32f copy = middle;
+	copy.at(0, 0, 0, 0) = -1.0f;
+	EXPECT_EQ(blob.at(1, 0, 0, 0), -1.0f);
+	EXPECT_EQ(blob.slice_batch(4, 4).nums(), 0U);
+	EXPECT_THROW(blob.slice_batch(3, 5), std::out_of_range);
+}
+
+TEST(DataBlob, ChannelSlicesAndRois) {
+	DataBlob32f blob = iota(DataBlobShape(2, 3, 4, 5));
+	DataBlob32f green = blob.slice_channels(1, 2);
+	EXPECT_EQ(green.shape(), DataBlobShape(2, 1, 4, 5));
+	EXPECT_FALSE(green.is_continuous());
+	EXPECT_TRUE(green.slice_batch(1, 2).is_continuous());
+	EXPECT_EQ(green.at(1, 0, 2, 3), blob.at(1, 1, 2, 3));
+
+	DataBlob32f crop = blob.roi(1, 2, 2, 3);
+	EXPECT_EQ(crop.shape(), DataBlobShape(2, 3, 2, 3));
+	EXPECT_EQ(crop.step(), 5U);
+	EXPECT_EQ(crop.at(1, 2, 1, 2), blob.at(1, 2, 2, 4));
+	EXPECT_THROW(blob.roi(3, 0, 2, 1), std::out_of_range);
+
+	// a view of a view
+	DataBlob32f pixel = crop.slice_channels(2, 3).roi(1, 1, 1, 1).slice_batch(1, 2);
+	EXPECT_EQ(pixel.total_n_elem(), 1U);
+	EXPECT_TRUE(pixel.is_continuous());
+	EXPECT_EQ(pixel.ptr()[0], blob.at(1, 2, 2, 3));
+
+	DataBlob32f deep = crop.clone();
+	EXPECT_TRUE(deep.is_continuous());
+	EXPECT_TRUE(deep.equals(crop));
+	EXPECT_FALSE(deep.equals(blob.roi(0, 0, 2, 3)));
+	std::vector<float> packed(crop.total_n_elem());
+	crop.write(packed.data());
+	EXPECT_EQ(0, memcmp(packed.data(), deep.ptr(), packed.size() * sizeof(float)));
+
+	// scatter into the top left corner, which overlaps the crop
+	DataBlob32f corner = blob.roi(0, 0, 2, 3);
+	corner.read(packed.data());
+	EXPECT_TRUE(corner.equals(deep));
+	EXPECT_EQ(blob.at(0, 0, 0, 0), deep.at(0, 0, 0, 0));
+	EXPECT_EQ(blob.at(0, 0, 0, 3), 3.0f);
+	// a destination of another shape is never written
+	DataBlob32f small = blob.roi(0, 0, 1, 3);
+	EXPECT_DEATH(deep.copy_to(small), "");
+}
@@ -0,0 +1,83 @@
+#include <DataBlobPool.h>
+#include <gtest/gtest.h>
+#include <iostream>
+
+TEST(DataBlobPool, RecyclesStorageOfTheLastCopy) {
+	DataBlobPool pool;
+	DataBlobShape shape(4, 3, 224, 224);
+	float* first;
+	{
+		DataBlob32f blob = pool.acquire<float>(shape);
+		first = blob.ptr();
+		EXPECT_EQ(blob.shape(), shape);
+		EXPECT_EQ(blob.memory(), BlobMemory::kEXTERNAL);
+		blob.ptr()[7] = 1.0f;
+		DataBlob32f copy = blob;
+		blob = DataBlob32f();
+		// the copy still holds the storage
+		EXPECT_EQ(pool.stats().recycled, 0U);
+		EXPECT_EQ(copy.ptr()[7], 1.0f);
+	}
+	EXPECT_EQ(pool.stats().recycled, 1U);
+	EXPECT_EQ(pool.stats().bytesCached, shape.nums() * 3 * 224 * 224 * sizeof(float));
+
+	DataBlob32f again = pool.acquire<float>(shape);
+	EXPECT_EQ(again.ptr(), first);
+	EXPECT_EQ(again.ptr()[7], 0.0f);
+	DataBlobPoolStats stats = pool.stats();
+	EXPECT_EQ(stats.hits, 1U);
+	EXPECT_EQ(stats.misses, 1U);
+	EXPECT_EQ(stats.blocksCached, 0U);
+	std::cout << stats << std::endl;
+}
+
+TEST(DataBlobPool, KeyedByShapeAndType) {
+	DataBlobPool pool;
+	pool.acquire<float>(DataBlobShape(1, 1, 4, 4));
+	// same number of bytes, other shape or other type
+	pool.acquire<float>(DataBlobShape(1, 4, 2, 2));
+	pool.acquire<uchar>(DataBlobShape(1, 4, 4, 4));
+	EXPECT_EQ(pool.stats().misses, 3U);
+	EXPECT_EQ(pool.stats().blocksCached, 3U);
+	pool.acquire<uchar>(DataBlobShape(1, 4, 4, 4));
+	EXPECT_EQ(pool.stats().hits, 1U);
+}
+
+TEST(DataBlobPool, CapAndTrim) {
+	DataBlobPool pool(BlobMemory::kHEAP, 2 * 1000 * sizeof(float));
+	{
+		DataBlob32f a = pool.acquire<float>(DataBlobShape(1, 1000, 1, 1));
+		DataBlob32f b = pool.acquire<float>(DataBlobShape(1, 1000, 1, 1));
+		DataBlob32f c = pool.acquire<float>(DataBlobShape(1, 1000, 1, 1));
+	}
+	EXPECT_EQ(pool.stats().recycled, 3U);
+	EXPECT_EQ(pool.stats().releases, 1U);
+	EXPECT_EQ(pool.stats().blocksCached, 2U);
+	EXPECT_EQ(pool.trim(), 2 * 1000 * sizeof(float));
+	EXPECT_EQ(pool.stats().releases, 3U);
+	EXPECT_EQ(pool.stats().bytesCached, 0U);
+}
+
+TEST(DataBlobPool, BlobsOutliveThePool) {
+	DataBlob32f blob;
+	{
+		DataBlobPool pool;
+		blob = pool.acquire<float>(DataBlobShape(2, 3, 8, 8));
+	}
+	blob.ptr()[blob.total_n_elem() - 1] = 2.0f;
+	blob = DataBlob32f();
+}
+
+TEST(DataBlobPool, UninitializedBlobsSkipZeroing) {
+	DataBlobPool pool;
+	DataBlobShape shape(1, 10, 1, 1);
+	float* first;
+	{
+		DataBlob32f blob = pool.acquire<float>(shape, BlobInit::kUNINITIALIZED);
+		first = blob.ptr();
+		blob.ptr()[3] = 3.0f;
+	}
+	DataBlob32f again = pool.acquire<float>(shape, BlobInit::kUNINITIALIZED);
+	ASSERT_EQ(again.ptr(), first);
+	EXPECT_EQ(again.ptr()[3], 3.0f);
+}
@@ -0,0 +1,132 @@
+#include <common/buffers.h>
+#include <common/deviceAllocator.h>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <thread>
+
+using dtrCommon::CachingDeviceAllocator;
+
+TEST(DeviceAllocator, SizeClasses) {
+	EXPECT_EQ(CachingDeviceAllocator::blockSize(1), 512U);
+	EXPECT_EQ(CachingDeviceAllocator::blockSize(512), 512U);
+	EXPECT_EQ(CachingDeviceAllocator::blockSize(513), 640U);
+	EXPECT_EQ(CachingDeviceAllocator::blockSize(1024), 1024U);
+	EXPECT_EQ(CachingDeviceAllocator::blockSize(1025), 1280U);
+	EXPECT_EQ(CachingDeviceAllocator::blockSize(3 << 20), 3U << 20);
+	// past the smallest class a block wastes less than a fifth of itself
+	for (size_t size = 513; size < (64 << 20); size = size * 3 / 2 + 7) {
+		size_t block = CachingDeviceAllocator::blockSize(size);
+		EXPECT_GE(block, size);
+		EXPECT_LT(block - size, block / 5 + 1);
+	}
+}
+
+TEST(DeviceAllocator, ReusesFreedBlocks) {
+	CachingDeviceAllocator allocator;
+	void* first = nullptr;
+	ASSERT_EQ(allocator.allocate(&first, 1000), cudaSuccess);
+	ASSERT_NE(first, nullptr);
+	EXPECT_EQ(allocator.free(first), cudaSuccess);
+	// 900 bytes fall in the same 1024 byte class
+	void* second = nullptr;
+	ASSERT_EQ(allocator.allocate(&second, 900), cudaSuccess);
+	EXPECT_EQ(second, first);
+	dtrCommon::DeviceAllocatorStats stats = allocator.stats();
+	EXPECT_EQ(stats.hits, 1U);
+	EXPECT_EQ(stats.misses, 1U);
+	EXPECT_EQ(stats.bytesRequested, 900U);
+	EXPECT_EQ(stats.bytesInUse, 1024U);
+	EXPECT_EQ(stats.bytesCached, 0U);
+	EXPECT_NEAR(stats.fragmentation(), 1.0 - 900.0 / 1024, 1e-9);
+	std::cout << stats << std::endl;
+	allocator.free(second);
+}
+
+TEST(DeviceAllocator, PerStreamFreeLists) {
+	CachingDeviceAllocator allocator;
+	cudaStream_t a, b;
+	ASSERT_EQ(cudaStreamCreate(&a), cudaSuccess);
+	ASSERT_EQ(cudaStreamCreate(&b), cudaSuccess);
+	void* onA = nullptr;
+	ASSERT_EQ(allocator.allocate(&onA, 4096, a), cudaSuccess);
+	allocator.free(onA);
+	// a block cached for stream a is not handed to stream b
+	void* onB = nullptr;
+	ASSERT_EQ(allocator.allocate(&onB, 4096, b), cudaSuccess);
+	EXPECT_NE(onB, onA);
+	void* again = nullptr;
+	ASSERT_EQ(allocator.allocate(&again, 4096, a), cudaSuccess);
+	EXPECT_EQ(again, onA);
+	EXPECT_EQ(allocator.stats().hits, 1U);
+	EXPECT_EQ(allocator.stats().misses, 2U);
+	allocator.free(onB);
+	allocator.free(again);
+	allocator.trim();
+	cudaStreamDestroy(a);
+	cudaStreamDestroy(b);
+}
+
+TEST(DeviceAllocator, TrimStream) {
+	CachingDeviceAllocator allocator;
+	cudaStream_t a, b;
+	ASSERT_EQ(cudaStreamCreate(&a), cudaSuccess);
+	ASSERT_EQ(cudaStreamCreate(&b), cudaSuccess);
+	void* onA = nullptr;
+	void* onB = nullptr;
+	ASSERT_EQ(allocator.allocate(&onA, 4096, a), cudaSuccess);
+	ASSERT_EQ(allocator.allocate(&onB, 1000, b), cudaSuccess);
+	allocator.free(onA);
+	allocator.free(onB);
+	// only the blocks of the stream going away are released
+	EXPECT_EQ(allocator.trimStream(a), 4096U);
+	EXPECT_EQ(allocator.stats().bytesCached, 1024U);
+	EXPECT_EQ(allocator.stats().releases, 1U);
+	EXPECT_EQ(allocator.trimStream(a), 0U);
+	cudaStreamDestroy(a);
+	EXPECT_EQ(allocator.trimStream(b), 1024U);
+	cudaStreamDestroy(b);
+}
+
+TEST(DeviceAllocator, Trim) {
+	CachingDeviceAllocator allocator;
+	void* ptrs[4];
+	for (void*& ptr : ptrs) {
+		ASSERT_EQ(allocator.allocate(&ptr, 1 << 16), cudaSuccess);
+	}
+	for (void* ptr : ptrs) {
+		allocator.free(ptr);
+	}
+	EXPECT_EQ(allocator.stats().blocksCached, 4U);
+	EXPECT_EQ(allocator.stats().bytesCached, 4U << 16);
+	// nothing has been idle for an hour
+	EXPECT_EQ(allocator.trim(std::chrono::hours(1)), 0U);
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	EXPECT_EQ(allocator.trim(std::chrono::milliseconds(10)), 4U << 16);
+	EXPECT_EQ(allocator.stats().bytesCached, 0U);
+	EXPECT_EQ(allocator.stats().releases, 4U);
+
+	// past the cap freed blocks are released at once, the cache is bounded by default
+	EXPECT_EQ(CachingDeviceAllocator().stats().bytesCached, 0U);
+	allocator.setMaxCachedBytes(1 << 16);
+	void* a = nullptr;
+	void* b = nullptr;
+	ASSERT_EQ(allocator.allocate(&a, 1 << 16), cudaSuccess);
+	ASSERT_EQ(allocator.allocate(&b, 1 << 16), cudaSuccess);
+	allocator.free(a);
+	allocator.free(b);
+	EXPECT_EQ(allocator.stats().bytesCached, 1U << 16);
+	EXPECT_EQ(allocator.stats().releases, 5U);
+}
+
+TEST(DeviceAllocator, DeviceBufferSharesTheCache) {
+	CachingDeviceAllocator& allocator = CachingDeviceAllocator::instance();
+	void* first;
+	{
+		dtrCommon::DeviceBuffer buffer(3 * 224 * 224 * sizeof(float));
+		first = buffer.data();
+	}
+	size_t hits = allocator.stats().hits;
+	dtrCommon::DeviceBuffer buffer(3 * 224 * 224 * sizeof(float));
+	EXPECT_EQ(buffer.data(), first);
+	EXPECT_EQ(allocator.stats().hits, hits + 1);
+}
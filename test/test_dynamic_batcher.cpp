@@ -0,0 +1,150 @@
+#include <DynamicBatcher.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstring>
+#include <new>
+
+namespace {
+// doubles its single input and remembers the batch sizes it was called with
+class DoublingModel : public IBaseModel {
+public:
+	bool build() { return true; }
+	std::vector<DataBlob32f> infer(const std::vector<DataBlob32f>& input_blobs) {
+		std::lock_guard<std::mutex> lock(mMutex);
+		mBatchSizes.push_back(input_blobs[0].nums());
+		DataBlob32f output = input_blobs[0].clone();
+		for (size_t i = 0; i < output.total_n_elem(); ++i) {
+			output.ptr()[i] *= 2;
+		}
+		return {output};
+	}
+	bool teardown() { return true; }
+	std::vector<size_t> batchSizes() {
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mBatchSizes;
+	}
+private:
+	std::mutex mMutex;
+	std::vector<size_t> mBatchSizes;
+};
+
+// throws bad_alloc from the first batch, then doubles
+class FailingOnceModel : public DoublingModel {
+public:
+	std::vector<DataBlob32f> infer(const std::vector<DataBlob32f>& input_blobs) {
+		if (!mFailed.exchange(true)) {
+			throw std::bad_alloc();
+		}
+		return DoublingModel::infer(input_blobs);
+	}
+private:
+	std::atomic<bool> mFailed{false};
+};
+
+// a DoublingModel that reports its input, one 1x2x2 sample
+class ShapedModel : public DoublingModel {
+public:
+	std::vector<DataBlobShape> inputShapes() { return {DataBlobShape(1, 1, 2, 2)}; }
+};
+
+DataBlob32f makeSample(float value) {
+	DataBlob32f sample(1, 1, 2, 2);
+	for (size_t i = 0; i < sample.total_n_elem(); ++i) {
+		sample.ptr()[i] = value;
+	}
+	return sample;
+}
+}
+
+TEST(DynamicBatcher, FillsBatchAndScatters) {
+	DoublingModel model;
+	DynamicBatcherParams params;
+	params.maxBatchSize = 4;
+	params.maxDelay = std::chrono::seconds(10);
+	std::vector<std::future<std::vector<DataBlob32f>>> results;
+	{
+		DynamicBatcher batcher(model, params);
+		for (int i = 0; i < 8; ++i) {
+			results.push_back(batcher.submit({makeSample(static_cast<float>(i))}));
+		}
+		for (int i = 0; i < 8; ++i) {
+			std::vector<DataBlob32f> outputs = results[i].get();
+			ASSERT_EQ(outputs.size(), 1U);
+			ASSERT_EQ(outputs[0].nums(), 1U);
+			EXPECT_EQ(outputs[0].ptr()[3], 2.0f * i);
+		}
+		DynamicBatcherStats stats = batcher.stats();
+		EXPECT_EQ(stats.batchSize.total(), 2U);
+		EXPECT_EQ(stats.batchSize.counts()[3], 2U);
+		EXPECT_EQ(stats.queueDelayUs.total(), 8U);
+	}
+	std::vector<size_t> batchSizes = model.batchSizes();
+	ASSERT_EQ(batchSizes.size(), 2U);
+	EXPECT_EQ(batchSizes[0], 4U);
+}
+
+TEST(DynamicBatcher, DelayFlushesPartialBatch) {
+	DoublingModel model;
+	DynamicBatcherParams params;
+	params.maxBatchSize = 8;
+	params.maxDelay = std::chrono::milliseconds(5);
+	DynamicBatcher batcher(model, params);
+	std::future<std::vector<DataBlob32f>> result = batcher.submit({makeSample(3.0f)});
+	ASSERT_EQ(result.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+	std::vector<DataBlob32f> outputs = result.get();
+	ASSERT_EQ(outputs.size(), 1U);
+	EXPECT_EQ(outputs[0].ptr()[0], 6.0f);
+	ASSERT_EQ(model.batchSizes().size(), 1U);
+	EXPECT_EQ(model.batchSizes()[0], 1U);
+	// a sample of the wrong shape is rejected on its own
+	EXPECT_TRUE(batcher.submit({DataBlob32f(2, 1, 2, 2)}).get().empty());
+}
+
+TEST(DynamicBatcher, ExceptionsFailTheBatch) {
+	FailingOnceModel model;
+	DynamicBatcherParams params;
+	params.maxBatchSize = 2;
+	params.maxDelay = std::chrono::seconds(10);
+	DynamicBatcher batcher(model, params);
+	std::future<std::vector<DataBlob32f>> first = batcher.submit({makeSample(1.0f)});
+	std::future<std::vector<DataBlob32f>> second = batcher.submit({makeSample(2.0f)});
+	EXPECT_THROW(first.get(), std::bad_alloc);
+	EXPECT_THROW(second.get(), std::bad_alloc);
+	EXPECT_EQ(batcher.stats().failedBatches, 1U);
+	// the worker survived the batch
+	std::future<std::vector<DataBlob32f>> third = batcher.submit({makeSample(3.0f)});
+	std::future<std::vector<DataBlob32f>> fourth = batcher.submit({makeSample(4.0f)});
+	EXPECT_EQ(fourth.get()[0].ptr()[0], 8.0f);
+	EXPECT_EQ(third.get()[0].ptr()[0], 6.0f);
+}
+
+TEST(DynamicBatcher, MalformedRequestFailsAlone) {
+	DataBlob32f wrongDims(1, 1, 3, 3);
+	memset(wrongDims.ptr(), 0, wrongDims.total_n_elem() * sizeof(float));
+	// the batch is checked against the inputs of the model, whatever its first request holds
+	ShapedModel shaped;
+	DoublingModel unshaped;
+	for (IBaseModel* model : std::vector<IBaseModel*>{&shaped, &unshaped}) {
+		DynamicBatcherParams params;
+		params.maxBatchSize = 3;
+		params.maxDelay = std::chrono::seconds(10);
+		DynamicBatcher batcher(*model, params);
+		std::future<std::vector<DataBlob32f>> malformed = batcher.submit({DataBlob32f(2, 1, 2, 2)});
+		std::future<std::vector<DataBlob32f>> first = batcher.submit({makeSample(1.0f)});
+		std::future<std::vector<DataBlob32f>> second = batcher.submit({makeSample(2.0f)});
+		EXPECT_TRUE(malformed.get().empty());
+		ASSERT_EQ(first.get()[0].ptr()[0], 2.0f);
+		ASSERT_EQ(second.get()[0].ptr()[0], 4.0f);
+	}
+	EXPECT_EQ(shaped.batchSizes(), std::vector<size_t>{2U});
+
+	// a sample of the wrong dims is only caught by a model that reports its inputs
+	DynamicBatcherParams params;
+	params.maxBatchSize = 2;
+	params.maxDelay = std::chrono::seconds(10);
+	DynamicBatcher batcher(shaped, params);
+	std::future<std::vector<DataBlob32f>> malformed = batcher.submit({wrongDims});
+	std::future<std::vector<DataBlob32f>> valid = batcher.submit({makeSample(3.0f)});
+	EXPECT_TRUE(malformed.get().empty());
+	ASSERT_EQ(valid.get()[0].ptr()[0], 6.0f);
+}
@@ -0,0 +1,57 @@
+#include <EngineCache.h>
+#include <gtest/gtest.h>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+
+TEST(EngineCache, KeyCoversEveryField) {
+	EngineKey a, b, c;
+	a.add(std::string("ab")).add(std::string("c"));
+	b.add(std::string("a")).add(std::string("bc"));
+	c.add(std::string("ab")).add(std::string("c"));
+	EXPECT_NE(a.str(), b.str());
+	EXPECT_EQ(a.str(), c.str());
+	EXPECT_EQ(a.str().size(), 16U);
+	EXPECT_NE(EngineKey().add(4).str(), EngineKey().add(8).str());
+	EXPECT_NE(EngineKey().add(true).str(), EngineKey().add(false).str());
+	EngineKey missing;
+	EXPECT_FALSE(missing.addFile("/nonexistent/deploy.prototxt"));
+}
+
+TEST(EngineCache, StoreAndLoad) {
+	char dir[] = "/tmp/test_engine_cache_XXXXXX";
+	ASSERT_NE(mkdtemp(dir), nullptr);
+	std::string path = std::string(dir) + "/weights";
+	{
+		std::ofstream weights(path, std::ios::binary);
+		weights << "weights v1";
+	}
+	EngineKey key;
+	ASSERT_TRUE(key.addFile(path));
+	// the cache directory is created by the first store()
+	EngineCache cache(std::string(dir) + "/engines");
+	EXPECT_FALSE(cache.load(key));
+
+	const char plan[] = "serialized plan";
+	ASSERT_TRUE(cache.store(key, plan, sizeof(plan)));
+	dtrCommon::MappedFile loaded = cache.load(key);
+	ASSERT_TRUE(loaded.good());
+	ASSERT_EQ(loaded.size(), sizeof(plan));
+	EXPECT_EQ(0, memcmp(loaded.data(), plan, sizeof(plan)));
+
+	// other weights give another key, so the stale plan is not picked up
+	{
+		std::ofstream weights(path, std::ios::binary);
+		weights << "weights v2";
+	}
+	EngineKey changed;
+	ASSERT_TRUE(changed.addFile(path));
+	EXPECT_NE(changed.str(), key.str());
+	EXPECT_FALSE(cache.load(changed));
+
+	unlink(cache.pathOf(key).c_str());
+	rmdir((std::string(dir) + "/engines").c_str());
+	unlink(path.c_str());
+	rmdir(dir);
+}
@@ -0,0 +1,88 @@
+#include <common/common.h>
+#include <common/hostArena.h>
+#include <gtest/gtest.h>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+using dtrCommon::HostArena;
+
+TEST(HostArena, ReusesBlocksOfTheThread) {
+	HostArena arena;
+	void* first = arena.allocate(1000);
+	ASSERT_NE(first, nullptr);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(first) % 64, 0U);
+	memset(first, 1, 1000);
+	arena.free(first);
+	// 900 bytes are of the same 1024 byte class
+	void* second = arena.allocate(900);
+	EXPECT_EQ(second, first);
+	dtrCommon::HostArenaStats stats = arena.stats();
+	EXPECT_EQ(stats.allocations, 2U);
+	EXPECT_EQ(stats.threadCacheHits, 1U);
+	EXPECT_EQ(stats.systemAllocations, 1U);
+	EXPECT_EQ(stats.bytesInUse, 1024U);
+	EXPECT_EQ(stats.bytesCached, 0U);
+	arena.free(second);
+	EXPECT_EQ(arena.trim(), 1024U);
+	EXPECT_EQ(arena.stats().bytesCached, 0U);
+	std::cout << arena.stats() << std::endl;
+}
+
+TEST(HostArena, BlocksOfExitedThreadsAreShared) {
+	HostArena arena;
+	void* ptr = nullptr;
+	std::thread([&]() {
+		ptr = arena.allocate(4096);
+		arena.free(ptr);
+	}).join();
+	// the thread handed its cache over when it exited
+	EXPECT_EQ(arena.allocate(4096), ptr);
+	EXPECT_EQ(arena.stats().centralHits, 1U);
+	arena.free(ptr);
+
+	// large blocks skip the thread caches
+	void* large = arena.allocate(4 << 20);
+	arena.free(large);
+	EXPECT_EQ(arena.stats().bytesCached, 4096U + (4 << 20));
+	std::thread([&]() { EXPECT_EQ(arena.allocate(4 << 20), large); arena.free(large); }).join();
+	arena.setMaxCachedBytes(0);
+	arena.trim();
+	void* uncached = arena.allocate(4 << 20);
+	arena.free(uncached);
+	EXPECT_EQ(arena.stats().bytesCached, 0U);
+	EXPECT_EQ(arena.stats().bytesInUse, 0U);
+}
+
+TEST(HostArena, AlignmentAndFlags) {
+	HostArena pages(4096);
+	void* ptr = pages.allocate(100, HostArena::kPREFAULT);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % 4096, 0U);
+	pages.free(ptr);
+
+	HostArena arena;
+	void* huge = arena.allocate(3 << 20, HostArena::kHUGE_PAGES);
+	ASSERT_NE(huge, nullptr);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(huge) % HostArena::kHUGE_PAGE_SIZE, 0U);
+	EXPECT_EQ(arena.stats().bytesInUse, 4U << 20);
+	memset(huge, 0, 3 << 20);
+	arena.free(huge);
+	EXPECT_EQ(arena.stats().bytesInUse, 0U);
+
+	// mlock may be refused under a low RLIMIT_MEMLOCK, the block is still usable
+	void* locked = arena.allocate(64 << 10, HostArena::kLOCK);
+	ASSERT_NE(locked, nullptr);
+	memset(locked, 0, 64 << 10);
+	arena.free(locked);
+	std::cout << arena.stats() << std::endl;
+}
+
+TEST(HostArena, FastAlloc) {
+	void* ptr = fastAlloc(3 * 224 * 224 * sizeof(float));
+	ASSERT_NE(ptr, nullptr);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % 64, 0U);
+	fastFree(ptr);
+	EXPECT_EQ(fastAlloc(3 * 224 * 224 * sizeof(float)), ptr);
+	fastFree(ptr);
+	fastFree(nullptr);
+}
@@ -0,0 +1,483 @@
+#include <CaffeModel.h>
+#include <DataBlobPool.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#ifdef DTR_NVINFER_STUB
+#include <StubRuntime.h>
+#endif
+
+dtrCommon::CaffeNNParams initializeNNParams();
+
+TEST(Infer, SteadyStateNoAllocation) {
+	dtrCommon::CaffeNNParams params = initializeNNParams();
+	CaffeModel sample(params);
+	ASSERT_TRUE(sample.build(false));
+
+	DataBlob32f input(params.batchSize, 3, 224, 224);
+	std::vector<DataBlob32f> inputs{input};
+	// the outputs of a call are alive while the next one runs, two sets of them circulate
+	std::vector<DataBlob32f> res = sample.infer(inputs);
+	res = sample.infer(inputs);
+	ASSERT_EQ(res.size(), params.outputTensorNames.size());
+
+	// the binding buffers come from the device allocator, the outputs from the blob pool
+	auto deviceAllocations = []() {
+		dtrCommon::DeviceAllocatorStats stats = dtrCommon::CachingDeviceAllocator::instance().stats();
+		return stats.hits + stats.misses;
+	};
+	size_t allocations = deviceAllocations();
+	DataBlobPoolStats blobs = DataBlobPool::instance().stats();
+	const int nbCalls = 10;
+	for(int i = 0; i < nbCalls; i++) {
+		res = sample.infer(inputs);
+		ASSERT_EQ(res.size(), params.outputTensorNames.size());
+	}
+	EXPECT_EQ(deviceAllocations(), allocations);
+	EXPECT_EQ(DataBlobPool::instance().stats().misses, blobs.misses);
+	EXPECT_EQ(DataBlobPool::instance().stats().hits, blobs.hits + nbCalls * res.size());
+
+	// reset() drops the execution state, the next infer() sets it up again. The device buffers
+	// were cached for the slot streams, they are given back with the streams
+	size_t cached = dtrCommon::CachingDeviceAllocator::instance().stats().bytesCached;
+	sample.reset();
+	EXPECT_EQ(dtrCommon::CachingDeviceAllocator::instance().stats().bytesCached, cached);
+	res = sample.infer(inputs);
+	ASSERT_EQ(res.size(), params.outputTensorNames.size());
+	EXPECT_GT(deviceAllocations(), allocations);
+	sample.teardown();
+}
+
+TEST(Infer, ConcurrentExecutionContexts) {
+	const int nbThreads = 4;
+	const int nbIterations = 20;
+	for (int nbContexts = 1; nbContexts <= nbThreads; nbContexts *= 2) {
+		dtrCommon::CaffeNNParams params = initializeNNParams();
+		params.nbExecutionContexts = nbContexts;
+		CaffeModel sample(params);
+		ASSERT_TRUE(sample.build(false));
+		DataBlob32f input(params.batchSize, 3, 224, 224);
+		std::vector<DataBlob32f> inputs{input};
+
+		std::atomic<int> failures{0};
+		auto begin = std::chrono::high_resolution_clock::now();
+		std::vector<std::thread> workers;
+		for (int t = 0; t < nbThreads; ++t) {
+			workers.emplace_back([&]() {
+				for (int i = 0; i < nbIterations; ++i) {
+					if (sample.infer(inputs).size() != params.outputTensorNames.size()) {
+						++failures;
+					}
+				}
+			});
+		}
+		for (auto& worker : workers) {
+			worker.join();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		EXPECT_EQ(failures.load(), 0);
+		fprintf(stderr, "%d contexts: %.2lf infer/s\n", nbContexts,
+			nbThreads * nbIterations * 1000.0 / std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count());
+		sample.teardown();
+	}
+}
+
+TEST(Infer, ZeroCopySlot) {
+	dtrCommon::CaffeNNParams params = initializeNNParams();
+	CaffeModel sample(params);
+	ASSERT_TRUE(sample.build(false));
+
+	DataBlob32f input(params.batchSize, 3, 224, 224);
+	for (size_t i = 0; i < input.total_n_elem(); ++i) {
+		input.ptr()[i] = static_cast<float>(i % 255);
+	}
+	std::vector<DataBlob32f> expected = sample.infer({input}, true);
+	ASSERT_EQ(expected.size(), 1U);
+
+	{
+		CaffeModel::Slot slot = sample.acquire();
+		DataBlob32f view = sample.inputBlob(slot, 0);
+		ASSERT_EQ(view.total_n_elem(), input.total_n_elem());
+		memcpy(view.ptr(), input.ptr(), input.total_n_elem() * sizeof(float));
+		ASSERT_TRUE(sample.infer(slot));
+		DataBlob32f output = sample.outputBlob(slot, 0);
+		ASSERT_EQ(output.total_n_elem(), expected[0].total_n_elem());
+		EXPECT_EQ(0, memcmp(output.ptr(), expected[0].ptr(), output.total_n_elem() * sizeof(float)));
+	}
+
+	std::vector<DataBlob32f> outputs{DataBlob32f(expected[0].shape())};
+	ASSERT_TRUE(sample.infer({input}, outputs));
+	EXPECT_EQ(0, memcmp(outputs[0].ptr(), expected[0].ptr(), outputs[0].total_n_elem() * sizeof(float)));
+	sample.teardown();
+}
+
+TEST(Infer, WarmupEverySlot) {
+	dtrCommon::CaffeNNParams params = initializeNNParams();
+	CaffeModel reference(params);
+	ASSERT_TRUE(reference.build(false));
+	DataBlob32f zeros(params.batchSize, 3, 224, 224);
+	memset(zeros.ptr(), 0, zeros.total_n_elem() * sizeof(float));
+	std::vector<DataBlob32f> expected = reference.infer({zeros});
+	ASSERT_EQ(expected.size(), 1U);
+	reference.teardown();
+
+	params.nbExecutionContexts = 3;
+	CaffeModel sample(params);
+	ASSERT_TRUE(sample.build(false));
+	EXPECT_EQ(sample.startupProfile().warmupIterations, params.warmupIterations);
+	// build() ran a batch of zeros on every slot, each one holds its inputs and outputs
+	std::vector<CaffeModel::Slot> slots;
+	for (int i = 0; i < params.nbExecutionContexts; ++i) {
+		slots.push_back(sample.acquire());
+		EXPECT_TRUE(sample.inputBlob(slots.back(), 0).equals(zeros));
+		EXPECT_TRUE(sample.outputBlob(slots.back(), 0).equals(expected[0]));
+	}
+	slots.clear();
+	sample.teardown();
+}
+
+TEST(Infer, AsyncPipeline) {
+	dtrCommon::CaffeNNParams params = initializeNNParams();
+	params.nbExecutionContexts = 3;
+	CaffeModel sample(params);
+	ASSERT_TRUE(sample.build(false));
+	DataBlob32f input(params.batchSize, 3, 224, 224);
+	std::vector<DataBlob32f> expected = sample.infer({input}, true);
+	ASSERT_EQ(expected.size(), 1U);
+
+	const int nbRequests = 16;
+	std::vector<std::future<std::vector<DataBlob32f>>> results;
+	auto begin = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < nbRequests; ++i) {
+		results.push_back(sample.inferAsync({input}));
+	}
+	for (auto& result : results) {
+		std::vector<DataBlob32f> outputs = result.get();
+		ASSERT_EQ(outputs.size(), 1U);
+		EXPECT_EQ(0, memcmp(outputs[0].ptr(), expected[0].ptr(), expected[0].total_n_elem() * sizeof(float)));
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	fprintf(stderr, "async infer time: %.2lf ms\n", std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() / double(nbRequests));
+
+	std::atomic<int> callbacks{0};
+	ASSERT_TRUE(sample.inferAsync({input}, [&callbacks](std::vector<DataBlob32f> outputs) {
+		if (outputs.size() == 1U) {
+			++callbacks;
+		}
+	}));
+	sample.reset();
+	EXPECT_EQ(callbacks.load(), 1);
+	sample.teardown();
+}
+
+TEST(Infer, ArbitraryBatchSize) {
+	dtrCommon::CaffeNNParams params = initializeNNParams();
+	params.nbExecutionContexts = 2;
+	CaffeModel sample(params);
+	ASSERT_TRUE(sample.build(false));
+
+	// every sample differs, each one run on its own is the reference
+	const size_t nbSamples = 2 * params.batchSize + 1;
+	DataBlob32f input(nbSamples, 3, 224, 224);
+	for (size_t i = 0; i < input.total_n_elem(); ++i) {
+		input.ptr()[i] = static_cast<float>((i * 7) % 255);
+	}
+	std::vector<DataBlob32f> expected;
+	for (size_t n = 0; n < nbSamples; ++n) {
+		DataBlob32f single(1, 3, 224, 224);
+		memcpy(single.ptr(), input.ptr(n), input.inst_n_elem() * sizeof(float));
+		std::vector<DataBlob32f> outputs = sample.infer({single});
+		ASSERT_EQ(outputs.size(), 1U);
+		ASSERT_EQ(outputs[0].nums(), 1U);
+		expected.push_back(outputs[0]);
+	}
+
+	std::vector<DataBlob32f> outputs = sample.infer({input});
+	ASSERT_EQ(outputs.size(), 1U);
+	ASSERT_EQ(outputs[0].nums(), nbSamples);
+	for (size_t n = 0; n < nbSamples; ++n) {
+		EXPECT_EQ(0, memcmp(outputs[0].ptr(n), expected[n].ptr(), expected[n].inst_n_elem() * sizeof(float)));
+	}
+
+	outputs = sample.inferAsync({input}).get();
+	ASSERT_EQ(outputs.size(), 1U);
+	ASSERT_EQ(outputs[0].nums(), nbSamples);
+	for (size_t n = 0; n < nbSamples; ++n) {
+		EXPECT_EQ(0, memcmp(outputs[0].ptr(n), expected[n].ptr(), expected[n].inst_n_elem() * sizeof(float)));
+	}
+
+	// inputs disagreeing with the bindings are rejected
+	EXPECT_TRUE(sample.infer({DataBlob32f(1, 3, 224, 223)}).empty());
+	EXPECT_TRUE(sample.infer({DataBlob32f()}).empty());
+	sample.teardown();
+}
+
+TEST(Infer, SelectedOutputs) {
+	dtrCommon::CaffeNNParams params = initializeNNParams();
+	CaffeModel sample(params);
+	ASSERT_TRUE(sample.build(false));
+	DataBlob32f input(params.batchSize, 3, 224, 224);
+	std::vector<DataBlob32f> expected = sample.infer({input});
+	ASSERT_EQ(expected.size(), 1U);
+
+	std::vector<DataBlob32f> outputs = sample.infer({input}, std::vector<std::string>{"prob"});
+	ASSERT_EQ(outputs.size(), 1U);
+	ASSERT_EQ(outputs[0].total_n_elem(), expected[0].total_n_elem());
+	EXPECT_EQ(0, memcmp(outputs[0].ptr(), expected[0].ptr(), expected[0].total_n_elem() * sizeof(float)));
+
+	EXPECT_TRUE(sample.infer({input}, std::vector<std::string>{}).empty());
+	EXPECT_TRUE(sample.infer({input}, std::vector<std::string>{"data"}).empty());
+	EXPECT_TRUE(sample.infer({input}, std::vector<std::string>{"no_such_output"}).empty());
+	sample.teardown();
+#ifdef DTR_NVINFER_STUB
+	// with several outputs only the requested ones come back to the host
+	params.gieFileName = "googlenet_gie_outputs.bin";
+	params.outputTensorNames = {"prob", "feat", "aux"};
+	const std::string plan = params.dataDirs[0] + params.gieFileName;
+	std::ofstream(plan, std::ios::binary) << dtrStub::makePlan({dtrStub::Binding("data", true, {3, 224, 224}),
+		dtrStub::Binding("prob", false, {1000, 1, 1}), dtrStub::Binding("feat", false, {256, 1, 1}),
+		dtrStub::Binding("aux", false, {10, 1, 1})}, 256);
+	CaffeModel multi(params);
+	ASSERT_TRUE(multi.build(false));
+	std::remove(plan.c_str());
+	auto bytesOf = [&](size_t volume) { return params.batchSize * volume * sizeof(float); };
+	size_t copied = dtrStub::bytesCopiedToHost();
+	expected = multi.infer({input});
+	ASSERT_EQ(expected.size(), 3U);
+	EXPECT_EQ(dtrStub::bytesCopiedToHost() - copied, bytesOf(1000 + 256 + 10));
+
+	copied = dtrStub::bytesCopiedToHost();
+	outputs = multi.infer({input}, std::vector<std::string>{"feat"});
+	ASSERT_EQ(outputs.size(), 1U);
+	EXPECT_TRUE(outputs[0].equals(expected[1]));
+	EXPECT_EQ(dtrStub::bytesCopiedToHost() - copied, bytesOf(256));
+
+	copied = dtrStub::bytesCopiedToHost();
+	outputs = multi.infer({input}, std::vector<std::string>{"aux", "prob"});
+	ASSERT_EQ(outputs.size(), 2U);
+	EXPECT_TRUE(outputs[0].equals(expected[2]));
+	EXPECT_TRUE(outputs[1].equals(expected[0]));
+	EXPECT_EQ(dtrStub::bytesCopiedToHost() - copied, bytesOf(10 + 1000));
+	multi.teardown();
+#endif
+}
+
+TEST(Infer, HotReload) {
+	dtrCommon::CaffeNNParams params = initializeNNParams();
+	params.nbExecutionContexts = 2;
+	CaffeModel sample(params);
+	ASSERT_TRUE(sample.build(false));
+	DataBlob32f input(params.batchSize, 3, 224, 224);
+	std::vector<DataBlob32f> expected = sample.infer({input});
+	ASSERT_EQ(expected.size(), 1U);
+
+	std::atomic<bool> done{false};
+	std::atomic<int> failures{0}, inferences{0};
+	auto matches = [&](const DataBlob32f& output) {
+		return memcmp(output.ptr(), expected[0].ptr(), expected[0].total_n_elem() * sizeof(float)) == 0;
+	};
+	// the clients go through every entry point that reads the engine and its bindings
+	std::vector<std::thread> clients;
+	for (int i = 0; i < 3; ++i) {
+		clients.emplace_back([&, i]() {
+			while (!done) {
+				bool ok = sample.isBuilt();
+				if (i == 0) {
+					std::vector<DataBlob32f> outputs = sample.infer({input});
+					ok = ok && outputs.size() == 1U && matches(outputs[0]);
+				} else if (i == 1) {
+					std::vector<DataBlob32f> outputs = sample.inferAsync({input}).get();
+					ok = ok && outputs.size() == 1U && matches(outputs[0]);
+				} else {
+					CaffeModel::Slot slot = sample.acquire();
+					DataBlob32f view = sample.inputBlob(slot, 0);
+					ok = ok && view.total_n_elem() == input.total_n_elem();
+					if (ok) {
+						memcpy(view.ptr(), input.ptr(), input.total_n_elem() * sizeof(float));
+						ok = sample.infer(slot) && matches(sample.outputBlob(slot, 0));
+					}
+				}
+				if (!ok) {
+					failures++;
+				}
+				inferences++;
+			}
+		});
+	}
+	for (int i = 0; i < 2; ++i) {
+		EXPECT_TRUE(sample.reloadAsync(params, false).get());
+	}
+	// a plan that does not deserialize leaves the current engine in place
+	dtrCommon::CaffeNNParams broken = params;
+	broken.gieFileName = params.prototxtFileName;
+	EXPECT_FALSE(sample.reload(broken, false));
+	done = true;
+	for (auto& thread : clients) {
+		thread.join();
+	}
+	EXPECT_EQ(failures, 0);
+	EXPECT_GT(inferences, 0);
+	EXPECT_EQ(sample.infer({input}).size(), 1U);
+
+	// the profile is that of the engine swapped in
+	dtrCommon::CaffeNNParams rewarmed = params;
+	rewarmed.warmupIterations = 3;
+	EXPECT_TRUE(sample.reload(rewarmed, false));
+	EXPECT_EQ(sample.startupProfile().warmupIterations, 3);
+#ifdef DTR_NVINFER_STUB
+	// an engine with the same bindings that can not run a full batch is refused
+	dtrCommon::CaffeNNParams narrow = params;
+	narrow.gieFileName = "googlenet_gie_narrow.bin";
+	std::ofstream(params.dataDirs[0] + narrow.gieFileName, std::ios::binary) << dtrStub::makePlan(
+		{dtrStub::Binding("data", true, {3, 224, 224}), dtrStub::Binding("prob", false, {1000, 1, 1})}, params.batchSize - 1);
+	EXPECT_FALSE(sample.reload(narrow, false));
+	std::remove((params.dataDirs[0] + narrow.gieFileName).c_str());
+	EXPECT_EQ(sample.infer({input}).size(), 1U);
+#endif
+	sample.teardown();
+}
+
+TEST(Infer, PinnedHostMemory) {
+	dtrCommon::CaffeNNParams params = initializeNNParams();
+	params.pinnedHostMemory = false;
+	CaffeModel pageable(params);
+	ASSERT_TRUE(pageable.build(false));
+	DataBlob32f input(params.batchSize, 3, 224, 224);
+	for (size_t i = 0; i < input.total_n_elem(); ++i) {
+		input.ptr()[i] = (i % 255) / 255.0f;
+	}
+	std::vector<DataBlob32f> expected = pageable.infer({input});
+	ASSERT_EQ(expected.size(), 1U);
+	{
+		CaffeModel::Slot slot = pageable.acquire();
+		EXPECT_EQ(slot->buffers->hostMemoryType(0), dtrCommon::HostMemoryType::kPAGEABLE);
+	}
+
+	params.pinnedHostMemory = true;
+	params.writeCombinedInputs = true;
+	CaffeModel pinned(params);
+	ASSERT_TRUE(pinned.build(false));
+	{
+		CaffeModel::Slot slot = pinned.acquire();
+		const nvinfer1::ICudaEngine& engine = *slot.pool()->engine();
+		for (int i = 0; i < engine.getNbBindings(); ++i) {
+			// the host reads the outputs back, they are never write-combined
+			EXPECT_EQ(slot->buffers->hostMemoryType(i), engine.bindingIsInput(i) ? dtrCommon::HostMemoryType::kWRITE_COMBINED
+				: dtrCommon::HostMemoryType::kPINNED);
+		}
+	}
+	std::vector<DataBlob32f> outputs = pinned.infer({input});
+	ASSERT_EQ(outputs.size(), 1U);
+	EXPECT_EQ(0, memcmp(outputs[0].ptr(), expected[0].ptr(), expected[0].total_n_elem() * sizeof(float)));
+	{
+		// infer() staged the input in the page-locked buffer of the slot it ran on, the last one released
+		CaffeModel::Slot slot = pinned.acquire();
+		DataBlob32f staged = pinned.inputBlob(slot, 0);
+		ASSERT_EQ(staged.total_n_elem(), input.total_n_elem());
+		EXPECT_EQ(0, memcmp(staged.ptr(), input.ptr(), input.total_n_elem() * sizeof(float)));
+	}
+	pinned.teardown();
+}
+
+TEST(Infer, SlabBuffers) {
+	dtrCommon::CaffeNNParams params = initializeNNParams();
+	CaffeModel reference(params);
+	ASSERT_TRUE(reference.build(false));
+	params.slabBuffers = true;
+	CaffeModel sample(params);
+	ASSERT_TRUE(sample.build(false));
+
+	const size_t nbSamples = params.batchSize + 1;
+	DataBlob32f input(nbSamples, 3, 224, 224);
+	for (size_t i = 0; i < input.total_n_elem(); ++i) {
+		input.ptr()[i] = static_cast<float>((i * 3) % 255);
+	}
+	// a full batch and a partial one
+	std::vector<DataBlob32f> expected = reference.infer({input});
+	std::vector<DataBlob32f> outputs = sample.infer({input});
+	ASSERT_EQ(expected.size(), 1U);
+	ASSERT_EQ(outputs.size(), 1U);
+	EXPECT_EQ(0, memcmp(outputs[0].ptr(), expected[0].ptr(), expected[0].total_n_elem() * sizeof(float)));
+
+	{
+		CaffeModel::Slot slot = sample.acquire();
+		const nvinfer1::ICudaEngine& engine = *slot.pool()->engine();
+		EXPECT_EQ(slot->buffers->layout(), dtrCommon::BufferLayout::kSLAB);
+		// the bindings of a direction follow each other in one allocation
+		const char* next[2] = {nullptr, nullptr};
+		for (int i = 0; i < engine.getNbBindings(); ++i) {
+			const char* host = static_cast<const char*>(slot->buffers->getHostBuffer(i));
+			const char*& expectedHost = next[engine.bindingIsInput(i)];
+			EXPECT_TRUE(expectedHost == nullptr || host == expectedHost);
+			expectedHost = host + (slot->buffers->size(i) + dtrCommon::BufferManager::kSLAB_ALIGNMENT - 1)
+				/ dtrCommon::BufferManager::kSLAB_ALIGNMENT * dtrCommon::BufferManager::kSLAB_ALIGNMENT;
+		}
+		DataBlob32f view = sample.inputBlob(slot, 0);
+		memcpy(view.ptr(), input.ptr(), view.total_n_elem() * sizeof(float));
+		ASSERT_TRUE(sample.infer(slot));
+		DataBlob32f output = sample.outputBlob(slot, 0);
+		EXPECT_EQ(0, memcmp(output.ptr(), expected[0].ptr(), output.total_n_elem() * sizeof(float)));
+	}
+	reference.teardown();
+	sample.teardown();
+}
+
+TEST(Infer, MappedHostMemory) {
+	dtrCommon::CaffeNNParams params = initializeNNParams();
+	CaffeModel reference(params);
+	ASSERT_TRUE(reference.build(false));
+	DataBlob32f input(params.batchSize, 3, 224, 224);
+	for (size_t i = 0; i < input.total_n_elem(); ++i) {
+		input.ptr()[i] = static_cast<float>((i * 5) % 255);
+	}
+	std::vector<DataBlob32f> expected = reference.infer({input});
+	ASSERT_EQ(expected.size(), 1U);
+
+	params.mappedHostMemory = true;
+	for (bool slab : {false, true}) {
+		params.slabBuffers = slab;
+		CaffeModel sample(params);
+		ASSERT_TRUE(sample.build(false));
+		std::vector<DataBlob32f> outputs = sample.infer({input});
+		ASSERT_EQ(outputs.size(), 1U);
+		EXPECT_EQ(0, memcmp(outputs[0].ptr(), expected[0].ptr(), expected[0].total_n_elem() * sizeof(float)));
+
+		// the engine works on the host buffers in place, the copies do nothing
+		CaffeModel::Slot slot = sample.acquire();
+		const nvinfer1::ICudaEngine& engine = *slot.pool()->engine();
+		for (int i = 0; i < engine.getNbBindings(); ++i) {
+			EXPECT_EQ(slot->buffers->hostMemoryType(i), dtrCommon::HostMemoryType::kMAPPED);
+		}
+		DataBlob32f view = sample.inputBlob(slot, 0);
+		memcpy(view.ptr(), input.ptr(), view.total_n_elem() * sizeof(float));
+		ASSERT_TRUE(sample.infer(slot));
+		DataBlob32f output = sample.outputBlob(slot, 0);
+		EXPECT_EQ(0, memcmp(output.ptr(), expected[0].ptr(), output.total_n_elem() * sizeof(float)));
+	}
+	reference.teardown();
+}
+
+TEST(Infer, StridedInputs) {
+	dtrCommon::CaffeNNParams params = initializeNNParams();
+	CaffeModel sample(params);
+	ASSERT_TRUE(sample.build(false));
+	// the network input is a crop of larger frames, and a batch split in two
+	DataBlob32f frames(DataBlobShape(params.batchSize + 1, 3, 240, 256), BlobMemory::kHEAP);
+	for (size_t i = 0; i < frames.total_n_elem(); ++i) {
+		frames.ptr()[i] = static_cast<float>((i * 7) % 255);
+	}
+	DataBlob32f crop = frames.roi(8, 16, 224, 224);
+	std::vector<DataBlob32f> expected = sample.infer({crop.clone()});
+	std::vector<DataBlob32f> outputs = sample.infer({crop});
+	ASSERT_EQ(expected.size(), 1U);
+	ASSERT_EQ(outputs.size(), 1U);
+	EXPECT_TRUE(outputs[0].equals(expected[0]));
+
+	std::vector<DataBlob32f> head = sample.infer({crop.slice_batch(0, 1)});
+	ASSERT_EQ(head.size(), 1U);
+	EXPECT_TRUE(head[0].equals(expected[0].slice_batch(0, 1)));
+	sample.teardown();
+}
@@ -21,27 +21,36 @@ TEST(Init, CaffeModel) {
 	dtrCommon::CaffeNNParams params = initializeNNParams();
 	// params.int8 = true;
 	// params.perTensorDynamicRangeFileName = "";
+	params.warmupIterations = 2;
 	CaffeModel sample(params);
-	auto begin = std::chrono::high_resolution_clock::now();
+	EXPECT_FALSE(sample.isReady());
    	bool status = sample.build(true);
-	auto end = std::chrono::high_resolution_clock::now();
-	fprintf(stderr, "loadmodel time: %ld ms\n", (std::chrono::duration_cast<milliseconds>(end - begin)).count());
+	const StartupProfile& profile = sample.startupProfile();
+	std::cerr << "startup: " << profile << std::endl;
+	EXPECT_EQ(sample.isReady(), status);
 	CaffeModel::shape_t shape = sample.getInputDimension(0);
 	ASSERT_EQ(shape[0], 1);
 	ASSERT_EQ(shape[1], 3);
 	ASSERT_EQ(shape[2], 224);
 	ASSERT_EQ(shape[3], 224);
 	if(status) {
+		EXPECT_GT(profile.parseMs, 0);
+		EXPECT_GT(profile.buildMs, 0);
+		EXPECT_GT(profile.contextCreationMs, 0);
+		EXPECT_EQ(profile.warmupIterations, 2);
+		EXPECT_GT(profile.firstInferenceMs, 0);
+		EXPECT_GE(profile.warmupMs, profile.firstInferenceMs);
+		EXPECT_GE(profile.totalMs, profile.buildMs + profile.warmupMs);
 		DataBlob32f input(1,3,224,224);
 		memset(input.ptr(), 0, input.total_n_elem()*sizeof(float));
 		std::vector<DataBlob32f> inputs{input};
 		std::vector<DataBlob32f> res = sample.infer(inputs);
 		ASSERT_GE(res.size(), 0U);
-		begin = high_resolution_clock::now();
+		auto begin = high_resolution_clock::now();
 		for(int i = 0; i < 10; i++) {
 			res = sample.infer(inputs);
 		}
-		end = high_resolution_clock::now();
+		auto end = high_resolution_clock::now();
 		fprintf(stderr, "infer time: %.2lf ms\n", (std::chrono::duration_cast<milliseconds>(end - begin)).count()/10.0f);
 		sample.teardown();
 	} else {
@@ -52,24 +61,56 @@ TEST(Init, CaffeModel) {
 TEST(Init, GIEModel) {
 	dtrCommon::CaffeNNParams params = initializeNNParams();
 	CaffeModel sample(params);
-	auto begin = std::chrono::high_resolution_clock::now();
    	bool status = sample.build(false);
-	auto end = std::chrono::high_resolution_clock::now();
-	fprintf(stderr, "loadmodel time: %ld ms\n", (std::chrono::duration_cast<milliseconds>(end - begin)).count());
+	const StartupProfile& profile = sample.startupProfile();
+	std::cerr << "startup: " << profile << std::endl;
+	EXPECT_EQ(sample.isReady(), status);
 	if(status) {
+		EXPECT_GT(profile.fileReadMs, 0);
+		EXPECT_GT(profile.deserializeMs, 0);
+		EXPECT_EQ(profile.parseMs, 0);
+		EXPECT_EQ(profile.buildMs, 0);
+		EXPECT_EQ(profile.warmupIterations, params.warmupIterations);
 		DataBlob32f input(1,3,224,224);
 		memset(input.ptr(), 0, input.total_n_elem()*sizeof(float));
 		std::vector<DataBlob32f> inputs{input};
 		std::vector<DataBlob32f> res = sample.infer(inputs);
-		begin = high_resolution_clock::now();
+		auto begin = high_resolution_clock::now();
 		ASSERT_GE(res.size(), 0U);
 		for(int i = 0; i < 10; i++) {
 			res = sample.infer(inputs, false);
 		}
-		end = high_resolution_clock::now();
+		auto end = high_resolution_clock::now();
 		fprintf(stderr, "infer time: %.2lf ms\n", (std::chrono::duration_cast<milliseconds>(end - begin)).count()/10.0f);
 		sample.teardown();
 	} else {
 		LOG_ERROR(gLogger) << "model load status:" << status << std::endl;
 	}
 }
+
+TEST(Init, EngineCache) {
+	char dir[] = "/tmp/test_engine_cache_XXXXXX";
+	ASSERT_NE(mkdtemp(dir), nullptr);
+	dtrCommon::CaffeNNParams params = initializeNNParams();
+	params.engineCacheDir = dir;
+	DataBlob32f input(params.batchSize, 3, 224, 224);
+
+	CaffeModel built(params);
+	ASSERT_TRUE(built.build(true));
+	std::cerr << "built: " << built.startupProfile() << std::endl;
+	EXPECT_FALSE(built.startupProfile().engineCacheHit);
+	EXPECT_GT(built.startupProfile().serializeMs, 0);
+	std::vector<DataBlob32f> expected = built.infer({input});
+	ASSERT_EQ(expected.size(), 1U);
+
+	CaffeModel cached(params);
+	ASSERT_TRUE(cached.build(true));
+	std::cerr << "cached: " << cached.startupProfile() << std::endl;
+	EXPECT_TRUE(cached.startupProfile().engineCacheHit);
+	EXPECT_EQ(cached.startupProfile().buildMs, 0);
+	EXPECT_EQ(cached.getInputDimension(0), built.getInputDimension(0));
+	std::vector<DataBlob32f> res = cached.infer({input});
+	ASSERT_EQ(res.size(), 1U);
+	EXPECT_EQ(0, memcmp(res[0].ptr(), expected[0].ptr(), expected[0].total_n_elem() * sizeof(float)));
+	cached.teardown();
+}
@@ -0,0 +1,98 @@
+#include <LayoutConvert.h>
+#include <gtest/gtest.h>
+#include <cstring>
+#include <vector>
+
+using dtrCommon::SimdLevel;
+
+namespace {
+template <typename T>
+std::vector<T> nchwToNhwc(const std::vector<T>& src, size_t n, size_t c, size_t h, size_t w) {
+	std::vector<T> dst(src.size());
+	for (size_t i = 0; i < n; ++i)
+		for (size_t k = 0; k < c; ++k)
+			for (size_t p = 0; p < h * w; ++p)
+				dst[(i * h * w + p) * c + k] = src[(i * c + k) * h * w + p];
+	return dst;
+}
+
+template <typename T>
+std::vector<T> iota(size_t size) {
+	std::vector<T> values(size);
+	for (size_t i = 0; i < size; ++i) {
+		values[i] = static_cast<T>(i * 7 + 1);
+	}
+	return values;
+}
+}
+
+TEST(LayoutConvert, MatchesTheReferenceAtEveryLevel) {
+	const size_t shapes[][4] = {{1, 3, 1, 1}, {2, 3, 17, 19}, {1, 3, 64, 64}, {1, 4, 9, 33}, {3, 2, 5, 7},
+		{1, 5, 31, 3}, {2, 8, 8, 8}, {1, 16, 16, 16}, {1, 17, 20, 20}, {1, 64, 14, 14}, {2, 40, 3, 37}};
+	for (auto& shape : shapes) {
+		size_t n = shape[0], c = shape[1], h = shape[2], w = shape[3];
+		std::vector<float> nchw = iota<float>(n * c * h * w);
+		std::vector<float> nhwc = nchwToNhwc(nchw, n, c, h, w);
+		for (int level = 0; level <= static_cast<int>(dtrCommon::cpuSimdLevel()); ++level) {
+			SCOPED_TRACE(std::string(dtrCommon::simdLevelName(static_cast<SimdLevel>(level))) + " " + std::to_string(c)
+				+ "x" + std::to_string(h) + "x" + std::to_string(w));
+			std::vector<float> out(nchw.size(), -1.0f);
+			convertLayout(nchw.data(), BlobLayout::kNCHW, out.data(), BlobLayout::kNHWC, n, c, h, w, static_cast<SimdLevel>(level));
+			EXPECT_EQ(out, nhwc);
+			std::vector<float> back(nchw.size(), -1.0f);
+			convertLayout(out.data(), BlobLayout::kNHWC, back.data(), BlobLayout::kNCHW, n, c, h, w, static_cast<SimdLevel>(level));
+			EXPECT_EQ(back, nchw);
+		}
+		std::vector<uchar> bytes = iota<uchar>(n * c * h * w);
+		std::vector<uchar> out(bytes.size());
+		convertLayout(bytes.data(), BlobLayout::kNCHW, out.data(), BlobLayout::kNHWC, n, c, h, w);
+		EXPECT_EQ(out, nchwToNhwc(bytes, n, c, h, w));
+	}
+}
+
+TEST(LayoutConvert, Parallel) {
+	const size_t n = 3, c = 3, h = 120, w = 161;
+	std::vector<float> nchw = iota<float>(n * c * h * w);
+	std::vector<float> nhwc = nchwToNhwc(nchw, n, c, h, w);
+	for (size_t threads : {1, 2, 4, 7}) {
+		std::vector<float> out(nchw.size());
+		convertLayoutParallel(nhwc.data(), BlobLayout::kNHWC, out.data(), BlobLayout::kNCHW, n, c, h, w, threads);
+		EXPECT_EQ(out, nchw);
+		// a single frame is split as well
+		convertLayoutParallel(nchw.data(), BlobLayout::kNCHW, out.data(), BlobLayout::kNHWC, 1, c, h, w, threads);
+		EXPECT_EQ(0, memcmp(out.data(), nhwc.data(), c * h * w * sizeof(float)));
+	}
+}
+
+TEST(LayoutConvert, InterleavedBlobs) {
+	const size_t n = 2, c = 3, h = 4, w = 5;
+	std::vector<float> nchw = iota<float>(n * c * h * w);
+	std::vector<float> nhwc = nchwToNhwc(nchw, n, c, h, w);
+	DataBlob32f planar(DataBlobShape(n, c, h, w), nchw.data());
+	DataBlob32f frame(DataBlobShape(n, c, h, w), nhwc.data(), BlobLayout::kNHWC);
+	EXPECT_EQ(frame.layout(), BlobLayout::kNHWC);
+	EXPECT_EQ(frame.step(), w * c);
+	EXPECT_EQ(frame.pixel_step(), c);
+	EXPECT_TRUE(frame.is_continuous());
+	EXPECT_EQ(frame.at(1, 2, 3, 4), planar.at(1, 2, 3, 4));
+	EXPECT_EQ(frame.at(0, 1, 2, 3), nhwc[(2 * w + 3) * c + 1]);
+	EXPECT_TRUE(frame.equals(planar));
+
+	DataBlob32f converted = frame.to_layout(BlobLayout::kNCHW);
+	EXPECT_EQ(converted.layout(), BlobLayout::kNCHW);
+	EXPECT_EQ(0, memcmp(converted.ptr(), nchw.data(), nchw.size() * sizeof(float)));
+	EXPECT_EQ(0, memcmp(planar.to_layout(BlobLayout::kNHWC).ptr(), nhwc.data(), nhwc.size() * sizeof(float)));
+	EXPECT_EQ(frame.clone().layout(), BlobLayout::kNHWC);
+
+	// views of an interleaved blob
+	DataBlob32f green = frame.slice_channels(1, 2);
+	EXPECT_FALSE(green.is_continuous());
+	EXPECT_TRUE(green.equals(planar.slice_channels(1, 2)));
+	DataBlob32f crop = frame.roi(1, 2, 2, 3);
+	EXPECT_EQ(crop.at(1, 2, 1, 2), planar.at(1, 2, 2, 4));
+	EXPECT_TRUE(crop.to_layout(BlobLayout::kNCHW).equals(planar.roi(1, 2, 2, 3)));
+	DataBlob32f packed(crop.shape(), BlobMemory::kHEAP, BlobInit::kZEROED, BlobLayout::kNHWC);
+	crop.copy_to(packed);
+	EXPECT_TRUE(packed.is_continuous());
+	EXPECT_TRUE(packed.equals(crop));
+}
@@ -0,0 +1,43 @@
+#include <ModelLoader.h>
+#include <gtest/gtest.h>
+
+dtrCommon::CaffeNNParams initializeNNParams();
+
+TEST(ModelLoader, LoadsConcurrently) {
+	dtrCommon::CaffeNNParams gie = initializeNNParams();
+	dtrCommon::CaffeNNParams caffe = initializeNNParams();
+	caffe.gieFileName.clear();
+	ModelLoaderParams params;
+	params.concurrency = 2;
+	ModelLoader loader(params);
+	std::vector<std::unique_ptr<CaffeModel>> models = loader.load({gie, caffe, gie});
+	ASSERT_EQ(models.size(), 3U);
+	ASSERT_EQ(loader.reports().size(), 3U);
+	for (auto& report : loader.reports()) {
+		std::cerr << report << std::endl;
+		EXPECT_TRUE(report.loaded);
+	}
+	DataBlob32f input(gie.batchSize, 3, 224, 224);
+	for (auto& model : models) {
+		ASSERT_TRUE(model != nullptr);
+		EXPECT_EQ(model->infer({input}).size(), 1U);
+	}
+	models.front()->teardown();
+}
+
+TEST(ModelLoader, FailsCleanly) {
+	dtrCommon::CaffeNNParams gie = initializeNNParams();
+	// a file that exists but is not a serialized engine
+	dtrCommon::CaffeNNParams broken = initializeNNParams();
+	broken.gieFileName = broken.prototxtFileName;
+	ModelLoaderParams params;
+	params.concurrency = 1;
+	ModelLoader loader(params);
+	std::vector<std::unique_ptr<CaffeModel>> models = loader.load({broken, gie, gie});
+	EXPECT_TRUE(models.empty());
+	ASSERT_EQ(loader.reports().size(), 3U);
+	EXPECT_FALSE(loader.reports()[0].loaded);
+	EXPECT_FALSE(loader.reports()[0].skipped);
+	EXPECT_TRUE(loader.reports()[1].skipped);
+	EXPECT_TRUE(loader.reports()[2].skipped);
+}
@@ -0,0 +1,91 @@
+#include <ModelRegistry.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <future>
+#ifdef DTR_NVINFER_STUB
+#include <StubRuntime.h>
+#endif
+
+dtrCommon::CaffeNNParams initializeNNParams();
+
+namespace {
+std::unique_ptr<CaffeModel> buildModel() {
+	std::unique_ptr<CaffeModel> model(new CaffeModel(initializeNNParams()));
+	return model->build(false) ? std::move(model) : nullptr;
+}
+}
+
+TEST(ModelRegistry, EvictsLeastRecentlyUsed) {
+	// measure one model, then allow a little less than two of them
+	ModelRegistry probe(ModelRegistryParams{});
+	ASSERT_TRUE(probe.add("probe", buildModel()));
+	size_t footprint = probe.deviceMemoryUsage();
+	ASSERT_GT(footprint, 0U);
+
+	ModelRegistryParams params;
+	params.deviceMemoryBudget = footprint * 3 / 2;
+	ModelRegistry registry(params);
+	ASSERT_TRUE(registry.add("a", buildModel()));
+	ASSERT_TRUE(registry.add("b", buildModel()));
+	EXPECT_LE(registry.deviceMemoryUsage(), params.deviceMemoryBudget);
+	EXPECT_FALSE(registry.add("b", buildModel()));
+
+	DataBlob32f input(initializeNNParams().batchSize, 3, 224, 224);
+	for (int i = 0; i < 4; ++i) {
+		std::shared_ptr<CaffeModel> model = registry.get(i % 2 ? "b" : "a");
+		ASSERT_TRUE(model != nullptr);
+		EXPECT_EQ(model->infer({input}).size(), 1U);
+		EXPECT_LE(registry.deviceMemoryUsage(), params.deviceMemoryBudget);
+	}
+	for (auto& stats : registry.stats()) {
+		std::cerr << stats << std::endl;
+		EXPECT_GE(stats.reloads, 1U);
+	}
+
+	// a model in use is never evicted, so the other one can not come back
+	std::shared_ptr<CaffeModel> held = registry.get("a");
+	EXPECT_TRUE(registry.get("b") == nullptr);
+	EXPECT_TRUE(held->isBuilt());
+	EXPECT_TRUE(registry.get("unknown") == nullptr);
+	EXPECT_TRUE(registry.remove("b"));
+	held->teardown();
+}
+
+#ifdef DTR_NVINFER_STUB
+TEST(ModelRegistry, ReloadDoesNotBlockResidentModels) {
+	ModelRegistry probe(ModelRegistryParams{});
+	ASSERT_TRUE(probe.add("probe", buildModel()));
+	ModelRegistryParams params;
+	params.deviceMemoryBudget = probe.deviceMemoryUsage() * 5 / 2;
+	ModelRegistry registry(params);
+	ASSERT_TRUE(registry.add("a", buildModel()));
+	ASSERT_TRUE(registry.add("b", buildModel()));
+	ASSERT_TRUE(registry.add("c", buildModel()));
+	std::shared_ptr<CaffeModel> resident = registry.get("c");
+	ASSERT_TRUE(resident != nullptr);
+
+	// the warmup of the reloaded model takes a while, "a" evicts "b" to come back
+	const std::chrono::milliseconds latency(300);
+	dtrStub::setKernelLatency(latency);
+	auto reload = [&registry]() { return registry.get("a"); };
+	std::future<std::shared_ptr<CaffeModel>> first = std::async(std::launch::async, reload);
+	std::future<std::shared_ptr<CaffeModel>> second = std::async(std::launch::async, reload);
+	std::this_thread::sleep_for(latency / 3);
+	auto begin = std::chrono::steady_clock::now();
+	EXPECT_TRUE(registry.get("c") == resident);
+	EXPECT_LT(std::chrono::steady_clock::now() - begin, latency / 3);
+	std::shared_ptr<CaffeModel> reloaded = first.get();
+	dtrStub::setKernelLatency(std::chrono::microseconds(0));
+	ASSERT_TRUE(reloaded != nullptr);
+	// the second get() waited for the first one instead of loading the model again
+	EXPECT_TRUE(second.get() == reloaded);
+	for (auto& stats : registry.stats()) {
+		EXPECT_EQ(stats.reloads, stats.name == "a" ? 1U : 0U) << stats;
+		EXPECT_EQ(stats.resident, stats.name != "b") << stats;
+	}
+	EXPECT_LE(registry.deviceMemoryUsage(), params.deviceMemoryBudget);
+	reloaded.reset();
+	resident.reset();
+	EXPECT_TRUE(registry.remove("a"));
+}
+#endif
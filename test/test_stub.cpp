@@ -0,0 +1,62 @@
+#ifdef DTR_NVINFER_STUB
+#include <StubRuntime.h>
+#include <common/logger.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <cuda_runtime_api.h>
+
+namespace {
+void slowCallback(cudaStream_t, cudaError_t, void* userData) {
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	static_cast<std::atomic<int>*>(userData)->store(1);
+}
+}
+
+TEST(Stub, DefaultStreamWaitsForStreams) {
+	cudaStream_t stream, nonBlocking;
+	ASSERT_EQ(cudaStreamCreate(&stream), cudaSuccess);
+	ASSERT_EQ(cudaStreamCreateWithFlags(&nonBlocking, cudaStreamNonBlocking), cudaSuccess);
+	std::atomic<int> done{0};
+
+	ASSERT_EQ(cudaStreamAddCallback(stream, slowCallback, &done, 0), cudaSuccess);
+	ASSERT_EQ(cudaDeviceSynchronize(), cudaSuccess);
+	EXPECT_EQ(done.load(), 1);
+
+	// a default stream copy runs after the work already on the blocking streams
+	int source = 7, target = 0, copy = 0;
+	done = 0;
+	ASSERT_EQ(cudaStreamAddCallback(stream, slowCallback, &done, 0), cudaSuccess);
+	ASSERT_EQ(cudaMemcpyAsync(&target, &source, sizeof(int), cudaMemcpyHostToDevice, stream), cudaSuccess);
+	ASSERT_EQ(cudaMemcpy(&copy, &target, sizeof(int), cudaMemcpyDeviceToHost), cudaSuccess);
+	EXPECT_EQ(done.load(), 1);
+	EXPECT_EQ(copy, 7);
+
+	// but not after the work on non-blocking ones, which only cudaDeviceSynchronize() waits for
+	done = 0;
+	ASSERT_EQ(cudaStreamAddCallback(nonBlocking, slowCallback, &done, 0), cudaSuccess);
+	ASSERT_EQ(cudaMemset(&copy, 0, sizeof(int)), cudaSuccess);
+	EXPECT_EQ(done.load(), 0);
+	ASSERT_EQ(cudaDeviceSynchronize(), cudaSuccess);
+	EXPECT_EQ(done.load(), 1);
+
+	ASSERT_EQ(cudaStreamDestroy(nonBlocking), cudaSuccess);
+	ASSERT_EQ(cudaStreamDestroy(stream), cudaSuccess);
+}
+
+TEST(Stub, RejectsForeignPlans) {
+	std::unique_ptr<nvinfer1::IRuntime, void (*)(nvinfer1::IRuntime*)> runtime(
+		nvinfer1::createInferRuntime(gLogger.getTRTLogger()), [](nvinfer1::IRuntime* r) { r->destroy(); });
+	const char garbage[] = "not a plan";
+	EXPECT_EQ(runtime->deserializeCudaEngine(garbage, sizeof(garbage), nullptr), nullptr);
+	std::string plan = dtrStub::makePlan({dtrStub::Binding("in", true, {2}), dtrStub::Binding("out", false, {2})}, 4);
+	nvinfer1::ICudaEngine* engine = runtime->deserializeCudaEngine(plan.data(), plan.size(), nullptr);
+	ASSERT_NE(engine, nullptr);
+	EXPECT_EQ(engine->getMaxBatchSize(), 4);
+	EXPECT_EQ(engine->getNbBindings(), 2);
+	engine->destroy();
+}
+#endif
@@ -0,0 +1,201 @@
+#include <common/typeConvert.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using dtrCommon::SimdLevel;
+
+namespace {
+uint32_t bitsOf(float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+float floatOf(uint32_t bits) {
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+std::vector<SimdLevel> levels() {
+	std::vector<SimdLevel> all;
+	for (int level = 0; level <= static_cast<int>(dtrCommon::cpuSimdLevel()); ++level) {
+		all.push_back(static_cast<SimdLevel>(level));
+	}
+	return all;
+}
+
+// floats around every rounding boundary of half, the specials and random bits, 1003 so every level has a tail
+std::vector<float> halfCandidates() {
+	std::vector<float> values = {0.0f, -0.0f, 1.0f, -2.5f, 65504.0f, 65519.99f, 65520.0f, -65520.0f, 1e10f,
+		5.9604645e-8f, 2.9802322e-8f, 2.9802326e-8f, 8.9406967e-8f, 6.1035156e-5f, 6.1031e-5f,
+		std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+		std::numeric_limits<float>::denorm_min(), floatOf(0x7fc00000), floatOf(0xff812345), floatOf(0x7f800001)};
+	for (uint32_t h = 0x400; h < 0x7c00 && values.size() < 600; h += 97) {
+		// the midpoints between neighbouring normal halves and one ulp either side
+		uint32_t mid = bitsOf(dtrCommon::halfToFloat(static_cast<uint16_t>(h))) + (1 << 12);
+		values.push_back(floatOf(mid));
+		values.push_back(floatOf(mid - 1));
+		values.push_back(-floatOf(mid + 1));
+	}
+	std::mt19937 random(7);
+	while (values.size() < 1003) {
+		values.push_back(floatOf(static_cast<uint32_t>(random())));
+	}
+	return values;
+}
+}
+
+TEST(TypeConvert, HalfToFloatIsExact) {
+	std::vector<uint16_t> halves(0x10000);
+	for (size_t h = 0; h < halves.size(); ++h) {
+		halves[h] = static_cast<uint16_t>(h);
+	}
+	EXPECT_EQ(dtrCommon::halfToFloat(0x3c00), 1.0f);
+	EXPECT_EQ(dtrCommon::halfToFloat(0xc000), -2.0f);
+	EXPECT_EQ(dtrCommon::halfToFloat(0x7bff), 65504.0f);
+	EXPECT_EQ(dtrCommon::halfToFloat(0x0001), std::ldexp(1.0f, -24));
+	EXPECT_EQ(bitsOf(dtrCommon::halfToFloat(0x8000)), 0x80000000u);
+	EXPECT_EQ(dtrCommon::halfToFloat(0xfc00), -std::numeric_limits<float>::infinity());
+	EXPECT_EQ(bitsOf(dtrCommon::halfToFloat(0x7d01)), 0x7fe02000u);
+	for (SimdLevel level : levels()) {
+		SCOPED_TRACE(dtrCommon::simdLevelName(level));
+		std::vector<float> floats(halves.size());
+		dtrCommon::halfToFloat(halves.data(), floats.data(), halves.size(), level);
+		std::vector<uint16_t> back(halves.size());
+		dtrCommon::floatToHalf(floats.data(), back.data(), floats.size(), level);
+		for (size_t h = 0; h < halves.size(); ++h) {
+			ASSERT_EQ(bitsOf(floats[h]), bitsOf(dtrCommon::halfToFloat(halves[h]))) << h;
+			// NaNs come back quiet
+			ASSERT_EQ(back[h], std::isnan(floats[h]) ? (h | 0x200) : h) << h;
+		}
+	}
+}
+
+TEST(TypeConvert, FloatToHalfRoundsToNearestEven) {
+	EXPECT_EQ(dtrCommon::floatToHalf(1.0f), 0x3c00);
+	EXPECT_EQ(dtrCommon::floatToHalf(65504.0f), 0x7bff);
+	EXPECT_EQ(dtrCommon::floatToHalf(65520.0f), 0x7c00);
+	EXPECT_EQ(dtrCommon::floatToHalf(-1e10f), 0xfc00);
+	// halfway between 1 and the next half is rounded to the even 1, halfway above that up
+	EXPECT_EQ(dtrCommon::floatToHalf(1.0f + std::ldexp(1.0f, -11)), 0x3c00);
+	EXPECT_EQ(dtrCommon::floatToHalf(1.0f + 3 * std::ldexp(1.0f, -11)), 0x3c02);
+	EXPECT_EQ(dtrCommon::floatToHalf(std::ldexp(1.0f, -25)), 0x0000);
+	EXPECT_EQ(dtrCommon::floatToHalf(std::ldexp(1.5f, -25)), 0x0001);
+	EXPECT_EQ(dtrCommon::floatToHalf(std::ldexp(3.0f, -25)), 0x0002);
+	EXPECT_EQ(dtrCommon::floatToHalf(floatOf(0xff812345)), 0xfe09);
+
+	std::vector<float> floats = halfCandidates();
+	std::vector<uint16_t> expected(floats.size());
+	for (size_t i = 0; i < floats.size(); ++i) {
+		expected[i] = dtrCommon::floatToHalf(floats[i]);
+	}
+	for (SimdLevel level : levels()) {
+		SCOPED_TRACE(dtrCommon::simdLevelName(level));
+		std::vector<uint16_t> halves(floats.size());
+		dtrCommon::floatToHalf(floats.data(), halves.data(), floats.size(), level);
+		for (size_t i = 0; i < floats.size(); ++i) {
+			ASSERT_EQ(halves[i], expected[i]) << floats[i];
+		}
+	}
+}
+
+TEST(TypeConvert, Dequantize) {
+	std::vector<int8_t> bytes(259);
+	std::vector<uint8_t> ubytes(bytes.size());
+	std::vector<int32_t> ints(bytes.size());
+	for (size_t i = 0; i < bytes.size(); ++i) {
+		bytes[i] = static_cast<int8_t>(i - 128);
+		ubytes[i] = static_cast<uint8_t>(i);
+		ints[i] = static_cast<int32_t>(i * 16777259) - (1 << 30);
+	}
+	for (SimdLevel level : levels()) {
+		SCOPED_TRACE(dtrCommon::simdLevelName(level));
+		std::vector<float> out(bytes.size());
+		dtrCommon::dequantize(bytes.data(), out.data(), bytes.size(), 1.0f, 0, level);
+		for (size_t i = 0; i < bytes.size(); ++i) {
+			ASSERT_EQ(out[i], static_cast<float>(bytes[i]));
+		}
+		dtrCommon::dequantize(ubytes.data(), out.data(), ubytes.size(), 0.05f, 128, level);
+		for (size_t i = 0; i < ubytes.size(); ++i) {
+			ASSERT_EQ(out[i], (static_cast<float>(ubytes[i]) - 128.0f) * 0.05f);
+		}
+		dtrCommon::dequantize(ints.data(), out.data(), ints.size(), 0.5f, -3, level);
+		for (size_t i = 0; i < ints.size(); ++i) {
+			ASSERT_EQ(out[i], (static_cast<float>(ints[i]) + 3.0f) * 0.5f);
+		}
+	}
+}
+
+TEST(TypeConvert, QuantizeSaturates) {
+	std::vector<float> values = {0.0f, 0.5f, 1.5f, 2.5f, -0.5f, -1.5f, 1.0f, -1.0f, 12.7f, 12.8f, -12.8f,
+		-12.9f, 1e30f, -1e30f, std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+		std::nanf("")};
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> uniform(-10.0f, 15.0f);
+	while (values.size() < 131) {
+		values.push_back(uniform(random));
+	}
+	auto round = [](float value, double lo, double hi) {
+		double rounded = std::isnan(value) ? hi : std::nearbyint(static_cast<double>(value));
+		return std::min(std::max(rounded, lo), hi);
+	};
+	for (SimdLevel level : levels()) {
+		SCOPED_TRACE(dtrCommon::simdLevelName(level));
+		std::vector<int8_t> bytes(values.size());
+		dtrCommon::quantize(values.data(), bytes.data(), values.size(), 0.1f, 0, level);
+		std::vector<uint8_t> ubytes(values.size());
+		dtrCommon::quantize(values.data(), ubytes.data(), values.size(), 0.1f, 100, level);
+		std::vector<int32_t> ints(values.size());
+		dtrCommon::quantize(values.data(), ints.data(), values.size(), 1.0f, level);
+		for (size_t i = 0; i < values.size(); ++i) {
+			float scaled = values[i] * (1.0f / 0.1f);
+			ASSERT_EQ(bytes[i], round(scaled, -128, 127)) << values[i];
+			ASSERT_EQ(ubytes[i], round(scaled, -100, 155) + 100) << values[i];
+			ASSERT_EQ(ints[i], round(values[i], -2147483648.0, 2147483520.0)) << values[i];
+		}
+		// ties go to even
+		EXPECT_EQ(ints[1], 0);
+		EXPECT_EQ(ints[2], 2);
+		EXPECT_EQ(ints[3], 2);
+		EXPECT_EQ(ints[5], -2);
+		EXPECT_EQ(ints[12], 2147483520);
+		EXPECT_EQ(ints[13], std::numeric_limits<int32_t>::min());
+		EXPECT_EQ(bytes[12], 127);
+		EXPECT_EQ(bytes[13], -128);
+		EXPECT_EQ(ubytes[13], 0);
+		EXPECT_EQ(ubytes[16], 255);
+
+		std::vector<float> restored(values.size());
+		dtrCommon::dequantize(ubytes.data(), restored.data(), ubytes.size(), 0.1f, 100, level);
+		for (size_t i = 17; i < values.size(); ++i) {
+			ASSERT_NEAR(restored[i], values[i], 0.05f + 1e-5f);
+		}
+	}
+}
+
+TEST(TypeConvert, LevelIsCappedByTheCpu) {
+	// a level past cpuSimdLevel() runs the best kernel the cpu has instead of faulting
+	std::vector<float> values = halfCandidates();
+	std::vector<uint16_t> halves(values.size()), expected(values.size());
+	dtrCommon::floatToHalf(values.data(), expected.data(), values.size(), SimdLevel::kSCALAR);
+	dtrCommon::floatToHalf(values.data(), halves.data(), values.size(), SimdLevel::kAVX512);
+	EXPECT_EQ(halves, expected);
+	std::vector<float> restored(values.size());
+	dtrCommon::halfToFloat(halves.data(), restored.data(), halves.size(), SimdLevel::kAVX512);
+	for (size_t i = 0; i < values.size(); ++i) {
+		ASSERT_EQ(bitsOf(restored[i]), bitsOf(dtrCommon::halfToFloat(halves[i]))) << i;
+	}
+	std::vector<int8_t> bytes(values.size()), expectedBytes(values.size());
+	dtrCommon::quantize(restored.data(), expectedBytes.data(), restored.size(), 1e3f, 0, SimdLevel::kSCALAR);
+	dtrCommon::quantize(restored.data(), bytes.data(), restored.size(), 1e3f, 0, SimdLevel::kAVX512);
+	EXPECT_EQ(bytes, expectedBytes);
+	dtrCommon::dequantize(bytes.data(), restored.data(), bytes.size(), 1.0f, 0, SimdLevel::kAVX512);
+	for (size_t i = 0; i < bytes.size(); ++i) {
+		ASSERT_EQ(restored[i], static_cast<float>(bytes[i]));
+	}
+}